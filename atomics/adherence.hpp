@@ -1,6 +1,8 @@
 #pragma once
 
 #include <limits>
+#include <memory>
+#include <memory_resource>
 #include <random>
 #include <vector>
 #include <string>
@@ -8,6 +10,10 @@
 #include <algorithm>
 
 #include "utils/cadmium_includes.hpp"
+#include "utils/random.hpp"
+#include "utils/arena.hpp"
+#include "utils/live_metrics.hpp"
+#include "atomics/atomic_model.hpp"
 #include "data_structures/patient.hpp"
 
 namespace cesfam {
@@ -23,13 +29,20 @@ struct AdherenceConfig {
     double mult_medio = 1.00;
     double mult_bajo = 0.80;
 
-    int max_followups = 3; // prevents infinite loops
+    int max_followups = 3; // prevents infinite loops (at most INT16_MAX: Patient::followups_done is 16 bits)
+
+    std::shared_ptr<std::pmr::memory_resource> memory;   // state containers (nullptr = heap)
+    std::shared_ptr<LiveMetrics> live;                   // RA count for external monitors (nullptr = none)
 };
 
 struct AdherenceState {
+    explicit AdherenceState(std::pmr::memory_resource* mr = nullptr) : out_DA(mr), out_RA(mr) {}
+
     double now = 0.0;
-    std::vector<Patient> out_DA;
-    std::vector<Patient> out_RA;
+    Rng rng;
+
+    state_vector<Patient> out_DA;
+    state_vector<Patient> out_RA;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const AdherenceState& s) {
@@ -40,23 +53,28 @@ inline std::ostream& operator<<(std::ostream& os, const AdherenceState& s) {
     return os;
 }
 
-class AdherenciaDecision : public cadmium::Atomic<AdherenceState> {
+class AdherenciaDecision : public AtomicModel<AdherenceState> {
   public:
     mutable cadmium::Port<Patient> In_Paciente;
     mutable cadmium::Port<Patient> Out_PacienteDA;
     mutable cadmium::Port<Patient> Out_PacienteRA;
 
     AdherenciaDecision(std::string id, AdherenceConfig cfg)
-    : cadmium::Atomic<AdherenceState>(id, AdherenceState{})
+    : AtomicModel<AdherenceState>(id, AdherenceState{})
     , cfg_(std::move(cfg))
-    , rng_(cfg_.rng_seed)
-    , uni01_(0.0, 1.0)
     {
+        state = initial_state(cfg_);
         In_Paciente = addInPort<Patient>("In_Paciente");
         Out_PacienteDA = addOutPort<Patient>("Out_PacienteDA");
         Out_PacienteRA = addOutPort<Patient>("Out_PacienteRA");
     }
 
+    /// New configuration and initial state (model reuse between replications).
+    void reset(AdherenceConfig cfg) {
+        state = initial_state(cfg);
+        cfg_ = std::move(cfg);
+    }
+
     double timeAdvance(const AdherenceState& state) const override {
         if (!state.out_DA.empty() || !state.out_RA.empty()) return 0.0;
         return std::numeric_limits<double>::infinity();
@@ -68,6 +86,7 @@ class AdherenciaDecision : public cadmium::Atomic<AdherenceState> {
     }
 
     void internalTransition(AdherenceState& state) const override {
+        if (cfg_.live) cfg_.live->add_ra(state.out_RA.size());
         state.out_DA.clear();
         state.out_RA.clear();
     }
@@ -78,7 +97,7 @@ class AdherenciaDecision : public cadmium::Atomic<AdherenceState> {
         for (auto p : In_Paciente->getBag()) {
             // Decide if patient returns to the system (DA loop) or exits (RA)
             if (p.followups_done >= cfg_.max_followups) {
-                finalize_patient(p);
+                finalize_patient(state, p);
                 state.out_RA.push_back(std::move(p));
                 continue;
             }
@@ -92,7 +111,7 @@ class AdherenciaDecision : public cadmium::Atomic<AdherenceState> {
             }
             p_return = std::clamp(p_return, 0.0, 1.0);
 
-            const double u = uni01_(rng_);
+            const double u = draw_uniform(state.rng);
             const bool returns = (u <= p_return);
 
             if (returns) {
@@ -101,19 +120,25 @@ class AdherenciaDecision : public cadmium::Atomic<AdherenceState> {
                 // state of patient will be reset by the CaseManager upon re-entry
                 state.out_DA.push_back(std::move(p));
             } else {
-                finalize_patient(p);
+                finalize_patient(state, p);
                 state.out_RA.push_back(std::move(p));
             }
         }
     }
 
   private:
-    void finalize_patient(Patient& p) const {
+    static AdherenceState initial_state(const AdherenceConfig& cfg) {
+        AdherenceState s(cfg.memory.get());
+        s.rng.seed(cfg.rng_seed);
+        return s;
+    }
+
+    void finalize_patient(AdherenceState& state, Patient& p) const {
         // Simple policy: most patients discharged; some are derived.
         double p_deriv = 0.05;
         if (p.nivel_riesgo == RiskLevel::Alto) p_deriv = 0.15;
 
-        const double u = uni01_(rng_);
+        const double u = draw_uniform(state.rng);
         if (u <= p_deriv) {
             p.estado = PatientStatus::Derivado;
             p.resultado = AttentionResult::Derivacion;
@@ -124,8 +149,6 @@ class AdherenciaDecision : public cadmium::Atomic<AdherenceState> {
     }
 
     AdherenceConfig cfg_;
-    mutable std::mt19937 rng_;
-    mutable std::uniform_real_distribution<double> uni01_;
 };
 
 } // namespace cesfam
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "utils/cadmium_includes.hpp"
+#include "utils/log_filter.hpp"
+
+namespace cesfam {
+
+/// cadmium::Atomic plus read/write access to the model state.
+///
+/// Used to snapshot a running model and to restore that snapshot into a fresh
+/// model (what-if forks), without going through the DEVS ports. It also makes
+/// the model's log records filterable (see utils/log_filter.hpp): the state is
+/// only formatted when logged, and output ports are LoggedPorts.
+///
+/// Everything a transition mutates lives in S, random number generators
+/// included (an `Rng rng` field, never a `mutable` member): transitions of
+/// different models then touch disjoint memory and can run on different
+/// threads under the parallel coordinator, and snapshots and resets carry
+/// the generators along with the rest of the state.
+template <typename S>
+class AtomicModel : public cadmium::Atomic<S>, public StateLogControl {
+  public:
+    using cadmium::Atomic<S>::Atomic;
+
+    const S& getState() const { return this->state; }
+    void setState(S s) { this->state = std::move(s); }
+
+    std::string logState() const override {
+        if (!state_logged_) return {};
+        return cadmium::Atomic<S>::logState();
+    }
+
+  protected:
+    // Hides Component::addOutPort<T> so every output port can be filtered.
+    template <typename T>
+    cadmium::Port<T> addOutPort(const std::string& id) {
+        auto port = std::make_shared<LoggedPort<T>>(id);
+        cadmium::Component::addOutPort(port);
+        return port;
+    }
+};
+
+} // namespace cesfam
@@ -1,12 +1,18 @@
 #pragma once
 
 #include <limits>
+#include <memory>
+#include <memory_resource>
 #include <random>
 #include <vector>
 #include <string>
 #include <ostream>
 
 #include "utils/cadmium_includes.hpp"
+#include "utils/random.hpp"
+#include "utils/arena.hpp"
+#include "utils/live_metrics.hpp"
+#include "atomics/atomic_model.hpp"
 #include "data_structures/patient.hpp"
 
 namespace cesfam {
@@ -14,14 +20,19 @@ namespace cesfam {
 struct CaseManagerConfig {
     unsigned rng_seed = 2;
     double consent_p_accept = 1.0;   // probability that patient is accepted into the APS process
+    std::shared_ptr<std::pmr::memory_resource> memory;   // state containers (nullptr = heap)
+    std::shared_ptr<LiveMetrics> live;                   // RC count for external monitors (nullptr = none)
 };
 
 struct CaseManagerState {
+    explicit CaseManagerState(std::pmr::memory_resource* mr = nullptr) : out_AC(mr), out_RC(mr) {}
+
     double now = 0.0;
+    Rng rng;
 
     // Pending outputs (emitted at sigma=0)
-    std::vector<Patient> out_AC;
-    std::vector<Patient> out_RC;
+    state_vector<Patient> out_AC;
+    state_vector<Patient> out_RC;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const CaseManagerState& s) {
@@ -32,7 +43,7 @@ inline std::ostream& operator<<(std::ostream& os, const CaseManagerState& s) {
     return os;
 }
 
-class GestorCasos : public cadmium::Atomic<CaseManagerState> {
+class GestorCasos : public AtomicModel<CaseManagerState> {
   public:
     // Inputs
     mutable cadmium::Port<Patient> In_paciente;
@@ -43,11 +54,10 @@ class GestorCasos : public cadmium::Atomic<CaseManagerState> {
     mutable cadmium::Port<Patient> Out_PacienteRC;
 
     GestorCasos(std::string id, CaseManagerConfig cfg)
-    : cadmium::Atomic<CaseManagerState>(id, CaseManagerState{})
+    : AtomicModel<CaseManagerState>(id, CaseManagerState{})
     , cfg_(std::move(cfg))
-    , rng_(cfg_.rng_seed)
-    , uni01_(0.0, 1.0)
     {
+        state = initial_state(cfg_);
         In_paciente = addInPort<Patient>("In_paciente");
         In_PacienteDA = addInPort<Patient>("In_PacienteDA");
 
@@ -55,6 +65,12 @@ class GestorCasos : public cadmium::Atomic<CaseManagerState> {
         Out_PacienteRC = addOutPort<Patient>("Out_PacienteRC");
     }
 
+    /// New configuration and initial state (model reuse between replications).
+    void reset(CaseManagerConfig cfg) {
+        state = initial_state(cfg);
+        cfg_ = std::move(cfg);
+    }
+
     double timeAdvance(const CaseManagerState& state) const override {
         if (!state.out_AC.empty() || !state.out_RC.empty()) return 0.0;
         return std::numeric_limits<double>::infinity();
@@ -66,6 +82,7 @@ class GestorCasos : public cadmium::Atomic<CaseManagerState> {
     }
 
     void internalTransition(CaseManagerState& state) const override {
+        if (cfg_.live) cfg_.live->add_rc(state.out_RC.size());
         // clear pending outputs
         state.out_AC.clear();
         state.out_RC.clear();
@@ -88,8 +105,6 @@ class GestorCasos : public cadmium::Atomic<CaseManagerState> {
             p.hora_llegada = state.now;
             p.hora_atencion = 0.0;
             p.hora_salida = 0.0;
-            p.tiempo_espera = 0.0;
-            p.tiempo_atencion = 0.0;
             p.medico_asignado = -1;
             p.resultado = AttentionResult::Unknown;
             p.estado = PatientStatus::EsperandoEvaluacion;
@@ -99,6 +114,12 @@ class GestorCasos : public cadmium::Atomic<CaseManagerState> {
     }
 
   private:
+    static CaseManagerState initial_state(const CaseManagerConfig& cfg) {
+        CaseManagerState s(cfg.memory.get());
+        s.rng.seed(cfg.rng_seed);
+        return s;
+    }
+
     void handle_patient(CaseManagerState& state, Patient p) const {
         // Apply Buzón APS classification if not already known.
         if (p.nivel_riesgo == RiskLevel::Unknown) {
@@ -111,7 +132,7 @@ class GestorCasos : public cadmium::Atomic<CaseManagerState> {
         p.estado = PatientStatus::EvaluadoPriorizado;
 
         // Consent/acceptance gate: if not accepted -> RC (exit)
-        const double u = uni01_(rng_);
+        const double u = draw_uniform(state.rng);
         const bool accepted = (u <= cfg_.consent_p_accept);
 
         if (!accepted) {
@@ -127,8 +148,6 @@ class GestorCasos : public cadmium::Atomic<CaseManagerState> {
     }
 
     CaseManagerConfig cfg_;
-    mutable std::mt19937 rng_;
-    mutable std::uniform_real_distribution<double> uni01_;
 };
 
 } // namespace cesfam
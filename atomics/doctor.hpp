@@ -1,14 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <memory>
+#include <memory_resource>
 #include <random>
-#include <deque>
 #include <string>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include "utils/cadmium_includes.hpp"
+#include "utils/random.hpp"
+#include "utils/arena.hpp"
+#include "utils/live_metrics.hpp"
+#include "atomics/atomic_model.hpp"
 #include "data_structures/patient.hpp"
+#include "utils/timing_wheel.hpp"
+#include "atomics/shifts.hpp"
 
 namespace cesfam {
 
@@ -16,116 +27,261 @@ struct DoctorConfig {
     int doctor_id = 0;
     unsigned rng_seed = 100;
     double service_mean = 600.0; // seconds (10 minutes)
+
+    // Reneging: each queued patient leaves after an exponential patience with
+    // this mean (0 = patients wait forever). Deadlines are rounded up to
+    // multiples of patience_tick.
+    double patience_mean = 0.0;  // seconds
+    double patience_tick = 1.0;  // seconds
+
+    // Shift calendar (structural: adds In_Turno and Out_Relevo). The doctor is
+    // on duty while its id is below the count announced on In_Turno.
+    bool shifts = false;
+    bool on_duty = true;         // at time 0
+
+    std::shared_ptr<std::pmr::memory_resource> memory;   // state containers (nullptr = heap)
+    std::shared_ptr<LiveMetrics> live;                   // queue and busy flag for external monitors (nullptr = none)
 };
 
 struct DoctorState {
+    explicit DoctorState(std::pmr::memory_resource* mr = nullptr, unsigned seed = 5489u)
+    : queue(mr), queue_timer(mr), out_abandon(mr), out_relevo(mr), rng(seed) {}
+
     double now = 0.0;
     bool busy = false;
+    bool on_duty = true;   // off duty: finishes the patient in service, takes no one else
 
-    std::deque<Patient> queue;
+    state_deque<Patient> queue;
     Patient current;
 
     double finish_time = std::numeric_limits<double>::infinity(); // absolute time when current service finishes
+
+    // Reneging (patience_mean > 0). A patient that runs out of patience stays
+    // in `queue` as a tombstone (estado Abandono) until it reaches the front,
+    // so expiring and cancelling are O(1) whatever the queue length.
+    TimingWheel wheel;
+    state_deque<TimingWheel::Handle> queue_timer;  // parallel to `queue`
+    std::uint64_t queue_head = 0;                  // sequence number of queue.front()
+    std::size_t abandoned = 0;                     // tombstones in `queue`
+    state_vector<Patient> out_abandon;             // pending output on Out_Abandono
+    state_vector<Patient> out_relevo;              // handed back to the router at the end of a shift
+
+    Rng rng;
+
+    /// Patients actually waiting (the queue without tombstones).
+    std::size_t waiting() const { return queue.size() - abandoned; }
 };
 
 inline std::ostream& operator<<(std::ostream& os, const DoctorState& s) {
     os << "DoctorState{now=" << s.now
        << ", busy=" << (s.busy ? "true" : "false")
-       << ", q=" << s.queue.size()
+       << ", q=" << s.waiting()
        << ", finish=" << s.finish_time
        << ", current_id=" << s.current.id_paciente
+       << (s.on_duty ? "" : ", off_duty")
        << "}";
     return os;
 }
 
-class Medico : public cadmium::Atomic<DoctorState> {
+class Medico : public AtomicModel<DoctorState> {
   public:
     mutable cadmium::Port<Patient> In_Paciente;
     mutable cadmium::Port<Patient> Out_Paciente;
+    mutable cadmium::Port<Patient> Out_Abandono;   // patients that left the queue unattended
+    mutable cadmium::Port<ShiftChange> In_Turno;   // shift calendar (cfg.shifts only)
+    mutable cadmium::Port<Patient> Out_Relevo;     // queue handed over when going off duty (cfg.shifts only)
 
     Medico(std::string id, DoctorConfig cfg)
-    : cadmium::Atomic<DoctorState>(id, DoctorState{})
+    : AtomicModel<DoctorState>(id, initial_state(cfg))
     , cfg_(std::move(cfg))
-    , rng_(cfg_.rng_seed)
-    , exp_(cfg_.service_mean > 0.0 ? (1.0 / cfg_.service_mean) : 1.0)
     {
+        // Only an arena needs the second initial state (see StateAllocator):
+        // each one seeds a generator, and staffs run to tens of thousands of
+        // doctors.
+        if (cfg_.memory) state = initial_state(cfg_);
         In_Paciente = addInPort<Patient>("In_Paciente");
         Out_Paciente = addOutPort<Patient>("Out_Paciente");
+        Out_Abandono = addOutPort<Patient>("Out_Abandono");
+        if (cfg_.shifts) {
+            In_Turno = addInPort<ShiftChange>("In_Turno");
+            Out_Relevo = addOutPort<Patient>("Out_Relevo");
+        }
+    }
+
+    /// New configuration and initial state (model reuse between replications).
+    /// `shifts` is structural and doesn't change.
+    void reset(DoctorConfig cfg) {
+        cfg.shifts = cfg_.shifts;
+        state = initial_state(cfg);
+        cfg_ = std::move(cfg);
     }
 
     double timeAdvance(const DoctorState& state) const override {
-        if (!state.busy) return std::numeric_limits<double>::infinity();
-        const double sigma = state.finish_time - state.now;
+        const double sigma = next_event(state) - state.now;
         return sigma < 0.0 ? 0.0 : sigma;
     }
 
     void output(const DoctorState& state) const override {
-        if (!state.busy) return;
+        for (const auto& p : state.out_abandon) Out_Abandono->addMessage(p);
+        for (const auto& p : state.out_relevo) Out_Relevo->addMessage(p);
+
+        if (!state.busy || state.finish_time > next_event(state)) return;
 
         Patient p = state.current;
         // The output is produced at finish_time (absolute)
         p.hora_salida = state.finish_time;
-        p.tiempo_atencion = p.hora_salida - p.hora_atencion;
         p.estado = PatientStatus::Finalizado; // finished doctor's attention (final decision happens later)
         Out_Paciente->addMessage(p);
     }
 
     void internalTransition(DoctorState& state) const override {
-        if (!state.busy) return;
+        const double t = next_event(state);
+        if (t == std::numeric_limits<double>::infinity()) return;
+
+        state.now = t;
+        state.out_abandon.clear();
+        state.out_relevo.clear();
+
+        if (state.busy && state.finish_time <= t) {
+            state.busy = false;
+            state.finish_time = std::numeric_limits<double>::infinity();
+            state.current = Patient{};
+        }
 
-        // Advance to finish_time
-        state.now = state.finish_time;
-        state.busy = false;
-        state.finish_time = std::numeric_limits<double>::infinity();
-        state.current = Patient{};
+        expire(state);
 
         // If patients are waiting, start next immediately
         start_if_idle(state);
+        if (cfg_.live) cfg_.live->doctor(cfg_.doctor_id, state.waiting(), state.busy);
     }
 
     void externalTransition(DoctorState& state, double e) const override {
         state.now += e;
+        if (reneging()) expire(state);
+
+        if (cfg_.shifts) {
+            for (const auto& c : In_Turno->getBag()) state.on_duty = cfg_.doctor_id < c.doctors;
+            if (!state.on_duty) hand_over(state);
+        }
 
         // Enqueue all arrivals
         for (auto p : In_Paciente->getBag()) {
+            if (!state.on_duty) {   // routed here as the shift ended: straight back
+                p.medico_asignado = cfg_.doctor_id;
+                state.out_relevo.push_back(std::move(p));
+                continue;
+            }
             state.queue.push_back(std::move(p));
+            if (reneging()) {
+                const std::uint64_t seq = state.queue_head + state.queue.size() - 1;
+                state.queue_timer.push_back(state.wheel.schedule(state.now + sample_patience(state), seq));
+            }
         }
 
         // Start service if possible
         start_if_idle(state);
+        if (cfg_.live) cfg_.live->doctor(cfg_.doctor_id, state.waiting(), state.busy);
     }
 
   private:
+    static DoctorState initial_state(const DoctorConfig& cfg) {
+        DoctorState s(cfg.memory.get(), cfg.rng_seed);
+        s.on_duty = cfg.on_duty;
+        s.wheel = TimingWheel(cfg.patience_tick);
+        return s;
+    }
+
+    bool reneging() const { return cfg_.patience_mean > 0.0; }
+
+    // Absolute time of the next internal event: end of service, a timer
+    // wheel wakeup, or now if abandonments or handovers are waiting to be sent.
+    static double next_event(const DoctorState& state) {
+        if (!state.out_abandon.empty() || !state.out_relevo.empty()) return state.now;
+        double t = state.busy ? state.finish_time : std::numeric_limits<double>::infinity();
+        if (!state.wheel.empty()) t = std::min(t, std::max(state.now, state.wheel.next_wakeup()));
+        return t;
+    }
+
+    // Moves the wheel to state.now; every expired patient becomes a tombstone
+    // and is queued for Out_Abandono.
+    void expire(DoctorState& state) const {
+        state.wheel.advance(state.now, [&](std::uint64_t seq) {
+            Patient& p = state.queue[static_cast<std::size_t>(seq - state.queue_head)];
+            Patient out = p;
+            out.medico_asignado = cfg_.doctor_id;
+            out.hora_salida = state.now;
+            out.estado = PatientStatus::Abandono;
+            state.out_abandon.push_back(out);
+
+            p.estado = PatientStatus::Abandono;
+            ++state.abandoned;
+        });
+        pop_abandoned(state);
+    }
+
+    static void pop_abandoned(DoctorState& state) {
+        while (!state.queue.empty() && state.queue.front().estado == PatientStatus::Abandono) {
+            state.queue.pop_front();
+            state.queue_timer.pop_front();
+            ++state.queue_head;
+            --state.abandoned;
+        }
+    }
+
+    // End of shift: the waiting patients go back to the router, marked with
+    // this doctor (its load under shortest_queue). Their patience timers go
+    // with them; the patience is exponential, so the next doctor drawing a
+    // fresh one changes nothing in distribution.
+    void hand_over(DoctorState& state) const {
+        for (auto h : state.queue_timer) state.wheel.cancel(h);
+        for (auto& p : state.queue) {
+            if (p.estado == PatientStatus::Abandono) continue;
+            p.medico_asignado = cfg_.doctor_id;
+            state.out_relevo.push_back(std::move(p));
+        }
+        state.queue_head += state.queue.size();
+        state.queue.clear();
+        state.queue_timer.clear();
+        state.abandoned = 0;
+    }
+
     void start_if_idle(DoctorState& state) const {
-        if (state.busy) return;
+        if (state.busy || !state.on_duty) return;
         if (state.queue.empty()) return;
 
         state.current = std::move(state.queue.front());
         state.queue.pop_front();
+        ++state.queue_head;
+        if (!state.queue_timer.empty()) {
+            state.wheel.cancel(state.queue_timer.front());
+            state.queue_timer.pop_front();
+            pop_abandoned(state);
+        }
 
         // Assign doctor and mark start of attention
         state.current.medico_asignado = cfg_.doctor_id;
         state.current.hora_atencion = state.now;
-        state.current.tiempo_espera = state.current.hora_atencion - state.current.hora_llegada;
         state.current.estado = PatientStatus::EnAtencion;
 
-        const double service = sample_service_time();
-        state.current.tiempo_atencion = service;
+        const double service = sample_service_time(state);
 
         state.busy = true;
         state.finish_time = state.now + service;
+        state.current.hora_salida = state.finish_time;
     }
 
-    double sample_service_time() const {
+    double sample_service_time(DoctorState& state) const {
         if (cfg_.service_mean <= 0.0) return 0.0;
-        double s = exp_(rng_);
+        double s = draw_exponential(state.rng, 1.0 / cfg_.service_mean);
         if (s <= 0.0) s = std::numeric_limits<double>::min();
         return s;
     }
 
+    double sample_patience(DoctorState& state) const {
+        return draw_exponential(state.rng, 1.0 / cfg_.patience_mean);
+    }
+
     DoctorConfig cfg_;
-    mutable std::mt19937 rng_;
-    mutable std::exponential_distribution<double> exp_;
 };
 
 } // namespace cesfam
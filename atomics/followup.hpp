@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "utils/cadmium_includes.hpp"
+#include "utils/random.hpp"
+#include "utils/arena.hpp"
+#include "utils/calendar_queue.hpp"
+#include "atomics/atomic_model.hpp"
+#include "data_structures/patient.hpp"
+
+namespace cesfam {
+
+struct FollowupConfig {
+    unsigned rng_seed = 4;
+
+    // A returning patient comes back delay (+ uniform jitter in [-jitter, jitter])
+    // seconds after the adherence decision, never earlier than the decision.
+    double delay = 0.0;          // seconds, 0 = returns immediately (no scheduler)
+    double jitter = 0.0;         // seconds
+
+    std::shared_ptr<std::pmr::memory_resource> memory;   // state containers (nullptr = heap)
+};
+
+struct FollowupState {
+    explicit FollowupState(std::pmr::memory_resource* mr = nullptr) : due(mr) {}
+
+    double now = 0.0;
+    Rng rng;
+
+    CalendarQueue<Patient> agenda;   // booked appointments, by time
+    state_vector<Patient> due;       // next batch to release (all at due_time)
+    double due_time = std::numeric_limits<double>::infinity();
+
+    std::size_t pending() const { return agenda.size() + due.size(); }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const FollowupState& s) {
+    os << "FollowupState{now=" << s.now
+       << ", pending=" << s.pending()
+       << ", next=" << s.due_time
+       << "}";
+    return os;
+}
+
+/// Books a follow-up appointment for every patient that returns (DA) and
+/// releases it back to the case manager when due. Appointments are held in
+/// a calendar queue, so months of pending returns cost O(1) per booking and
+/// per release.
+class AgendaControles : public AtomicModel<FollowupState> {
+  public:
+    mutable cadmium::Port<Patient> In_PacienteDA;
+    mutable cadmium::Port<Patient> Out_PacienteDA;
+
+    AgendaControles(std::string id, FollowupConfig cfg)
+    : AtomicModel<FollowupState>(id, FollowupState{})
+    , cfg_(std::move(cfg))
+    {
+        state = initial_state(cfg_);
+        In_PacienteDA = addInPort<Patient>("In_PacienteDA");
+        Out_PacienteDA = addOutPort<Patient>("Out_PacienteDA");
+    }
+
+    /// New configuration and initial state (model reuse between replications).
+    void reset(FollowupConfig cfg) {
+        state = initial_state(cfg);
+        cfg_ = std::move(cfg);
+    }
+
+    double timeAdvance(const FollowupState& state) const override {
+        if (state.due.empty()) return std::numeric_limits<double>::infinity();
+        const double sigma = state.due_time - state.now;
+        return sigma < 0.0 ? 0.0 : sigma;
+    }
+
+    void output(const FollowupState& state) const override {
+        for (const auto& p : state.due) Out_PacienteDA->addMessage(p);
+    }
+
+    void internalTransition(FollowupState& state) const override {
+        state.now = state.due_time;
+        state.due.clear();
+        state.due_time = std::numeric_limits<double>::infinity();
+        take_due(state);
+    }
+
+    void externalTransition(FollowupState& state, double e) const override {
+        state.now += e;
+
+        for (auto p : In_PacienteDA->getBag()) {
+            const double t = state.now + sample_delay(state);
+            if (t == state.due_time) {
+                state.due.push_back(std::move(p));
+                continue;
+            }
+            if (t < state.due_time) {
+                // earlier than the batch on hold: give the batch back to the agenda
+                for (auto& q : state.due) state.agenda.push(state.due_time, std::move(q));
+                state.due.clear();
+                state.due_time = std::numeric_limits<double>::infinity();
+            }
+            state.agenda.push(t, std::move(p));
+        }
+        take_due(state);
+    }
+
+  private:
+    static FollowupState initial_state(const FollowupConfig& cfg) {
+        FollowupState s(cfg.memory.get());
+        s.rng.seed(cfg.rng_seed);
+        // initial day width; the queue re-estimates it from the pending times
+        s.agenda = CalendarQueue<Patient>(std::max(1.0, cfg.delay / 64.0));
+        return s;
+    }
+
+    // Moves every appointment at the earliest agenda time into `due`.
+    static void take_due(FollowupState& state) {
+        if (!state.due.empty() || state.agenda.empty()) return;
+        state.due_time = state.agenda.top_time();
+        while (!state.agenda.empty() && state.agenda.top_time() == state.due_time) {
+            state.due.push_back(std::move(state.agenda.pop().value));
+        }
+    }
+
+    double sample_delay(FollowupState& state) const {
+        double d = cfg_.delay;
+        if (cfg_.jitter > 0.0) d += draw_uniform(state.rng, -cfg_.jitter, cfg_.jitter);
+        return d < 0.0 ? 0.0 : d;
+    }
+
+    FollowupConfig cfg_;
+};
+
+} // namespace cesfam
@@ -1,14 +1,19 @@
 #pragma once
 
 #include <limits>
+#include <memory>
 #include <random>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <ostream>
 
 #include "utils/cadmium_includes.hpp"
+#include "utils/random.hpp"
+#include "atomics/atomic_model.hpp"
 #include "data_structures/patient.hpp"
 #include "utils/csv_arrivals.hpp"
+#include "utils/arrival_stream.hpp"
 
 namespace cesfam {
 
@@ -16,8 +21,11 @@ struct GeneratorConfig {
     unsigned rng_seed = 1;
     double arrivals_rate = 0.1;            // patients per second (if using stochastic mode)
     std::string arrivals_csv_path = "";    // if non-empty, use deterministic schedule
+    std::string arrivals_stream_path = ""; // if non-empty, read arrivals live from a FIFO/file ("-" = stdin)
+    std::size_t stream_lookahead = 64;     // events buffered (and reordered) from the live feed
     int max_patients = 100;                // 0 = unlimited (only for stochastic)
     int default_age = 70;
+    int id_offset = 0;                     // added to every id (keeps ids unique across CESFAMs)
 };
 
 struct GeneratorState {
@@ -26,6 +34,8 @@ struct GeneratorState {
     int next_id = 1;
     std::size_t schedule_idx = 0;
     bool done = false;
+    ArrivalEvent feed;         // live feed mode: event emitted at `next`
+    Rng rng;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const GeneratorState& s) {
@@ -35,23 +45,45 @@ inline std::ostream& operator<<(std::ostream& os, const GeneratorState& s) {
     return os;
 }
 
-class GeneratorPacientes : public cadmium::Atomic<GeneratorState> {
+class GeneratorPacientes : public AtomicModel<GeneratorState> {
   public:
     mutable cadmium::Port<Patient> Out_pacientes;
 
     GeneratorPacientes(std::string id, GeneratorConfig cfg)
-    : cadmium::Atomic<GeneratorState>(id, initial_state(cfg))
+    : AtomicModel<GeneratorState>(id, GeneratorState{})
     , cfg_(std::move(cfg))
-    , rng_(cfg_.rng_seed)
-    , exp_(cfg_.arrivals_rate > 0.0 ? cfg_.arrivals_rate : 1.0)   // lambda
     {
         Out_pacientes = addOutPort<Patient>("Out_pacientes");
 
-        if (!cfg_.arrivals_csv_path.empty()) {
+        if (cfg_.arrivals_stream_path.empty() && !cfg_.arrivals_csv_path.empty()) {
             schedule_ = read_arrivals_csv(cfg_.arrivals_csv_path);
         }
+        state = initial_state(cfg_, schedule_);
+
+        if (!cfg_.arrivals_stream_path.empty()) {
+            stream_ = std::make_shared<ArrivalStream>(cfg_.arrivals_stream_path, cfg_.stream_lookahead);
+            pull_feed(state);
+        }
+    }
+
+    /// Takes a new configuration and goes back to the initial state, so the
+    /// same model can run another replication. The schedule is only re-read if
+    /// the CSV path changed; a live feed can't be replayed.
+    void reset(GeneratorConfig cfg) {
+        if (stream_ || !cfg.arrivals_stream_path.empty()) {
+            throw std::logic_error("GeneratorPacientes::reset: a live arrival feed can't be replayed");
+        }
+        if (cfg.arrivals_csv_path != cfg_.arrivals_csv_path) {
+            schedule_.clear();
+            if (!cfg.arrivals_csv_path.empty()) schedule_ = read_arrivals_csv(cfg.arrivals_csv_path);
+        }
+        cfg_ = std::move(cfg);
+        state = initial_state(cfg_, schedule_);
     }
 
+    /// Live feed (nullptr unless arrivals_stream_path is set).
+    const ArrivalStream* stream() const { return stream_.get(); }
+
     double timeAdvance(const GeneratorState& state) const override {
         if (state.done) return std::numeric_limits<double>::infinity();
         return std::max(0.0, state.next - state.now);
@@ -61,11 +93,14 @@ class GeneratorPacientes : public cadmium::Atomic<GeneratorState> {
         if (state.done) return;
 
         Patient p;
-        p.id_paciente = state.next_id;
+        p.id_paciente = cfg_.id_offset + state.next_id;
         p.estado = PatientStatus::Generado;
         p.hora_llegada = state.next;
 
-        if (!schedule_.empty() && state.schedule_idx < schedule_.size()) {
+        if (stream_) {
+            p.edad = state.feed.edad > 0 ? state.feed.edad : cfg_.default_age;
+            p.nivel_riesgo = state.feed.riesgo;
+        } else if (!schedule_.empty() && state.schedule_idx < schedule_.size()) {
             const auto& ev = schedule_[state.schedule_idx];
             p.edad = ev.edad > 0 ? ev.edad : cfg_.default_age;
             p.nivel_riesgo = ev.riesgo;
@@ -86,6 +121,12 @@ class GeneratorPacientes : public cadmium::Atomic<GeneratorState> {
         // prepare next event
         state.next_id += 1;
 
+        if (stream_) {
+            state.schedule_idx += 1;
+            pull_feed(state);
+            return;
+        }
+
         if (!schedule_.empty()) {
             state.schedule_idx += 1;
             if (state.schedule_idx >= schedule_.size()) {
@@ -109,7 +150,7 @@ class GeneratorPacientes : public cadmium::Atomic<GeneratorState> {
             return;
         }
 
-        double delta = exp_(rng_);
+        double delta = draw_exponential(state.rng, cfg_.arrivals_rate);
         if (delta <= 0.0) delta = std::numeric_limits<double>::min();
         state.next = state.now + delta;
     }
@@ -120,21 +161,36 @@ class GeneratorPacientes : public cadmium::Atomic<GeneratorState> {
     }
 
   private:
-    static GeneratorState initial_state(const GeneratorConfig& cfg) {
+    // Blocks until the feed yields the next event or is closed.
+    void pull_feed(GeneratorState& state) const {
+        if (stream_->next(state.feed)) {
+            state.next = std::max(state.now, state.feed.time);
+        } else {
+            state.done = true;
+            state.next = std::numeric_limits<double>::infinity();
+        }
+    }
+
+    static GeneratorState initial_state(const GeneratorConfig& cfg, const std::vector<ArrivalEvent>& schedule) {
     GeneratorState s;
     s.now = 0.0;
     s.next_id = 1;
     s.schedule_idx = 0;
     s.done = false;
+    s.rng.seed(cfg.rng_seed);
+
+    if (!cfg.arrivals_stream_path.empty()) {
+        // Live feed mode: the constructor pulls the first event.
+        return s;
+    }
 
     if (!cfg.arrivals_csv_path.empty()) {
         // Deterministic schedule mode
-        auto sch = read_arrivals_csv(cfg.arrivals_csv_path);
-        if (sch.empty()) {
+        if (schedule.empty()) {
             s.done = true;
             s.next = std::numeric_limits<double>::infinity();
         } else {
-            s.next = sch.front().time;
+            s.next = schedule.front().time;
         }
         return s;
     }
@@ -152,9 +208,8 @@ class GeneratorPacientes : public cadmium::Atomic<GeneratorState> {
 
 GeneratorConfig cfg_;
 
-    mutable std::mt19937 rng_;
-    mutable std::exponential_distribution<double> exp_;
     std::vector<ArrivalEvent> schedule_;
+    std::shared_ptr<ArrivalStream> stream_;
 };
 
 } // namespace cesfam
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <limits>
+#include <random>
+#include <deque>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <algorithm>
+
+#include "utils/cadmium_includes.hpp"
+#include "utils/random.hpp"
+#include "atomics/atomic_model.hpp"
+#include "data_structures/patient.hpp"
+
+namespace cesfam {
+
+struct HospitalConfig {
+    unsigned rng_seed = 500;
+    int servers = 4;               // specialists attending referrals in parallel
+    double service_mean = 1800.0;  // seconds
+};
+
+struct HospitalState {
+    double now = 0.0;
+
+    std::deque<Patient> queue;
+    std::vector<Patient> in_service;   // patients being attended (hora_salida = planned end)
+
+    std::vector<Patient> out_done;     // pending outputs (emitted at sigma=0)
+
+    Rng rng;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const HospitalState& s) {
+    os << "HospitalState{now=" << s.now
+       << ", q=" << s.queue.size()
+       << ", in_service=" << s.in_service.size()
+       << ", out_done=" << s.out_done.size()
+       << "}";
+    return os;
+}
+
+/// Shared referral hospital (c servers, single FIFO queue) receiving the
+/// patients derived by the CESFAMs of a regional network.
+class HospitalReferencia : public AtomicModel<HospitalState> {
+  public:
+    mutable cadmium::Port<Patient> In_Derivacion;
+    mutable cadmium::Port<Patient> Out_Paciente;
+
+    HospitalReferencia(std::string id, HospitalConfig cfg)
+    : AtomicModel<HospitalState>(id, initial_state(cfg))
+    , cfg_(std::move(cfg))
+    {
+        if (cfg_.servers <= 0) cfg_.servers = 1;
+
+        In_Derivacion = addInPort<Patient>("In_Derivacion");
+        Out_Paciente = addOutPort<Patient>("Out_Paciente");
+    }
+
+    double timeAdvance(const HospitalState& state) const override {
+        if (!state.out_done.empty()) return 0.0;
+        double next = std::numeric_limits<double>::infinity();
+        for (const auto& p : state.in_service) next = std::min(next, p.hora_salida);
+        const double sigma = next - state.now;
+        return sigma < 0.0 ? 0.0 : sigma;
+    }
+
+    void output(const HospitalState& state) const override {
+        for (const auto& p : state.out_done) Out_Paciente->addMessage(p);
+    }
+
+    void internalTransition(HospitalState& state) const override {
+        if (!state.out_done.empty()) {
+            state.out_done.clear();
+            return;
+        }
+
+        // Advance to the earliest service end and release every patient finishing now.
+        double next = std::numeric_limits<double>::infinity();
+        for (const auto& p : state.in_service) next = std::min(next, p.hora_salida);
+        state.now = next;
+
+        auto finished = std::stable_partition(state.in_service.begin(), state.in_service.end(),
+            [&](const Patient& p) { return p.hora_salida > state.now; });
+        for (auto it = finished; it != state.in_service.end(); ++it) {
+            it->estado = PatientStatus::Finalizado;
+            it->resultado = AttentionResult::Alta;
+            state.out_done.push_back(std::move(*it));
+        }
+        state.in_service.erase(finished, state.in_service.end());
+
+        start_waiting(state);
+    }
+
+    void externalTransition(HospitalState& state, double e) const override {
+        state.now += e;
+
+        for (auto p : In_Derivacion->getBag()) {
+            p.hora_llegada = state.now;
+            p.hora_atencion = 0.0;
+            p.hora_salida = 0.0;
+            p.medico_asignado = -1;
+            p.estado = PatientStatus::EnEsperaAtencion;
+            state.queue.push_back(std::move(p));
+        }
+
+        start_waiting(state);
+    }
+
+  private:
+    static HospitalState initial_state(const HospitalConfig& cfg) {
+        HospitalState s;
+        s.rng.seed(cfg.rng_seed);
+        return s;
+    }
+
+    void start_waiting(HospitalState& state) const {
+        while (!state.queue.empty() && static_cast<int>(state.in_service.size()) < cfg_.servers) {
+            Patient p = std::move(state.queue.front());
+            state.queue.pop_front();
+
+            double service = cfg_.service_mean > 0.0
+                ? draw_exponential(state.rng, 1.0 / cfg_.service_mean)
+                : 0.0;
+            if (cfg_.service_mean > 0.0 && service <= 0.0) service = std::numeric_limits<double>::min();
+
+            p.hora_atencion = state.now;
+            p.hora_salida = state.now + service;
+            p.estado = PatientStatus::EnAtencion;
+            state.in_service.push_back(std::move(p));
+        }
+    }
+
+    HospitalConfig cfg_;
+};
+
+} // namespace cesfam
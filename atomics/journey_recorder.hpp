@@ -0,0 +1,63 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <ostream>
+
+#include "utils/cadmium_includes.hpp"
+#include "atomics/atomic_model.hpp"
+#include "data_structures/patient.hpp"
+#include "utils/journey_table.hpp"
+
+namespace cesfam {
+
+struct VisitRecorderState {
+    double now = 0.0;
+    std::uint64_t rows = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const VisitRecorderState& s) {
+    os << "VisitRecorderState{now=" << s.now
+       << ", rows=" << s.rows
+       << "}";
+    return os;
+}
+
+/// Passive sink that writes every doctor visit (the patient as it leaves the
+/// adherence decision, towards DA or RA) as one row of a journey table.
+class RegistroVisitas : public AtomicModel<VisitRecorderState> {
+  public:
+    mutable cadmium::Port<Patient> In_PacienteDA;
+    mutable cadmium::Port<Patient> In_PacienteRA;
+
+    RegistroVisitas(std::string id, std::shared_ptr<JourneyWriter> writer)
+    : AtomicModel<VisitRecorderState>(id, VisitRecorderState{})
+    , writer_(std::move(writer))
+    {
+        In_PacienteDA = addInPort<Patient>("In_PacienteDA");
+        In_PacienteRA = addInPort<Patient>("In_PacienteRA");
+    }
+
+    double timeAdvance(const VisitRecorderState&) const override {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    void output(const VisitRecorderState&) const override {}
+
+    void internalTransition(VisitRecorderState&) const override {}
+
+    void externalTransition(VisitRecorderState& state, double e) const override {
+        state.now += e;
+
+        for (const auto& p : In_PacienteDA->getBag()) writer_->append(p);
+        for (const auto& p : In_PacienteRA->getBag()) writer_->append(p);
+
+        state.rows = writer_->rows();
+    }
+
+  private:
+    std::shared_ptr<JourneyWriter> writer_;
+};
+
+} // namespace cesfam
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "utils/cadmium_includes.hpp"
+#include "atomics/atomic_model.hpp"
+#include "data_structures/patient.hpp"
+
+namespace cesfam {
+
+/// In-memory record of the patients that left the model.
+/// Owned by whoever runs the simulation; the recorder atomic only appends.
+struct ExitLog {
+    std::vector<Patient> ra;   // exits after the adherence decision (alta / derivacion)
+    std::vector<Patient> rc;   // rejected at the consent gate
+    std::vector<Patient> ab;   // reneged while waiting for a doctor
+};
+
+struct RecorderState {
+    double now = 0.0;
+    std::size_t ra = 0;
+    std::size_t rc = 0;
+    std::size_t ab = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const RecorderState& s) {
+    os << "RecorderState{now=" << s.now
+       << ", ra=" << s.ra
+       << ", rc=" << s.rc
+       << ", ab=" << s.ab
+       << "}";
+    return os;
+}
+
+/// Passive sink that copies exiting patients into an ExitLog so that runners
+/// can read results in memory instead of parsing the CSV log.
+class RegistroSalidas : public AtomicModel<RecorderState> {
+  public:
+    mutable cadmium::Port<Patient> In_PacienteRA;
+    mutable cadmium::Port<Patient> In_PacienteRC;
+    mutable cadmium::Port<Patient> In_PacienteAB;
+
+    RegistroSalidas(std::string id, std::shared_ptr<ExitLog> log)
+    : AtomicModel<RecorderState>(id, RecorderState{})
+    , log_(std::move(log))
+    {
+        In_PacienteRA = addInPort<Patient>("In_PacienteRA");
+        In_PacienteRC = addInPort<Patient>("In_PacienteRC");
+        In_PacienteAB = addInPort<Patient>("In_PacienteAB");
+    }
+
+    /// Starts recording into `log` from the initial state.
+    void reset(std::shared_ptr<ExitLog> log) {
+        log_ = std::move(log);
+        state = RecorderState{};
+    }
+
+    double timeAdvance(const RecorderState&) const override {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    void output(const RecorderState&) const override {}
+
+    void internalTransition(RecorderState&) const override {}
+
+    void externalTransition(RecorderState& state, double e) const override {
+        state.now += e;
+
+        for (const auto& p : In_PacienteRA->getBag()) log_->ra.push_back(p);
+        for (const auto& p : In_PacienteRC->getBag()) log_->rc.push_back(p);
+        for (const auto& p : In_PacienteAB->getBag()) log_->ab.push_back(p);
+
+        state.ra = log_->ra.size();
+        state.rc = log_->rc.size();
+        state.ab = log_->ab.size();
+    }
+
+  private:
+    std::shared_ptr<ExitLog> log_;
+};
+
+} // namespace cesfam
@@ -1,45 +1,114 @@
 #pragma once
 
+#include <algorithm>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <ostream>
+#include <cstdint>
 
 #include "utils/cadmium_includes.hpp"
+#include "utils/arena.hpp"
+#include "atomics/atomic_model.hpp"
+#include "atomics/shifts.hpp"
 #include "data_structures/patient.hpp"
 
 namespace cesfam {
 
+enum class RoutingPolicy : std::uint8_t { RoundRobin=0, ShortestQueue };
+
+inline const char* to_string(RoutingPolicy p) {
+    switch (p) {
+        case RoutingPolicy::ShortestQueue: return "shortest_queue";
+        default: return "round_robin";
+    }
+}
+
+/// router.policy values. Throws std::invalid_argument on any other word, so a
+/// typo in a branch or sweep axis can't silently run round-robin.
+inline RoutingPolicy parse_routing_policy(const std::string& s) {
+    if (s == "round_robin") return RoutingPolicy::RoundRobin;
+    if (s == "shortest_queue" || s == "jsq") return RoutingPolicy::ShortestQueue;
+    throw std::invalid_argument("router.policy = '" + s + "': expected round_robin or shortest_queue (jsq)");
+}
+
 struct RouterConfig {
     int doctors = 3;
+    RoutingPolicy policy = RoutingPolicy::RoundRobin;
+    std::shared_ptr<std::pmr::memory_resource> memory;   // state containers (nullptr = heap)
+
+    // Shift calendar (structural: adds In_turno and In_relevo). Only doctors
+    // 0 .. on_duty-1 take patients.
+    bool shifts = false;
+    int on_duty = std::numeric_limits<int>::max();       // at time 0 (clamped to doctors)
 };
 
 struct RouterState {
+    explicit RouterState(std::pmr::memory_resource* mr = nullptr) : out_to_doc(mr), to_send(mr), load(mr), held(mr) {}
+
     double now = 0.0;
     int rr_index = 0;  // round-robin pointer
-    std::vector<std::vector<Patient>> out_to_doc;
+    int on_duty = 0;   // doctors 0 .. on_duty-1 take patients (the whole staff without a shift calendar)
+    state_vector<state_vector<Patient>> out_to_doc;
+    state_vector<int> to_send;  // doctors with patients in out_to_doc: ta/output/clear don't scan the whole staff
+    state_vector<int> load;  // patients assigned and not yet finished, per doctor (ShortestQueue)
+    state_vector<Patient> held;  // arrived while nobody was on duty
+
+    /// Queues `p` for doctor `idx` in the next output.
+    void assign(int idx, Patient p) {
+        if (out_to_doc[idx].empty()) to_send.push_back(idx);
+        out_to_doc[idx].push_back(std::move(p));
+    }
+
+    /// Assigns `p` to a doctor on duty under `policy` (needs on_duty > 0).
+    void route(RoutingPolicy policy, Patient p) {
+        const int n = on_duty;
+        int idx = rr_index % n;
+        if (policy == RoutingPolicy::ShortestQueue) {
+            // Least loaded doctor; ties broken round-robin so idle doctors share work.
+            for (int k = 1; k < n; ++k) {
+                const int j = (rr_index + k) % n;
+                if (load[j] < load[idx]) idx = j;
+            }
+        }
+        load[idx] += 1;
+        assign(idx, std::move(p));
+        rr_index = (idx + 1) % n;
+    }
 };
 
 inline std::ostream& operator<<(std::ostream& os, const RouterState& s) {
     std::size_t pending = 0;
-    for (const auto& v : s.out_to_doc) pending += v.size();
+    for (int i : s.to_send) pending += s.out_to_doc[i].size();
     os << "RouterState{now=" << s.now << ", rr=" << s.rr_index
        << ", pending=" << pending << "}";
     return os;
 }
 
-class RouterMedicos : public cadmium::Atomic<RouterState> {
+class RouterMedicos : public AtomicModel<RouterState> {
   public:
     mutable cadmium::Port<Patient> In_paciente;
+    mutable cadmium::Port<Patient> In_fin;   // doctor completions (ShortestQueue only)
+    mutable cadmium::Port<ShiftChange> In_turno;   // shift calendar (cfg.shifts only)
+    mutable cadmium::Port<Patient> In_relevo;      // queues of doctors going off duty (cfg.shifts only)
     mutable std::vector<cadmium::Port<Patient>> Out_to_doctor;
 
     RouterMedicos(std::string id, RouterConfig cfg)
-    : cadmium::Atomic<RouterState>(id, initial_state(cfg))
+    : AtomicModel<RouterState>(id, RouterState{})
     , cfg_(std::move(cfg))
     {
         if (cfg_.doctors <= 0) cfg_.doctors = 1;
+        state = initial_state(cfg_);
 
         In_paciente = addInPort<Patient>("In_paciente");
+        In_fin = addInPort<Patient>("In_fin");
+        if (cfg_.shifts) {
+            In_turno = addInPort<ShiftChange>("In_turno");
+            In_relevo = addInPort<Patient>("In_relevo");
+        }
 
         Out_to_doctor.reserve(cfg_.doctors);
         for (int i = 0; i < cfg_.doctors; ++i) {
@@ -47,15 +116,21 @@ class RouterMedicos : public cadmium::Atomic<RouterState> {
         }
     }
 
+    /// Back to the initial state (model reuse between replications). The
+    /// number of doctors, the policy and `shifts` are structural and don't
+    /// change; `on_duty` does.
+    void reset(int on_duty = std::numeric_limits<int>::max()) {
+        cfg_.on_duty = on_duty;
+        state = initial_state(cfg_);
+    }
+
     double timeAdvance(const RouterState& state) const override {
-        std::size_t pending = 0;
-        for (const auto& v : state.out_to_doc) pending += v.size();
-        if (pending > 0) return 0.0;
+        if (!state.to_send.empty()) return 0.0;
         return std::numeric_limits<double>::infinity();
     }
 
     void output(const RouterState& state) const override {
-        for (int i = 0; i < static_cast<int>(state.out_to_doc.size()); ++i) {
+        for (int i : state.to_send) {
             for (const auto& p : state.out_to_doc[i]) {
                 Out_to_doctor[i]->addMessage(p);
             }
@@ -63,26 +138,54 @@ class RouterMedicos : public cadmium::Atomic<RouterState> {
     }
 
     void internalTransition(RouterState& state) const override {
-        for (auto& v : state.out_to_doc) v.clear();
+        for (int i : state.to_send) state.out_to_doc[i].clear();
+        state.to_send.clear();
     }
 
     void externalTransition(RouterState& state, double e) const override {
         state.now += e;
 
+        for (const auto& p : In_fin->getBag()) {
+            if (p.medico_asignado >= 0 && p.medico_asignado < cfg_.doctors) {
+                state.load[p.medico_asignado] -= 1;
+            }
+        }
+
+        if (cfg_.shifts) {
+            // Only the count changes: routing below just uses the new range.
+            for (const auto& c : In_turno->getBag()) state.on_duty = std::min(c.doctors, cfg_.doctors);
+            for (auto p : In_relevo->getBag()) {
+                if (p.medico_asignado >= 0 && p.medico_asignado < cfg_.doctors) {
+                    state.load[p.medico_asignado] -= 1;
+                }
+                p.medico_asignado = -1;
+                state.held.push_back(std::move(p));
+            }
+            if (state.on_duty > 0 && !state.held.empty()) {
+                for (auto& p : state.held) state.route(cfg_.policy, std::move(p));
+                state.held.clear();
+            }
+        }
+
         for (auto p : In_paciente->getBag()) {
-            int idx = state.rr_index % cfg_.doctors;
-            state.out_to_doc[idx].push_back(std::move(p));
-            state.rr_index = (state.rr_index + 1) % cfg_.doctors;
+            if (state.on_duty == 0) {
+                state.held.push_back(std::move(p));
+                continue;
+            }
+            state.route(cfg_.policy, std::move(p));
         }
     }
 
   private:
     static RouterState initial_state(const RouterConfig& cfg) {
-        RouterState s;
+        RouterState s(cfg.memory.get());
         s.now = 0.0;
         s.rr_index = 0;
         int n = cfg.doctors <= 0 ? 1 : cfg.doctors;
-        s.out_to_doc.assign(static_cast<std::size_t>(n), {});
+        s.on_duty = std::min(std::max(cfg.on_duty, 0), n);
+        s.out_to_doc.reserve(static_cast<std::size_t>(n));
+        for (int i = 0; i < n; ++i) s.out_to_doc.emplace_back(cfg.memory.get());   // assign() would copy to the heap
+        s.load.assign(static_cast<std::size_t>(n), 0);
         return s;
     }
 
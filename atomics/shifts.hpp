@@ -0,0 +1,97 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <ostream>
+#include <utility>
+
+#include "utils/cadmium_includes.hpp"
+#include "utils/csv_shifts.hpp"
+#include "atomics/atomic_model.hpp"
+
+namespace cesfam {
+
+/// Shift change broadcast to the router and the doctors: from now on,
+/// doctors 0 .. doctors-1 are on duty.
+struct ShiftChange {
+    int doctors = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ShiftChange& c) {
+    os << "ShiftChange{doctors=" << c.doctors << "}";
+    return os;
+}
+
+struct ShiftState {
+    double now = 0.0;
+    double next_time = std::numeric_limits<double>::infinity();   // next change (absolute)
+    int next_doctors = 0;                                         // on duty from next_time
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ShiftState& s) {
+    os << "ShiftState{now=" << s.now
+       << ", next=" << s.next_time
+       << ", doctors=" << s.next_doctors
+       << "}";
+    return os;
+}
+
+/// Plays a shift calendar: at every change it tells the router and the
+/// doctors how many doctors are on duty. The staff on duty at the start is
+/// part of their initial state (ShiftCalendar::at(0)), so the first message
+/// is the first change after time 0.
+class CalendarioTurnos : public AtomicModel<ShiftState> {
+  public:
+    mutable cadmium::Port<ShiftChange> Out_turno;
+
+    CalendarioTurnos(std::string id, std::shared_ptr<const ShiftCalendar> calendar)
+    : AtomicModel<ShiftState>(id, initial_state(*calendar, 0.0))
+    , calendar_(std::move(calendar))
+    {
+        Out_turno = addOutPort<ShiftChange>("Out_turno");
+    }
+
+    /// Another calendar (or the same one) from time 0 (model reuse between
+    /// replications).
+    void reset(std::shared_ptr<const ShiftCalendar> calendar) {
+        calendar_ = std::move(calendar);
+        state = initial_state(*calendar_, 0.0);
+    }
+
+    /// The state of the calendar at time t (restoring a snapshot).
+    ShiftState state_at(double t) const { return initial_state(*calendar_, t); }
+
+    const ShiftCalendar& calendar() const { return *calendar_; }
+
+    double timeAdvance(const ShiftState& state) const override {
+        const double sigma = state.next_time - state.now;
+        return sigma < 0.0 ? 0.0 : sigma;
+    }
+
+    void output(const ShiftState& state) const override {
+        Out_turno->addMessage(ShiftChange{state.next_doctors});
+    }
+
+    void internalTransition(ShiftState& state) const override {
+        state = initial_state(*calendar_, state.next_time);
+    }
+
+    void externalTransition(ShiftState& state, double e) const override {
+        state.now += e;
+    }
+
+  private:
+    static ShiftState initial_state(const ShiftCalendar& calendar, double t) {
+        ShiftState s;
+        s.now = t;
+        const auto next = calendar.next_change(t);
+        s.next_time = next.first;
+        s.next_doctors = next.second;
+        return s;
+    }
+
+    std::shared_ptr<const ShiftCalendar> calendar_;
+};
+
+} // namespace cesfam
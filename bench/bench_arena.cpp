@@ -0,0 +1,107 @@
+// Benchmark: many short replications back to back, atomic states on the heap
+// vs in a RunArena (utils/arena.hpp), for models rebuilt every replication
+// (run_replication) and for one reused model (ReplicationRunner).
+//
+// Usage: bench_arena [replications=2000] [doctors=8] [patients=300]
+// Besides the time, counts the calls to the global operator new per
+// replication (Cadmium's own ports and names always go to the heap).
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "utils/arena.hpp"
+#include "utils/kpi.hpp"
+#include "utils/stepper.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/replication.hpp"
+
+using namespace cesfam;
+
+static std::atomic<std::size_t> g_news{0};
+
+// GCC sees malloc/free behind the replaced operators and flags the pairs
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t n) {
+    g_news.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, std::align_val_t a) {   // used by std::pmr::new_delete_resource
+    g_news.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t al = static_cast<std::size_t>(a);
+    if (void* p = std::aligned_alloc(al, (n + al - 1) / al * al)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t a) noexcept { ::operator delete(p, a); }
+
+static KpiSummary rebuilt_run(CesfamConfig cfg, double until, const std::shared_ptr<RunArena>& arena) {
+    auto exits = std::make_shared<ExitLog>();
+    cfg.exits = exits;
+    cfg.arena = arena;
+    {
+        auto model = std::make_shared<CESFAM>("CESFAM", cfg);
+        Stepper stepper(model);
+        stepper.start();
+        stepper.advance_until(until);
+        stepper.stop();
+    }
+    if (arena) arena->release();
+    return summarize(*exits);
+}
+
+template <class F>
+static void row(const std::string& name, int reps, F&& run) {
+    std::size_t patients = 0;
+    const std::size_t news = g_news.load();
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        const KpiSummary k = run(static_cast<unsigned>(r));
+        patients += k.ra + k.rc + k.abandonos;
+    }
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double allocs = static_cast<double>(g_news.load() - news) / reps;
+    std::cout << name << std::string(name.size() < 28 ? 28 - name.size() : 1, ' ') << s * 1e6 / reps
+              << " us/replication   " << allocs << " heap allocations/replication   (" << patients << " exits)\n";
+}
+
+int main(int argc, char** argv) {
+    const int reps = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const int doctors = argc > 2 ? std::atoi(argv[2]) : 8;
+    const int patients = argc > 3 ? std::atoi(argv[3]) : 300;
+
+    CesfamConfig base;
+    base.medical_staff.doctors = doctors;
+    base.medical_staff.service_mean = 600.0;
+    base.generator.arrivals_rate = 0.9 * doctors / base.medical_staff.service_mean;
+    base.generator.max_patients = patients;
+    const double until = 4.0 * patients / base.generator.arrivals_rate;
+
+    std::cout << "replications: " << reps << ", doctors: " << doctors << ", patients: " << patients << "\n";
+
+    row("rebuilt, heap", reps, [&](unsigned r) {
+        return rebuilt_run(with_seed_offset(base, r), until, nullptr);
+    });
+    auto arena = std::make_shared<RunArena>();
+    row("rebuilt, arena", reps, [&](unsigned r) {
+        return rebuilt_run(with_seed_offset(base, r), until, arena);
+    });
+    std::cout << "arena reserved: " << arena->reserved() / 1024 << " KiB\n";
+
+    ReplicationRunner heap_runner(false);
+    row("reused (runner), heap", reps, [&](unsigned r) { return heap_runner.run(with_seed_offset(base, r), until); });
+    ReplicationRunner arena_runner(true);
+    row("reused (runner), arena", reps, [&](unsigned r) { return arena_runner.run(with_seed_offset(base, r), until); });
+    return 0;
+}
@@ -0,0 +1,125 @@
+// Benchmark: EquipoMedico with hundreds of doctors, sequential vs parallel root coordinator.
+//
+// Usage: bench_equipo_medico [doctors=100,400,800] [until=28800] [threads=hardware]
+// Build with `make bench PARALLEL=1` to include the parallel runs. Every
+// parallel run must complete the same patients as the sequential one.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/cadmium_includes.hpp"
+#include "atomics/generator.hpp"
+#include "atomics/recorder.hpp"
+#include "coupled/medical_staff.hpp"
+
+// Cadmium v2 headers: support both include layouts.
+#if __has_include(<cadmium/core/simulation/root_coordinator.hpp>)
+  #include <cadmium/core/simulation/root_coordinator.hpp>
+#elif __has_include(<cadmium/simulation/root_coordinator.hpp>)
+  #include <cadmium/simulation/root_coordinator.hpp>
+#else
+  #error "Cadmium v2 root coordinator header not found. Check CADMIUM_V2_INCLUDE points to .../cadmium_v2/include"
+#endif
+
+#if defined(CESFAM_PARALLEL)
+  #if __has_include(<cadmium/core/simulation/parallel_root_coordinator.hpp>)
+    #include <cadmium/core/simulation/parallel_root_coordinator.hpp>
+  #elif __has_include(<cadmium/simulation/parallel_root_coordinator.hpp>)
+    #include <cadmium/simulation/parallel_root_coordinator.hpp>
+  #else
+    #error "Cadmium v2 parallel root coordinator header not found (PARALLEL=1 needs a Cadmium v2 with parallel execution)"
+  #endif
+#endif
+
+using namespace cesfam;
+
+class EquipoBench : public cadmium::Coupled {
+  public:
+    EquipoBench(std::string id, int doctors, std::shared_ptr<ExitLog> exits)
+    : cadmium::Coupled(id)
+    {
+        MedicalStaffConfig mcfg;
+        mcfg.doctors = doctors;
+        mcfg.service_mean = 600.0;
+
+        // ~90% utilization so every doctor keeps a queue.
+        GeneratorConfig gcfg;
+        gcfg.arrivals_rate = 0.9 * doctors / mcfg.service_mean;
+        gcfg.max_patients = 0;
+
+        auto gen = addComponent<GeneratorPacientes>("GeneratorPacientes", gcfg);
+        auto equipo = addComponent<EquipoMedico>("EquipoMedico", mcfg);
+        auto reg = addComponent<RegistroSalidas>("RegistroSalidas", std::move(exits));
+
+        addCoupling(gen->Out_pacientes, equipo->In_Paciente);
+        addCoupling(equipo->Out_Paciente, reg->In_PacienteRA);
+    }
+};
+
+// Patients completed, and their total wait (the same run gives the same sum).
+struct Completed {
+    std::size_t n = 0;
+    double wait = 0.0;
+
+    explicit Completed(const ExitLog& log) : n(log.ra.size()) {
+        for (const auto& p : log.ra) wait += p.tiempo_espera();
+    }
+    bool operator==(const Completed& o) const { return n == o.n && wait == o.wait; }
+};
+
+template <class Root, class... SimArgs>
+static double timed_run(Root& root, double until, SimArgs... sim_args) {
+    const auto t0 = std::chrono::steady_clock::now();
+    root.start();
+    root.simulate(until, sim_args...);
+    root.stop();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> sizes;
+    {
+        std::stringstream ss(argc >= 2 ? argv[1] : "100,400,800");
+        std::string item;
+        while (std::getline(ss, item, ',')) sizes.push_back(std::atoi(item.c_str()));
+    }
+    const double until = argc >= 3 ? std::stod(argv[2]) : 28800.0;
+    unsigned threads = argc >= 4 ? static_cast<unsigned>(std::stoi(argv[3])) : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    bool all_same = true;
+    for (int doctors : sizes) {
+        std::cout << "EquipoMedico benchmark: doctors=" << doctors << " until=" << until << "\n";
+
+        auto seq_exits = std::make_shared<ExitLog>();
+        auto seq_model = std::make_shared<EquipoBench>("EquipoBench", doctors, seq_exits);
+        auto seq_root = cadmium::RootCoordinator(seq_model);
+        const double seq_s = timed_run(seq_root, until);
+        const Completed seq(*seq_exits);
+        std::cout << "  sequential          : " << seq_s << " s, " << seq.n << " patients completed\n";
+
+#if defined(CESFAM_PARALLEL)
+        for (unsigned t = 2; t <= threads; t *= 2) {
+            auto par_exits = std::make_shared<ExitLog>();
+            auto par_model = std::make_shared<EquipoBench>("EquipoBench", doctors, par_exits);
+            auto par_root = cadmium::ParallelRootCoordinator(par_model);
+            const double par_s = timed_run(par_root, until, static_cast<std::size_t>(t));
+            const bool same = Completed(*par_exits) == seq;
+            all_same = all_same && same;
+            std::cout << "  parallel, " << t << " threads : " << par_s << " s (speedup "
+                      << (par_s > 0.0 ? seq_s / par_s : 0.0) << "x), " << par_exits->ra.size()
+                      << " patients completed" << (same ? " (same)" : " (DIFFERENT)") << "\n";
+        }
+#else
+        (void)threads;
+        std::cout << "  parallel            : not built (use `make bench PARALLEL=1`)\n";
+#endif
+    }
+    return all_same ? 0 : 1;
+}
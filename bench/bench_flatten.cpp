@@ -0,0 +1,74 @@
+// Benchmark: the full CESFAM with hundreds of doctors, the medical staff in
+// its own EquipoMedico coupled model vs flattened onto the CESFAM's level
+// (router.flatten).
+//
+// Usage: bench_flatten [doctors=100,400,800] [until=28800] [reps=3]
+// Both layouts run the same seeds and must give the same exits; the time is
+// the best of `reps` runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utils/kpi.hpp"
+#include "utils/stepper.hpp"
+#include "top_model/cesfam.hpp"
+
+using namespace cesfam;
+
+static double timed_run(CesfamConfig cfg, double until, KpiSummary& k) {
+    cfg.exits = std::make_shared<ExitLog>();
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+        auto model = std::make_shared<CESFAM>("CESFAM", cfg);
+        Stepper stepper(model);
+        stepper.start();
+        stepper.advance_until(until);
+        stepper.stop();
+    }
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    k = summarize(*cfg.exits);
+    return s;
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> sizes;
+    {
+        std::stringstream ss(argc > 1 ? argv[1] : "100,400,800");
+        std::string item;
+        while (std::getline(ss, item, ',')) sizes.push_back(std::atoi(item.c_str()));
+    }
+    const double until = argc > 2 ? std::atof(argv[2]) : 28800.0;
+    const int reps = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+    std::cout << "until: " << until << ", best of " << reps << "\n";
+    std::cout << "doctors   nested (s)   flattened (s)   speedup   exits\n";
+    for (int doctors : sizes) {
+        CesfamConfig cfg;
+        cfg.medical_staff.doctors = doctors;
+        cfg.medical_staff.service_mean = 600.0;
+        cfg.generator.arrivals_rate = 0.9 * doctors / cfg.medical_staff.service_mean;   // doctors ~90% busy
+        cfg.generator.max_patients = 0;
+
+        double best[2] = {1e300, 1e300};
+        KpiSummary k[2];
+        for (int r = 0; r < reps; ++r) {
+            for (int flat = 0; flat < 2; ++flat) {
+                cfg.medical_staff.flatten = flat != 0;
+                best[flat] = std::min(best[flat], timed_run(cfg, until, k[flat]));
+            }
+        }
+        const bool same = k[0].ra == k[1].ra && k[0].rc == k[1].rc && k[0].abandonos == k[1].abandonos &&
+                          k[0].wait.mean == k[1].wait.mean;
+        std::cout << doctors << std::string(doctors < 1000 ? 10 - std::to_string(doctors).size() : 1, ' ') << best[0]
+                  << "     " << best[1] << "        " << best[0] / best[1] << "x     " << k[0].ra + k[0].rc
+                  << (same ? " (same)" : " (DIFFERENT)") << "\n";
+        if (!same) return 1;
+    }
+    return 0;
+}
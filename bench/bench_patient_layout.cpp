@@ -0,0 +1,108 @@
+// Benchmark: compact Patient layout vs the previous one (stored durations, padded enums).
+//
+// Usage: bench_patient_layout [patients=1000000] [rounds=20]
+// Reports sizeof, copy bandwidth (vector copies, as on every port hop) and the
+// memory and churn of a doctor queue (std::deque, as in DoctorState::queue).
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "data_structures/patient.hpp"
+
+using namespace cesfam;
+
+// Patient as it was before the compact layout.
+struct LegacyPatient {
+    int id_paciente = -1;
+    int edad = 0;
+    RiskLevel nivel_riesgo = RiskLevel::Unknown;
+    PatientStatus estado = PatientStatus::Unknown;
+    double hora_llegada = 0.0;
+    double hora_atencion = 0.0;
+    double hora_salida = 0.0;
+    double tiempo_espera = 0.0;
+    double tiempo_atencion = 0.0;
+    int medico_asignado = -1;
+    AttentionResult resultado = AttentionResult::Unknown;
+    int followups_done = 0;
+};
+
+static std::size_t g_allocated = 0;
+static volatile long long g_sink = 0;   // keeps the measured loops from being optimized away
+
+template <class T>
+struct CountingAllocator {
+    using value_type = T;
+    CountingAllocator() = default;
+    template <class U> CountingAllocator(const CountingAllocator<U>&) {}
+    T* allocate(std::size_t n) {
+        g_allocated += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) {
+        g_allocated -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+    template <class U> bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <class U> bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+template <class T>
+static void run(const char* name, std::size_t n, int rounds) {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<T> src(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        src[i].id_paciente = static_cast<int>(i);
+        src[i].hora_llegada = static_cast<double>(i);
+    }
+
+    // Copy bandwidth
+    std::vector<T> dst(n);
+    const auto t0 = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        dst = src;
+        g_sink = g_sink + dst[static_cast<std::size_t>(r) % n].id_paciente;
+    }
+    const double copy_s = std::chrono::duration<double>(Clock::now() - t0).count();
+    const double bytes = static_cast<double>(n) * sizeof(T) * rounds;
+
+    // Queue memory and churn
+    g_allocated = 0;
+    std::deque<T, CountingAllocator<T>> queue;
+    for (std::size_t i = 0; i < n; ++i) queue.push_back(src[i]);
+    const std::size_t queue_bytes = g_allocated;
+
+    const auto t1 = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (std::size_t i = 0; i < n; ++i) {
+            T p = std::move(queue.front());
+            queue.pop_front();
+            g_sink = g_sink + p.id_paciente;
+            queue.push_back(std::move(p));
+        }
+    }
+    const double churn_s = std::chrono::duration<double>(Clock::now() - t1).count();
+
+    std::cout << "  " << name << ": sizeof=" << sizeof(T) << " B"
+              << ", copy " << bytes / copy_s / 1e9 << " GB/s (" << copy_s * 1e9 / (static_cast<double>(n) * rounds)
+              << " ns/patient)"
+              << ", deque " << static_cast<double>(queue_bytes) / static_cast<double>(n) << " B/patient"
+              << ", pop+push " << churn_s * 1e9 / (static_cast<double>(n) * rounds) << " ns\n";
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc >= 2 ? static_cast<std::size_t>(std::stoull(argv[1])) : 1000000;
+    const int rounds = argc >= 3 ? std::stoi(argv[2]) : 20;
+
+    std::cout << "Patient layout benchmark: patients=" << n << " rounds=" << rounds << "\n";
+    run<LegacyPatient>("legacy ", n, rounds);
+    run<Patient>("compact", n, rounds);
+    return 0;
+}
@@ -0,0 +1,61 @@
+// Benchmark: per-draw cost of the model random variates, scalar std::mt19937
+// draws (the default Rng) vs the block generator (make BLOCK_RNG=1).
+//
+// Usage: bench_rng [draws=50000000]
+// Uniforms are the consent / adherence draws, exponentials the inter-arrival
+// and service times. Block sizes other than CESFAM_RNG_BLOCK are shown for
+// comparison.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "utils/random.hpp"
+
+using namespace cesfam;
+
+static volatile double g_sink = 0.0;   // keeps the measured loops from being optimized away
+
+template <class F>
+static double ns_per_draw(std::size_t n, F&& draw) {
+    const auto t0 = std::chrono::steady_clock::now();
+    double acc = 0.0;
+    for (std::size_t i = 0; i < n; ++i) acc += draw();
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    g_sink = g_sink + acc;
+    return s * 1e9 / static_cast<double>(n);
+}
+
+static void row(const std::string& name, double uni, double expo) {
+    std::cout << name << std::string(name.size() < 28 ? 28 - name.size() : 1, ' ') << uni << " ns   " << expo
+              << " ns\n";
+}
+
+template <std::size_t B>
+static void block_row(std::size_t n) {
+    BasicBlockRng<B> u(1), e(1);
+    const double uni = ns_per_draw(n, [&] { return u.uniform(); });
+    const double expo = ns_per_draw(n, [&] { return e.exponential() / 0.05; });
+    row("BlockRng<" + std::to_string(B) + ">" + (B == CESFAM_RNG_BLOCK ? " (default)" : ""), uni, expo);
+}
+
+int main(int argc, char** argv) {
+    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50000000;
+
+    std::cout << "draws: " << n << "\n";
+    std::cout << "generator                   uniform      exponential\n";
+
+    {
+        std::mt19937 u(1), e(1);
+        const double uni = ns_per_draw(n, [&] { return std::uniform_real_distribution<double>(0.0, 1.0)(u); });
+        const double expo = ns_per_draw(n, [&] { return std::exponential_distribution<double>(0.05)(e); });
+        row("std::mt19937 (scalar)", uni, expo);
+    }
+    block_row<64>(n);
+    block_row<256>(n);
+    block_row<1024>(n);
+    return 0;
+}
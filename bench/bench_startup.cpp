@@ -0,0 +1,88 @@
+// Benchmark: start-up cost of the full CESFAM with a very large medical
+// staff. Times separately building the model, building the coordinator tree
+// (RootCoordinator), root.start(), a short run and tearing everything down.
+//
+// Usage: bench_startup [doctors=1000,10000,50000] [until=600]
+// Per-doctor figures are the phase time divided by the staff size: flat
+// columns mean linear cost.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utils/cadmium_includes.hpp"
+#include "top_model/cesfam.hpp"
+
+// Cadmium v2 headers: support both include layouts.
+#if __has_include(<cadmium/core/simulation/root_coordinator.hpp>)
+  #include <cadmium/core/simulation/root_coordinator.hpp>
+#elif __has_include(<cadmium/simulation/root_coordinator.hpp>)
+  #include <cadmium/simulation/root_coordinator.hpp>
+#else
+  #error "Cadmium v2 root coordinator header not found. Check CADMIUM_V2_INCLUDE points to .../cadmium_v2/include"
+#endif
+
+using namespace cesfam;
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point& t) {
+    const auto now = Clock::now();
+    const double s = std::chrono::duration<double>(now - t).count();
+    t = now;
+    return s;
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> sizes;
+    {
+        std::stringstream ss(argc > 1 ? argv[1] : "1000,10000,50000");
+        std::string item;
+        while (std::getline(ss, item, ',')) sizes.push_back(std::atoi(item.c_str()));
+    }
+    const double until = argc > 2 ? std::atof(argv[2]) : 600.0;
+
+    std::cout << "until: " << until << " s; times in ms (us per doctor)\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "doctors       build            coordinator      start            run              teardown\n";
+    for (int doctors : sizes) {
+        CesfamConfig cfg;
+        cfg.medical_staff.doctors = doctors;
+        cfg.medical_staff.service_mean = 600.0;
+        cfg.generator.arrivals_rate = 0.9 * doctors / cfg.medical_staff.service_mean;   // doctors ~90% busy
+        cfg.generator.max_patients = 0;
+        cfg.exits = std::make_shared<ExitLog>();
+
+        double t[5];
+        auto t0 = Clock::now();
+        {
+            auto model = std::make_shared<CESFAM>("CESFAM", cfg);
+            t[0] = since(t0);
+            {
+                auto root = cadmium::RootCoordinator(model);
+                t[1] = since(t0);
+                root.start();
+                t[2] = since(t0);
+                root.simulate(until);
+                root.stop();
+                t[3] = since(t0);
+            }
+            model.reset();
+        }
+        t[4] = since(t0);
+
+        std::cout << std::left << std::setw(8) << doctors << std::right;
+        for (double s : t) {
+            std::ostringstream cell;
+            cell << std::fixed << std::setprecision(2) << s * 1e3 << " (" << s * 1e6 / doctors << ")";
+            std::cout << "  " << std::left << std::setw(15) << cell.str() << std::right;
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
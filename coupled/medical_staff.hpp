@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
@@ -8,6 +10,7 @@
 #include "data_structures/patient.hpp"
 #include "atomics/router.hpp"
 #include "atomics/doctor.hpp"
+#include "atomics/shifts.hpp"
 
 namespace cesfam {
 
@@ -15,50 +18,167 @@ struct MedicalStaffConfig {
     int doctors = 3;
     double service_mean = 600.0;       // seconds
     unsigned rng_seed_base = 1000;     // base seed for doctors
+    RoutingPolicy routing = RoutingPolicy::RoundRobin;
+    double patience_mean = 0.0;        // seconds, 0 = no reneging
+    double patience_tick = 1.0;        // resolution of the patience deadlines
+    bool flatten = false;              // CESFAM only: router and doctors on the CESFAM's own level (structural)
+
+    // Shift calendar (nullptr = the whole staff on duty all run). With one,
+    // the staff is its largest count and `doctors` is ignored; whether there
+    // is one is structural, the calendar itself isn't.
+    std::shared_ptr<const ShiftCalendar> shifts;
+
+    // Memory of the router and doctor states (nullptr = heap). Structural:
+    // reset() keeps the one the staff was built with.
+    std::shared_ptr<std::pmr::memory_resource> memory;
+
+    // Live metrics segment the doctors publish to (nullptr = none). Kept by
+    // reset() like `memory`.
+    std::shared_ptr<LiveMetrics> live;
+};
+
+/// The router and doctors of a medical staff with the couplings among them
+/// (router -> doctor, the completion feedback under shortest_queue, and the
+/// shift calendar with the doctors' handovers), added to a coupled model.
+/// EquipoMedico puts them on its own level behind its ports; a flattened
+/// CESFAM (router.flatten) adds them to its own level and couples the doctors
+/// straight to the rest of the model.
+class StaffComponents {
+  public:
+    void build(cadmium::Coupled& parent, MedicalStaffConfig cfg) {
+        cfg_ = std::move(cfg);
+        cfg_.doctors = roster_size(cfg_);
+
+        // Router
+        router_ = parent.addComponent<RouterMedicos>("RouterMedicos", router_config());
+
+        // Doctors
+        doctors_.reserve(cfg_.doctors);
+        for (int i = 0; i < cfg_.doctors; ++i) {
+            auto doc = parent.addComponent<Medico>("Medico_" + std::to_string(i), doctor_config(i));
+            doctors_.push_back(doc);
+
+            // IC: router -> doctor
+            parent.addCoupling(router_->Out_to_doctor[i], doc->In_Paciente);
+
+            // IC: doctor -> router (completion feedback for load-aware routing)
+            if (cfg_.routing == RoutingPolicy::ShortestQueue) {
+                parent.addCoupling(doc->Out_Paciente, router_->In_fin);
+                parent.addCoupling(doc->Out_Abandono, router_->In_fin);
+            }
+
+            // IC: doctor -> router (queue handed over at the end of a shift)
+            if (cfg_.shifts) parent.addCoupling(doc->Out_Relevo, router_->In_relevo);
+        }
+
+        // Shift calendar -> router and every doctor
+        if (cfg_.shifts) {
+            calendar_ = parent.addComponent<CalendarioTurnos>("CalendarioTurnos", cfg_.shifts);
+            parent.addCoupling(calendar_->Out_turno, router_->In_turno);
+            for (const auto& doc : doctors_) parent.addCoupling(calendar_->Out_turno, doc->In_Turno);
+        }
+    }
+
+    /// Same staff with new service parameters, every atomic back to its initial
+    /// state. `cfg` must have the same number of doctors, routing policy,
+    /// layout and use of a shift calendar (they define the couplings).
+    void reset(const MedicalStaffConfig& cfg) {
+        if (!same_structure(cfg)) {
+            throw std::invalid_argument("StaffComponents::reset: staff size, routing policy, layout and shifts can't change");
+        }
+        cfg_.service_mean = cfg.service_mean;
+        cfg_.rng_seed_base = cfg.rng_seed_base;
+        cfg_.patience_mean = cfg.patience_mean;
+        cfg_.patience_tick = cfg.patience_tick;
+        cfg_.shifts = cfg.shifts;
+
+        router_->reset(router_config().on_duty);
+        for (int i = 0; i < cfg_.doctors; ++i) doctors_[i]->reset(doctor_config(i));
+        if (calendar_) calendar_->reset(cfg_.shifts);
+    }
+
+    bool same_structure(const MedicalStaffConfig& cfg) const {
+        return roster_size(cfg) == cfg_.doctors && cfg.routing == cfg_.routing && cfg.flatten == cfg_.flatten
+            && static_cast<bool>(cfg.shifts) == static_cast<bool>(cfg_.shifts);
+    }
+
+    /// Doctors built: the largest count of the shift calendar, or `doctors`.
+    static int roster_size(const MedicalStaffConfig& cfg) {
+        const int n = cfg.shifts ? cfg.shifts->max_doctors() : cfg.doctors;
+        return n <= 0 ? 1 : n;
+    }
+
+    const MedicalStaffConfig& config() const { return cfg_; }
+    const std::shared_ptr<RouterMedicos>& router() const { return router_; }
+    const std::vector<std::shared_ptr<Medico>>& doctors() const { return doctors_; }
+    /// nullptr without a shift calendar.
+    const std::shared_ptr<CalendarioTurnos>& calendar() const { return calendar_; }
+
+  private:
+    RouterConfig router_config() const {
+        RouterConfig rc;
+        rc.doctors = cfg_.doctors;
+        rc.policy = cfg_.routing;
+        rc.memory = cfg_.memory;
+        rc.shifts = static_cast<bool>(cfg_.shifts);
+        rc.on_duty = cfg_.shifts ? cfg_.shifts->at(0.0) : cfg_.doctors;
+        return rc;
+    }
+
+    DoctorConfig doctor_config(int i) const {
+        DoctorConfig dc;
+        dc.doctor_id = i;
+        dc.rng_seed = cfg_.rng_seed_base + static_cast<unsigned>(i);
+        dc.service_mean = cfg_.service_mean;
+        dc.patience_mean = cfg_.patience_mean;
+        dc.patience_tick = cfg_.patience_tick;
+        dc.shifts = static_cast<bool>(cfg_.shifts);
+        dc.on_duty = !cfg_.shifts || i < cfg_.shifts->at(0.0);
+        dc.memory = cfg_.memory;
+        dc.live = cfg_.live;
+        return dc;
+    }
+
+    MedicalStaffConfig cfg_;
+    std::shared_ptr<RouterMedicos> router_;
+    std::vector<std::shared_ptr<Medico>> doctors_;
+    std::shared_ptr<CalendarioTurnos> calendar_;
 };
 
 class EquipoMedico : public cadmium::Coupled {
   public:
     cadmium::Port<Patient> In_Paciente;
     cadmium::Port<Patient> Out_Paciente;
+    cadmium::Port<Patient> Out_Abandono;
 
     EquipoMedico(std::string id, MedicalStaffConfig cfg)
     : cadmium::Coupled(id)
-    , cfg_(std::move(cfg))
     {
-        if (cfg_.doctors <= 0) cfg_.doctors = 1;
-
         In_Paciente = addInPort<Patient>("In_Paciente");
         Out_Paciente = addOutPort<Patient>("Out_Paciente");
+        Out_Abandono = addOutPort<Patient>("Out_Abandono");
 
-        // Router
-        auto router = addComponent<RouterMedicos>("RouterMedicos", RouterConfig{cfg_.doctors});
-
-        // Doctors
-        doctors_.reserve(cfg_.doctors);
-        for (int i = 0; i < cfg_.doctors; ++i) {
-            DoctorConfig dc;
-            dc.doctor_id = i;
-            dc.rng_seed = cfg_.rng_seed_base + static_cast<unsigned>(i);
-            dc.service_mean = cfg_.service_mean;
-
-            auto doc = addComponent<Medico>("Medico_" + std::to_string(i), dc);
-            doctors_.push_back(doc);
+        staff_.build(*this, std::move(cfg));
 
-            // IC: router -> doctor
-            addCoupling(router->Out_to_doctor[i], doc->In_Paciente);
-
-            // EOC: doctor -> out
+        // EOC: doctor -> out
+        for (const auto& doc : staff_.doctors()) {
             addCoupling(doc->Out_Paciente, Out_Paciente);
+            addCoupling(doc->Out_Abandono, Out_Abandono);
         }
 
         // EIC: in -> router
-        addCoupling(In_Paciente, router->In_paciente);
+        addCoupling(In_Paciente, staff_.router()->In_paciente);
     }
 
+    void reset(const MedicalStaffConfig& cfg) { staff_.reset(cfg); }
+
+    const StaffComponents& staff() const { return staff_; }
+    const MedicalStaffConfig& config() const { return staff_.config(); }
+    const std::shared_ptr<RouterMedicos>& router() const { return staff_.router(); }
+    const std::vector<std::shared_ptr<Medico>>& doctors() const { return staff_.doctors(); }
+
   private:
-    MedicalStaffConfig cfg_;
-    std::vector<std::shared_ptr<Medico>> doctors_;
+    StaffComponents staff_;
 };
 
 } // namespace cesfam
@@ -15,7 +15,8 @@ enum class PatientStatus : std::uint8_t {
     EnEsperaAtencion,
     EnAtencion,
     Finalizado,
-    Derivado
+    Derivado,
+    Abandono            // left the doctor queue after running out of patience
 };
 enum class AttentionResult : std::uint8_t { Unknown=0, Alta, Derivacion, Seguimiento };
 
@@ -36,6 +37,7 @@ inline const char* to_string(PatientStatus s) {
         case PatientStatus::EnAtencion: return "en_atencion";
         case PatientStatus::Finalizado: return "finalizado";
         case PatientStatus::Derivado: return "derivado";
+        case PatientStatus::Abandono: return "abandono";
         default: return "unknown";
     }
 }
@@ -48,37 +50,60 @@ inline const char* to_string(AttentionResult r) {
     }
 }
 
+#if defined(CESFAM_PATIENT_ID64)
+using PatientId = std::int64_t;
+#else
+using PatientId = std::int32_t;   // build with -DCESFAM_PATIENT_ID64 for > 2^31 patients (e.g. big regions)
+#endif
+
 /// Message that travels through the DEVS network (Patient).
 /// Fields align with the thesis "Diccionario de datos del paciente simulado"
 /// (id_paciente, nivel_riesgo, estado, hora_llegada, hora_atencion, tiempo_espera,
 /// tiempo_atencion, medico_asignado, resultado). Additional fields are included
 /// for simulation control (e.g., followups_done).
+///
+/// Patients are copied on every port hop and sit in every doctor queue, so
+/// the layout is kept compact (40 bytes with a 32-bit id): doubles first,
+/// then the integers and the 1-byte enums with no padding in between.
+/// tiempo_espera and tiempo_atencion are derived from the timestamps.
 struct Patient {
-    int id_paciente = -1;
+    // Times are "simulation seconds since t0"
+    double hora_llegada = 0.0;   // arrival time
+    double hora_atencion = 0.0;  // time when medical attention starts (0 = not started)
+    double hora_salida = 0.0;    // (extra) time when attention ends (planned end while in service; 0 = not started)
+
+    PatientId id_paciente = -1;
+    std::int32_t medico_asignado = -1;
 
     // Domain / triage
-    int edad = 0;
+    std::int16_t edad = 0;
+
+    // (extra) how many times the patient has returned for follow-up (DA loop)
+    std::int16_t followups_done = 0;
+
     RiskLevel nivel_riesgo = RiskLevel::Unknown;
 
     // DEVS lifecycle
     PatientStatus estado = PatientStatus::Unknown;
 
-    // Times are "simulation seconds since t0"
-    double hora_llegada = 0.0;   // arrival time
-    double hora_atencion = 0.0;  // time when medical attention starts
-    double hora_salida = 0.0;    // (extra) time when attention ends / leaves doctor
-
-    // Durations in seconds
-    double tiempo_espera = 0.0;
-    double tiempo_atencion = 0.0;
-
-    int medico_asignado = -1;
     AttentionResult resultado = AttentionResult::Unknown;
 
-    // (extra) how many times the patient has returned for follow-up (DA loop)
-    int followups_done = 0;
+    // Durations in seconds (a patient that reneged waited until hora_salida
+    // and was never attended)
+    double tiempo_espera() const {
+        if (estado == PatientStatus::Abandono) return hora_salida - hora_llegada;
+        return hora_atencion != 0.0 ? hora_atencion - hora_llegada : 0.0;
+    }
+    double tiempo_atencion() const {
+        if (estado == PatientStatus::Abandono) return 0.0;
+        return hora_salida != 0.0 ? hora_salida - hora_atencion : 0.0;
+    }
 };
 
+#if !defined(CESFAM_PATIENT_ID64)
+static_assert(sizeof(Patient) == 40, "Patient layout grew: keep doubles first and small fields packed");
+#endif
+
 inline std::ostream& operator<<(std::ostream& os, const Patient& p) {
     os << "Patient{id=" << p.id_paciente
        << ", edad=" << p.edad
@@ -87,8 +112,8 @@ inline std::ostream& operator<<(std::ostream& os, const Patient& p) {
        << ", llegada=" << p.hora_llegada
        << ", atencion=" << p.hora_atencion
        << ", salida=" << p.hora_salida
-       << ", espera_s=" << p.tiempo_espera
-       << ", atencion_s=" << p.tiempo_atencion
+       << ", espera_s=" << p.tiempo_espera()
+       << ", atencion_s=" << p.tiempo_atencion()
        << ", medico=" << p.medico_asignado
        << ", resultado=" << to_string(p.resultado)
        << ", followups=" << p.followups_done
@@ -0,0 +1,1136 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "atomics/doctor.hpp"
+#include "atomics/router.hpp"
+#include "atomics/case_manager.hpp"
+#include "atomics/adherence.hpp"
+#include "atomics/followup.hpp"
+#include "data_structures/patient.hpp"
+#include "utils/arena.hpp"
+#include "utils/arrival_stream.hpp"
+#include "utils/calendar_queue.hpp"
+#include "utils/divergence.hpp"
+#include "utils/journey_table.hpp"
+#include "utils/kriging.hpp"
+#include "utils/random.hpp"
+#include "utils/timing_wheel.hpp"
+#include "test/transition_driver.hpp"
+
+// Property tests of the atomics, driven transition by transition (no
+// coordinator, no logger). Every case runs a random script per seed; a
+// failing check prints its location and the program exits with status 1.
+
+using namespace cesfam;
+using cesfam::testing::TransitionDriver;
+
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+std::size_t g_transitions = 0;
+
+Patient make_patient(int id, double t, RiskLevel r = RiskLevel::Unknown, int edad = 70) {
+    Patient p;
+    p.id_paciente = id;
+    p.hora_llegada = t;
+    p.nivel_riesgo = r;
+    p.edad = static_cast<std::int16_t>(edad);
+    return p;
+}
+
+// The atomics rebuild absolute time as now += e, so times agree up to rounding.
+bool near(double a, double b) {
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(b));
+}
+
+RiskLevel random_risk(std::mt19937_64& rng) {
+    return static_cast<RiskLevel>(std::uniform_int_distribution<int>(0, 3)(rng));
+}
+
+// ---------------------------------------------------------------------------
+// Medico: FIFO single server.
+// ---------------------------------------------------------------------------
+void test_medico(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    const double means[] = {0.0, 1.0, 50.0};
+
+    DoctorConfig dc;
+    dc.doctor_id = static_cast<int>(seed % 7);
+    dc.rng_seed = static_cast<unsigned>(seed);
+    dc.service_mean = means[seed % 3];
+    auto doc = std::make_shared<Medico>("Medico", dc);
+    TransitionDriver<Medico> drv(doc);
+
+    const int arrivals = 200;
+    int injected = 0;
+    double t = 0.0;
+    std::vector<Patient> out;
+
+    auto check_state = [&]() {
+        const DoctorState& s = drv.state();
+        const std::size_t outstanding = s.queue.size() + (s.busy ? 1 : 0);
+        CESFAM_CHECK(static_cast<std::size_t>(injected) == out.size() + outstanding);
+        CESFAM_CHECK(s.busy || s.queue.empty());    // work conserving
+        if (s.busy) {
+            CESFAM_CHECK(s.finish_time >= s.now);
+            CESFAM_CHECK(s.current.hora_salida == s.finish_time);
+            CESFAM_CHECK(s.current.hora_atencion <= s.now);
+            CESFAM_CHECK(s.current.medico_asignado == dc.doctor_id);
+            CESFAM_CHECK(s.current.estado == PatientStatus::EnAtencion);
+        } else {
+            CESFAM_CHECK(drv.time_next() == kInf);
+        }
+    };
+
+    while (injected < arrivals) {
+        // next arrival: sometimes exactly at the next internal event (confluent)
+        const double tn = drv.time_next();
+        if (tn < kInf && std::uniform_int_distribution<int>(0, 9)(rng) == 0) {
+            t = tn;
+        } else {
+            t += std::exponential_distribution<double>(1.0 / 40.0)(rng);
+        }
+
+        drv.run_until(t, false);
+        for (auto& p : drv.take(doc->Out_Paciente)) out.push_back(p);
+        check_state();
+
+        const int bag = std::uniform_int_distribution<int>(1, 3)(rng);
+        for (int b = 0; b < bag && injected < arrivals; ++b) {
+            drv.inject(doc->In_Paciente, make_patient(injected++, t));
+        }
+        drv.external(t);
+        for (auto& p : drv.take(doc->Out_Paciente)) out.push_back(p);
+        check_state();
+    }
+    drv.run_until(kInf);
+    for (auto& p : drv.take(doc->Out_Paciente)) out.push_back(p);
+    check_state();
+    g_transitions += drv.transitions();
+
+    // FIFO single server: start_k = max(arrival_k, end_{k-1})
+    CESFAM_CHECK(out.size() == static_cast<std::size_t>(arrivals));
+    double prev_end = 0.0;
+    for (std::size_t k = 0; k < out.size(); ++k) {
+        const Patient& p = out[k];
+        CESFAM_CHECK(p.id_paciente == static_cast<PatientId>(k));
+        CESFAM_CHECK(near(p.hora_atencion, std::max(p.hora_llegada, prev_end)));
+        CESFAM_CHECK(p.hora_salida >= p.hora_atencion);
+        CESFAM_CHECK(p.estado == PatientStatus::Finalizado);
+        CESFAM_CHECK(p.medico_asignado == dc.doctor_id);
+        prev_end = p.hora_salida;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TimingWheel against an ordered map: same expiries, in tick order, and
+// cancelled timers never fire. Deadlines span every level of the wheel.
+// ---------------------------------------------------------------------------
+void test_timing_wheel(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    const double tick = (seed % 2) ? 1.0 : 0.25;
+    TimingWheel wheel(tick);
+    std::multimap<double, std::uint64_t> ref;         // fire time -> key
+    std::map<std::uint64_t, TimingWheel::Handle> live;
+    std::map<std::uint64_t, double> fire_at;
+
+    double now = 0.0;
+    std::uint64_t next_key = 0;
+    for (int step = 0; step < 3000; ++step) {
+        const int op = std::uniform_int_distribution<int>(0, 9)(rng);
+        if (op < 5) {
+            const double scale = std::pow(256.0, std::uniform_int_distribution<int>(0, 3)(rng)) * tick;
+            const double deadline = now + std::uniform_real_distribution<double>(0.0, 4.0 * scale)(rng);
+            const std::uint64_t key = next_key++;
+            live[key] = wheel.schedule(deadline, key);
+            const double ft = std::max(std::ceil(deadline / tick), std::floor(now / tick) + 1.0) * tick;
+            fire_at[key] = ft;
+            ref.emplace(ft, key);
+        } else if (op < 7 && !live.empty()) {
+            auto it = live.begin();
+            std::advance(it, std::uniform_int_distribution<std::size_t>(0, live.size() - 1)(rng));
+            CESFAM_CHECK(wheel.cancel(it->second));
+            CESFAM_CHECK(!wheel.cancel(it->second));
+            fire_at.erase(it->first);
+            live.erase(it);
+        } else {
+            // jump to the next wakeup or to a random later time
+            double t = now + std::exponential_distribution<double>(1.0 / (64.0 * tick))(rng);
+            if (op == 9 && !wheel.empty()) t = std::max(now, wheel.next_wakeup());
+            double last = -1.0;
+            wheel.advance(t, [&](std::uint64_t key) {
+                auto it = fire_at.find(key);
+                if (!CESFAM_CHECK(it != fire_at.end())) return;
+                CESFAM_CHECK(it->second <= std::floor(t / tick) * tick + 1e-9);
+                CESFAM_CHECK(it->second >= last);
+                last = it->second;
+                fire_at.erase(it);
+                live.erase(key);
+            });
+            now = t;
+            // nothing due is left behind
+            for (const auto& kv : fire_at) CESFAM_CHECK(kv.second > std::floor(now / tick) * tick + 1e-9);
+        }
+        CESFAM_CHECK(wheel.size() == live.size());
+        if (!fire_at.empty()) {
+            double first = kInf;
+            for (const auto& kv : fire_at) first = std::min(first, kv.second);
+            CESFAM_CHECK(wheel.next_wakeup() <= first + 1e-9);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// BlockRng: the vectorizable log is within 1 ulp of std::log, streams repeat
+// for a seed, and the variates have the right range and first moments.
+// ---------------------------------------------------------------------------
+void test_block_rng() {
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 200000; ++i) {
+        // uniform mantissa and exponent over (0, 1]
+        const double x = std::ldexp(std::uniform_real_distribution<double>(1.0, 2.0)(rng),
+                                    -std::uniform_int_distribution<int>(1, 60)(rng));
+        const double ref = std::log(x);
+        CESFAM_CHECK(std::abs(detail::log_unit(x) - ref) <= 1.5 * std::abs(std::nextafter(ref, 0.0) - ref));
+    }
+    CESFAM_CHECK(detail::log_unit(1.0) == 0.0);
+
+    BlockRng a(42), b(42);
+    for (int i = 0; i < 5000; ++i) {
+        CESFAM_CHECK(a.uniform() == b.uniform());
+        CESFAM_CHECK(a.exponential() == b.exponential());
+    }
+    a.seed(42);
+    BlockRng c(42);
+    CESFAM_CHECK(a.exponential() == c.exponential());
+
+    const int n = 1000000;
+    double su = 0.0, se = 0.0, se2 = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const double u = a.uniform();
+        const double e = a.exponential();
+        CESFAM_CHECK(u >= 0.0 && u < 1.0);
+        CESFAM_CHECK(e >= 0.0);
+        su += u;
+        se += e;
+        se2 += e * e;
+    }
+    // 5 standard errors
+    CESFAM_CHECK(std::abs(su / n - 0.5) <= 5.0 * std::sqrt(1.0 / 12.0 / n));
+    CESFAM_CHECK(std::abs(se / n - 1.0) <= 5.0 / std::sqrt(n));
+    CESFAM_CHECK(std::abs(se2 / n - 2.0) <= 5.0 * std::sqrt(20.0 / n));
+}
+
+// ---------------------------------------------------------------------------
+// CalendarQueue against an ordered map through growth, bursts of equal times
+// and draining (which exercises the resizes and the direct search).
+// ---------------------------------------------------------------------------
+void test_calendar_queue(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    CalendarQueue<int> q(1.0);
+    std::multimap<std::pair<double, int>, int> ref;   // (time, insertion) -> value
+    double now = 0.0;
+    int inserted = 0;
+
+    auto pop_one = [&]() {
+        const auto it = ref.begin();
+        CESFAM_CHECK(q.top_time() == it->first.first);
+        const auto e = q.pop();
+        CESFAM_CHECK(e.time == it->first.first);
+        CESFAM_CHECK(e.value == it->second);
+        now = e.time;
+        ref.erase(it);
+    };
+
+    for (int phase = 0; phase < 3; ++phase) {
+        const int ops = 20000;
+        for (int k = 0; k < ops; ++k) {
+            // phase 0 grows, phase 1 is steady, phase 2 drains
+            const int grow = phase == 0 ? 3 : (phase == 1 ? 1 : 0);
+            const int op = std::uniform_int_distribution<int>(0, grow + 1)(rng);
+            if (op < grow || ref.empty()) {
+                double t = now + std::exponential_distribution<double>(1.0 / 86400.0)(rng);
+                if (!ref.empty() && std::uniform_int_distribution<int>(0, 9)(rng) == 0) {
+                    t = std::max(now, ref.rbegin()->first.first);   // tie with a pending time
+                } else if (std::uniform_int_distribution<int>(0, 19)(rng) == 0) {
+                    t = std::max(0.0, now - 3600.0);                   // put back before the last pop
+                }
+                q.push(t, inserted);
+                ref.emplace(std::make_pair(t, inserted), inserted);
+                ++inserted;
+            } else {
+                pop_one();
+            }
+            CESFAM_CHECK(q.size() == ref.size());
+            CESFAM_CHECK(q.size() <= 2 * q.buckets());
+        }
+    }
+    while (!ref.empty()) pop_one();
+    CESFAM_CHECK(q.empty());
+}
+
+// ---------------------------------------------------------------------------
+// AgendaControles: every return is released once, at its booked time, and
+// the model only wakes up when something is due.
+// ---------------------------------------------------------------------------
+void test_agenda(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    FollowupConfig fc;
+    fc.rng_seed = static_cast<unsigned>(seed);
+    fc.delay = 7.0 * 86400.0;
+    fc.jitter = (seed % 2) ? 3.0 * 86400.0 : 0.0;
+    auto agenda = std::make_shared<AgendaControles>("AgendaControles", fc);
+    TransitionDriver<AgendaControles> drv(agenda);
+
+    const int returns = 2000;
+    std::vector<double> booked(returns, -1.0);
+    std::vector<double> released(returns, -1.0);
+    double t = 0.0;
+    int injected = 0;
+
+    auto collect = [&]() {
+        const double when = drv.now();
+        for (const auto& p : drv.take(agenda->Out_PacienteDA)) {
+            CESFAM_CHECK(released[p.id_paciente] < 0.0);
+            released[p.id_paciente] = when;
+        }
+    };
+
+    while (injected < returns) {
+        t += std::exponential_distribution<double>(1.0 / 600.0)(rng);
+        while (drv.time_next() < t) {
+            drv.internal();
+            collect();
+        }
+        const int bag = std::uniform_int_distribution<int>(1, 3)(rng);
+        for (int b = 0; b < bag && injected < returns; ++b) {
+            booked[injected] = t;
+            drv.inject(agenda->In_PacienteDA, make_patient(injected++, t));
+        }
+        drv.external(t);
+        collect();
+        CESFAM_CHECK(drv.state().pending() + static_cast<std::size_t>(std::count_if(
+                         released.begin(), released.end(), [](double r) { return r >= 0.0; }))
+                     == static_cast<std::size_t>(injected));
+    }
+    while (drv.internal()) collect();
+    g_transitions += drv.transitions();
+
+    CESFAM_CHECK(drv.state().pending() == 0);
+    for (int i = 0; i < returns; ++i) {
+        CESFAM_CHECK(released[i] >= booked[i] + fc.delay - fc.jitter - 1e-6);
+        CESFAM_CHECK(released[i] <= booked[i] + fc.delay + fc.jitter + 1e-6);
+        if (fc.jitter == 0.0) CESFAM_CHECK(near(released[i], booked[i] + fc.delay));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Medico with reneging: every patient is either served or abandons, served
+// ones keep the FIFO recurrence, and a patient only abandons while the
+// doctor is busy.
+// ---------------------------------------------------------------------------
+void test_medico_reneging(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+
+    DoctorConfig dc;
+    dc.doctor_id = static_cast<int>(seed % 5);
+    dc.rng_seed = static_cast<unsigned>(seed);
+    dc.service_mean = 60.0;
+    dc.patience_mean = (seed % 2) ? 120.0 : 900.0;
+    dc.patience_tick = (seed % 3) ? 1.0 : 0.1;
+    auto doc = std::make_shared<Medico>("Medico", dc);
+    TransitionDriver<Medico> drv(doc);
+
+    const int arrivals = 400;
+    int injected = 0;
+    double t = 0.0;
+    std::vector<Patient> out, gone;
+
+    auto collect = [&]() {
+        for (auto& p : drv.take(doc->Out_Paciente)) out.push_back(p);
+        for (auto& p : drv.take(doc->Out_Abandono)) gone.push_back(p);
+    };
+    auto check_state = [&]() {
+        const DoctorState& s = drv.state();
+        CESFAM_CHECK(static_cast<std::size_t>(injected) == out.size() + gone.size() + s.waiting() + (s.busy ? 1 : 0));
+        CESFAM_CHECK(s.busy || s.waiting() == 0);
+        CESFAM_CHECK(s.queue.empty() || s.queue.front().estado != PatientStatus::Abandono);
+        CESFAM_CHECK(s.wheel.size() == s.waiting());
+    };
+
+    while (injected < arrivals) {
+        // overloaded: arrivals twice as fast as service
+        t += std::exponential_distribution<double>(1.0 / 30.0)(rng);
+        drv.run_until(t, false);
+        collect();
+        check_state();
+
+        drv.inject(doc->In_Paciente, make_patient(injected++, t));
+        drv.external(t);
+        collect();
+        check_state();
+    }
+    drv.run_until(kInf);
+    collect();
+    check_state();
+    g_transitions += drv.transitions();
+
+    CESFAM_CHECK(out.size() + gone.size() == static_cast<std::size_t>(arrivals));
+    CESFAM_CHECK(!gone.empty());
+    std::vector<char> seen(arrivals, 0);
+    double prev_end = 0.0;
+    for (const auto& p : out) {
+        CESFAM_CHECK(seen[p.id_paciente]++ == 0);
+        CESFAM_CHECK(near(p.hora_atencion, std::max(p.hora_llegada, prev_end)));
+        prev_end = p.hora_salida;
+    }
+    for (const auto& p : gone) {
+        CESFAM_CHECK(seen[p.id_paciente]++ == 0);
+        CESFAM_CHECK(p.estado == PatientStatus::Abandono);
+        CESFAM_CHECK(p.medico_asignado == dc.doctor_id);
+        CESFAM_CHECK(p.hora_atencion == 0.0);
+        CESFAM_CHECK(p.hora_salida > p.hora_llegada);
+        const double ticks = p.hora_salida / dc.patience_tick;
+        CESFAM_CHECK(std::abs(ticks - std::round(ticks)) < 1e-6);
+        // the doctor was attending someone who started before and ends after
+        const bool covered = std::any_of(out.begin(), out.end(), [&](const Patient& q) {
+            return q.hora_atencion <= p.hora_salida + 1e-9 && q.hora_salida >= p.hora_salida - 1e-9;
+        });
+        CESFAM_CHECK(covered);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// DivergenceMonitor: a queue that grows linearly under noise is flagged soon
+// after the first full window, and a stationary one (same noise, no drift)
+// never is.
+// ---------------------------------------------------------------------------
+void test_divergence(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> noise(0.0, 3.0);
+    DivergenceConfig cfg;
+    cfg.interval = 1.0;
+
+    DivergenceMonitor stable(cfg), growing(cfg);
+    int flagged_at = -1;
+    for (int i = 0; i < 2000; ++i) {
+        const double q = std::max(0.0, 10.0 + noise(rng));
+        CESFAM_CHECK(!stable.add(q, q + std::max(0.0, 5.0 + noise(rng))));
+        const double g = 2.0 * i + noise(rng);
+        if (growing.add(g, g + std::max(0.0, 5.0 + noise(rng))) && flagged_at < 0) flagged_at = i;
+    }
+    CESFAM_CHECK(!stable.diverged());
+    CESFAM_CHECK(growing.diverged());
+    // first test at sample window-1, then one every window/2
+    CESFAM_CHECK(flagged_at == cfg.window - 1 + (cfg.confirm - 1) * cfg.window / 2);
+}
+
+// ---------------------------------------------------------------------------
+// ArrivalStream: input shuffled within blocks of the look-ahead comes out in
+// time order with nothing late; an event older than the window is clamped to
+// the last released time; the header, comments and malformed lines are
+// skipped.
+// ---------------------------------------------------------------------------
+std::vector<ArrivalEvent> drain(const std::string& path, std::size_t lookahead, std::size_t* late = nullptr,
+                                std::size_t* malformed = nullptr) {
+    ArrivalStream feed(path, lookahead);
+    std::vector<ArrivalEvent> out;
+    ArrivalEvent ev;
+    while (feed.next(ev)) out.push_back(ev);
+    CESFAM_CHECK(feed.count() == out.size());
+    if (late) *late = feed.late();
+    if (malformed) *malformed = feed.malformed();
+    return out;
+}
+
+void test_arrival_stream(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    const std::string path =
+        (std::filesystem::temp_directory_path() / ("cesfam_feed_" + std::to_string(seed) + ".csv")).string();
+    const std::size_t lookahead = 1 + seed % 8;
+
+    std::vector<double> times;
+    double t = 0.0;
+    for (int i = 0; i < 100; ++i) times.push_back(t += std::exponential_distribution<double>(0.01)(rng));
+    std::vector<double> shuffled = times;
+    for (std::size_t b = 0; b < shuffled.size(); b += lookahead) {
+        std::shuffle(shuffled.begin() + b, shuffled.begin() + std::min(b + lookahead, shuffled.size()), rng);
+    }
+    {
+        std::ofstream f(path);
+        f.precision(17);
+        f << "time,edad,riesgo\n";
+        for (double x : shuffled) f << x << ",70,alto\n";
+    }
+    std::size_t late = 0, malformed = 0;
+    const auto out = drain(path, lookahead, &late, &malformed);
+    CESFAM_CHECK(out.size() == times.size());
+    for (std::size_t i = 0; i < std::min(out.size(), times.size()); ++i) {
+        CESFAM_CHECK(out[i].time == times[i]);
+        CESFAM_CHECK(out[i].edad == 70 && out[i].riesgo == RiskLevel::Alto);
+    }
+    CESFAM_CHECK(late == 0 && malformed == 0);
+
+    // 1 arrives after 5 and 6 were released: delayed to 6
+    {
+        std::ofstream f(path);
+        f << "5,60,bajo\n6,61,medio\n7,62,alto\n1,63,bajo\n8,64,alto\n";
+    }
+    const auto clamped = drain(path, 2, &late);
+    CESFAM_CHECK(clamped.size() == 5);
+    if (clamped.size() == 5) {
+        const double expect[] = {5.0, 6.0, 6.0, 7.0, 8.0};
+        for (int i = 0; i < 5; ++i) CESFAM_CHECK(clamped[i].time == expect[i]);
+        CESFAM_CHECK(clamped[2].edad == 63);
+    }
+    CESFAM_CHECK(late == 1);
+
+    // bad or half-written lines are skipped, the rest still arrives
+    {
+        std::ofstream f(path);
+        f << "hora,edad,riesgo\n# comment\n\n1,70,alto\nabc,70,alto\n2,oops,bajo\nnan,70,medio\n"
+          << "1e999,70,bajo\n3,71,bajo\n,\n4,72,medio\n";
+    }
+    const auto kept = drain(path, 1 + seed % 4, &late, &malformed);
+    CESFAM_CHECK(kept.size() == 3);
+    if (kept.size() == 3) {
+        CESFAM_CHECK(kept[0].time == 1.0 && kept[1].time == 3.0 && kept[2].time == 4.0);
+        CESFAM_CHECK(kept[1].edad == 71 && kept[2].riesgo == RiskLevel::Medio);
+    }
+    CESFAM_CHECK(malformed == 5 && late == 0);
+    std::filesystem::remove(path);
+}
+
+// ---------------------------------------------------------------------------
+// StochasticKriging: on a smooth response observed with little noise the
+// metamodel interpolates within a few noise sds, is more certain at design
+// points than between them, and a point added without noise is reproduced
+// exactly.
+// ---------------------------------------------------------------------------
+void test_kriging(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    auto f = [](const std::vector<double>& x) { return std::sin(3.0 * x[0]) + 2.0 * x[1] * x[1]; };
+    const double noise_sd = 0.01;
+    std::normal_distribution<double> noise(0.0, noise_sd);
+
+    std::vector<std::vector<double>> x;
+    std::vector<double> y, var;
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            x.push_back({i / 5.0, j / 5.0});
+            y.push_back(f(x.back()) + noise(rng));
+            var.push_back(noise_sd * noise_sd);
+        }
+    }
+    StochasticKriging m;
+    m.fit(x, y, var);
+    CESFAM_CHECK(m.size() == x.size() && m.dims() == 2);
+
+    for (int q = 0; q < 50; ++q) {
+        const std::vector<double> p{unif(rng), unif(rng)};
+        const KrigingPrediction k = m.predict(p);
+        CESFAM_CHECK(std::abs(k.mean - f(p)) < 0.05);
+        CESFAM_CHECK(k.sd > 0.0 && k.sd < 0.05);
+    }
+    CESFAM_CHECK(m.predict(x[7]).sd < m.predict({0.1, 0.3}).sd);
+    CESFAM_CHECK(m.predict({2.0, 2.0}).sd > 10.0 * m.predict({0.5, 0.5}).sd);   // extrapolation
+    CESFAM_CHECK(m.loo_rmse() < 0.1);
+
+    const std::vector<double> extra{0.55, 0.45};
+    m.add(extra, 1.5, 0.0);
+    CESFAM_CHECK(std::abs(m.predict(extra).mean - 1.5) < 0.01);   // neighbours alone say ~1.4
+    CESFAM_CHECK(m.predict(extra).sd < 0.01);
+}
+
+// ---------------------------------------------------------------------------
+// JourneyFile: a table reads back exactly what was written, and a truncated
+// or corrupted copy is either rejected with std::runtime_error or decodes
+// without reading outside the file (run under -fsanitize=address to see it).
+// A writer whose writes fail throws on close().
+// ---------------------------------------------------------------------------
+void test_journey(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    const std::string path =
+        (std::filesystem::temp_directory_path() / ("cesfam_test_" + std::to_string(seed) + ".cjt")).string();
+
+    std::vector<JourneyRow> rows;
+    {
+        JourneyWriter w(path, 1 + seed % 7);
+        double t = 0.0;
+        for (int i = 0; i < 40; ++i) {
+            t += std::exponential_distribution<double>(0.01)(rng);
+            JourneyRow r = journey_row(make_patient(i, t, random_risk(rng)));
+            r.hora_atencion = t + 60.0 * (i % 5);
+            r.espera = r.hora_atencion - t;
+            r.medico = i % 3;
+            w.append(r);
+            rows.push_back(r);
+        }
+    }
+
+    auto read_all = [](const std::string& p, std::vector<std::int64_t>& ids, std::vector<double>& espera) {
+        JourneyFile f(p);
+        std::vector<std::int64_t> vi;
+        std::vector<double> vd;
+        for (const auto& b : f.blocks()) {
+            JourneyFile::ints(b, JourneyColumn::Id, vi);
+            ids.insert(ids.end(), vi.begin(), vi.end());
+            JourneyFile::doubles(b, JourneyColumn::Espera, vd);
+            espera.insert(espera.end(), vd.begin(), vd.end());
+            for (JourneyColumn c : {JourneyColumn::Edad, JourneyColumn::Medico, JourneyColumn::Followups}) {
+                JourneyFile::ints(b, c, vi);
+            }
+            for (JourneyColumn c : {JourneyColumn::Llegada, JourneyColumn::Atencion, JourneyColumn::Salida,
+                                    JourneyColumn::TiempoAtencion}) {
+                JourneyFile::doubles(b, c, vd);
+            }
+        }
+        return f.rows();
+    };
+
+    std::vector<std::int64_t> ids;
+    std::vector<double> espera;
+    CESFAM_CHECK(read_all(path, ids, espera) == rows.size());
+    CESFAM_CHECK(ids.size() == rows.size() && espera.size() == rows.size());
+    for (std::size_t i = 0; i < rows.size() && i < ids.size(); ++i) {
+        CESFAM_CHECK(ids[i] == rows[i].id);
+        CESFAM_CHECK(espera[i] == rows[i].espera);
+    }
+
+    std::vector<char> good;
+    {
+        std::ifstream in(path, std::ios::binary);
+        good.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const std::string bad = path + ".bad";
+    for (int trial = 0; trial < 60; ++trial) {
+        std::vector<char> data = good;
+        if (trial % 3 == 0) {
+            data.resize(std::uniform_int_distribution<std::size_t>(0, data.size() - 1)(rng));
+        } else {
+            for (int k = 0; k < 1 + trial % 4; ++k) {
+                const std::size_t at = std::uniform_int_distribution<std::size_t>(0, data.size() - 1)(rng);
+                data[at] = static_cast<char>(std::uniform_int_distribution<int>(0, 255)(rng));
+            }
+        }
+        {
+            std::ofstream out(bad, std::ios::binary | std::ios::trunc);
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        bool ok = true;
+        try {
+            std::vector<std::int64_t> i2;
+            std::vector<double> e2;
+            read_all(bad, i2, e2);
+        } catch (const std::runtime_error&) {
+            ok = false;
+        }
+        if (trial % 3 == 0) CESFAM_CHECK(!ok);   // truncated: the footer is gone
+    }
+    std::filesystem::remove(bad);
+    std::filesystem::remove(path);
+
+    // a write that fails (disk full) makes close() throw instead of leaving a
+    // truncated table behind silently
+    if (std::filesystem::exists("/dev/full")) {
+        bool threw = false;
+        try {
+            JourneyWriter w("/dev/full", 1 + seed % 7);
+            for (const auto& r : rows) w.append(r);
+            w.close();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CESFAM_CHECK(threw);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// RunArena: a doctor whose state lives in an arena behaves exactly like one on
+// the heap, stays on the arena across resets, and the arena can be released
+// and reused once the model is gone.
+// ---------------------------------------------------------------------------
+void test_arena(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    auto arena = std::make_shared<RunArena>(1024);   // small: forces overflow blocks
+
+    DoctorConfig dc;
+    dc.rng_seed = static_cast<unsigned>(seed);
+    dc.service_mean = 300.0;
+    dc.patience_mean = 900.0;
+    for (int round = 0; round < 3; ++round) {
+        DoctorConfig dca = dc;
+        dca.memory = arena;
+        {
+            auto heap = std::make_shared<Medico>("Medico", dc);
+            auto pooled = std::make_shared<Medico>("Medico", dca);
+            if (round == 1) pooled->reset(dca);
+            CESFAM_CHECK(pooled->getState().queue.get_allocator().resource() == arena.get());
+            CESFAM_CHECK(heap->getState().queue.get_allocator().resource() == std::pmr::get_default_resource());
+
+            TransitionDriver<Medico> a(heap), b(pooled);
+            std::vector<Patient> out_a, out_b;
+            double t = 0.0;
+            for (int i = 0; i < 150; ++i) {
+                t += std::exponential_distribution<double>(1.0 / 60.0)(rng);
+                a.run_until(t, false);
+                b.run_until(t, false);
+                a.inject(heap->In_Paciente, make_patient(i, t));
+                b.inject(pooled->In_Paciente, make_patient(i, t));
+                a.external(t);
+                b.external(t);
+                for (auto& p : a.take(heap->Out_Paciente)) out_a.push_back(p);
+                for (auto& p : a.take(heap->Out_Abandono)) out_a.push_back(p);
+                for (auto& p : b.take(pooled->Out_Paciente)) out_b.push_back(p);
+                for (auto& p : b.take(pooled->Out_Abandono)) out_b.push_back(p);
+                CESFAM_CHECK(a.state().queue.size() == b.state().queue.size());
+            }
+            CESFAM_CHECK(out_a.size() == out_b.size());
+            for (std::size_t i = 0; i < std::min(out_a.size(), out_b.size()); ++i) {
+                CESFAM_CHECK(out_a[i].id_paciente == out_b[i].id_paciente);
+                CESFAM_CHECK(out_a[i].hora_salida == out_b[i].hora_salida);
+                CESFAM_CHECK(out_a[i].estado == out_b[i].estado);
+            }
+
+            const DoctorState copy = pooled->getState();   // snapshots go to the heap
+            CESFAM_CHECK(copy.queue.get_allocator().resource() == std::pmr::get_default_resource());
+            g_transitions += a.transitions() + b.transitions();
+        }   // model gone: the arena holds nothing live
+        arena->release();
+        CESFAM_CHECK(arena->reserved() >= 1024);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// RouterMedicos: every patient goes to exactly one doctor, round-robin order
+// or least loaded doctor; unknown router.policy names are rejected.
+// ---------------------------------------------------------------------------
+void test_router(std::uint64_t seed, int doctors, RoutingPolicy policy) {
+    std::mt19937_64 rng(seed);
+    auto router = std::make_shared<RouterMedicos>("RouterMedicos", RouterConfig{doctors, policy});
+    TransitionDriver<RouterMedicos> drv(router);
+
+    std::vector<int> load(static_cast<std::size_t>(doctors), 0);   // shadow of the router's load
+    std::vector<std::vector<Patient>> in_service(static_cast<std::size_t>(doctors));
+    int rr = 0;
+    int next_id = 0;
+    double t = 0.0;
+
+    for (int step = 0; step < 300; ++step) {
+        t += std::uniform_int_distribution<int>(0, 2)(rng);   // includes simultaneous events
+        drv.run_until(t, false);
+        CESFAM_CHECK(drv.time_next() == kInf);
+
+        // completions (only coupled with ShortestQueue) arrive in the same
+        // bag as the new patients and are processed first
+        for (int d = 0; d < doctors && policy == RoutingPolicy::ShortestQueue; ++d) {
+            auto& v = in_service[static_cast<std::size_t>(d)];
+            if (!v.empty() && std::uniform_int_distribution<int>(0, 2)(rng) == 0) {
+                Patient p = v.front();
+                v.erase(v.begin());
+                p.medico_asignado = d;
+                drv.inject(router->In_fin, p);
+                load[static_cast<std::size_t>(d)] -= 1;
+            }
+        }
+
+        // expected assignment of the arrivals, in bag order
+        const int bag = std::uniform_int_distribution<int>(0, 4)(rng);
+        std::vector<int> expected;
+        for (int b = 0; b < bag; ++b) {
+            drv.inject(router->In_paciente, make_patient(next_id++, t));
+            int idx = rr % doctors;
+            if (policy == RoutingPolicy::ShortestQueue) {
+                for (int k = 1; k < doctors; ++k) {
+                    const int j = (rr + k) % doctors;
+                    if (load[static_cast<std::size_t>(j)] < load[static_cast<std::size_t>(idx)]) idx = j;
+                }
+                load[static_cast<std::size_t>(idx)] += 1;
+            }
+            expected.push_back(idx);
+            rr = (idx + 1) % doctors;
+        }
+
+        drv.external(t);
+        CESFAM_CHECK(drv.time_next() == (bag > 0 ? t : kInf));
+        drv.run_until(t);
+
+        std::size_t routed = 0;
+        for (int d = 0; d < doctors; ++d) {
+            for (auto& p : drv.take(router->Out_to_doctor[static_cast<std::size_t>(d)])) {
+                const int id = p.id_paciente;
+                const int k = id - (next_id - bag);
+                CESFAM_CHECK(k >= 0 && k < bag);
+                if (k >= 0 && k < bag) CESFAM_CHECK(expected[static_cast<std::size_t>(k)] == d);
+                in_service[static_cast<std::size_t>(d)].push_back(p);
+                ++routed;
+            }
+        }
+        CESFAM_CHECK(routed == static_cast<std::size_t>(bag));
+        if (policy == RoutingPolicy::ShortestQueue) CESFAM_CHECK(std::equal(load.begin(), load.end(), drv.state().load.begin(), drv.state().load.end()));
+    }
+    g_transitions += drv.transitions();
+}
+
+void test_routing_policy_names() {
+    CESFAM_CHECK(parse_routing_policy("round_robin") == RoutingPolicy::RoundRobin);
+    CESFAM_CHECK(parse_routing_policy("shortest_queue") == RoutingPolicy::ShortestQueue);
+    CESFAM_CHECK(parse_routing_policy("jsq") == RoutingPolicy::ShortestQueue);
+    for (const char* typo : {"shortest-queue", "", "RoundRobin"}) {
+        bool threw = false;
+        try {
+            parse_routing_policy(typo);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        CESFAM_CHECK(threw);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GestorCasos: one output per input, triage by age, DA returns reset.
+// ---------------------------------------------------------------------------
+void test_gestor(std::uint64_t seed, double p_accept) {
+    std::mt19937_64 rng(seed);
+    CaseManagerConfig cc;
+    cc.rng_seed = static_cast<unsigned>(seed);
+    cc.consent_p_accept = p_accept;
+    auto gestor = std::make_shared<GestorCasos>("GestorCasos", cc);
+    TransitionDriver<GestorCasos> drv(gestor);
+
+    std::size_t in = 0, ac = 0, rc = 0;
+    double t = 0.0;
+    for (int step = 0; step < 200; ++step) {
+        t += std::uniform_int_distribution<int>(0, 3)(rng);
+        const int bag = std::uniform_int_distribution<int>(1, 3)(rng);
+        const bool da = std::uniform_int_distribution<int>(0, 1)(rng) == 1;
+        for (int b = 0; b < bag; ++b) {
+            Patient p = make_patient(static_cast<int>(in++), t - 10.0, random_risk(rng),
+                                     std::uniform_int_distribution<int>(50, 95)(rng));
+            p.hora_atencion = 5.0;
+            p.hora_salida = 7.0;
+            p.medico_asignado = 3;
+            drv.inject(da ? gestor->In_PacienteDA : gestor->In_paciente, p);
+        }
+        drv.external(t);
+        CESFAM_CHECK(drv.time_next() == t);
+        drv.run_until(t);
+        CESFAM_CHECK(drv.time_next() == kInf);
+
+        auto out_ac = drv.take(gestor->Out_pacienteAC);
+        auto out_rc = drv.take(gestor->Out_PacienteRC);
+        CESFAM_CHECK(out_ac.size() + out_rc.size() == static_cast<std::size_t>(bag));
+        ac += out_ac.size();
+        rc += out_rc.size();
+
+        for (const auto* v : {&out_ac, &out_rc}) {
+            for (const Patient& p : *v) {
+                CESFAM_CHECK(p.nivel_riesgo != RiskLevel::Unknown);
+                if (da) {
+                    CESFAM_CHECK(p.hora_llegada == t);
+                    CESFAM_CHECK(p.hora_atencion == 0.0 && p.hora_salida == 0.0);
+                    CESFAM_CHECK(p.medico_asignado == -1);
+                } else {
+                    CESFAM_CHECK(p.hora_llegada == t - 10.0);
+                }
+            }
+        }
+        for (const Patient& p : out_ac) CESFAM_CHECK(p.estado == PatientStatus::EnEsperaAtencion);
+        for (const Patient& p : out_rc) {
+            CESFAM_CHECK(p.estado == PatientStatus::Finalizado);
+            CESFAM_CHECK(p.resultado == AttentionResult::Derivacion);
+        }
+    }
+    g_transitions += drv.transitions();
+
+    if (p_accept >= 1.0) CESFAM_CHECK(rc == 0);
+    if (p_accept <= 0.0) CESFAM_CHECK(ac == 0);
+    if (p_accept > 0.0 && p_accept < 1.0) {
+        // binomial, 5 sigma
+        const double n = static_cast<double>(in);
+        const double sd = std::sqrt(n * p_accept * (1.0 - p_accept));
+        CESFAM_CHECK(std::abs(static_cast<double>(ac) - n * p_accept) <= 5.0 * sd);
+    }
+}
+
+void test_triage_exhaustive() {
+    CaseManagerConfig cc;
+    cc.consent_p_accept = 1.0;
+    auto gestor = std::make_shared<GestorCasos>("GestorCasos", cc);
+    TransitionDriver<GestorCasos> drv(gestor);
+    for (int edad = 0; edad <= 120; ++edad) {
+        for (int r = 0; r <= 3; ++r) {
+            drv.inject(gestor->In_paciente, make_patient(edad, 0.0, static_cast<RiskLevel>(r), edad));
+            drv.external(drv.now());
+            drv.run_until(drv.now());
+            auto out = drv.take(gestor->Out_pacienteAC);
+            if (!CESFAM_CHECK(out.size() == 1)) continue;
+            RiskLevel expected = static_cast<RiskLevel>(r);
+            if (expected == RiskLevel::Unknown) {
+                expected = edad >= 80 ? RiskLevel::Alto : edad >= 70 ? RiskLevel::Medio : RiskLevel::Bajo;
+            }
+            CESFAM_CHECK(out[0].nivel_riesgo == expected);
+        }
+    }
+    g_transitions += drv.transitions();
+}
+
+// ---------------------------------------------------------------------------
+// AdherenciaDecision: one output per input, follow-up cap, DA/RA fields.
+// ---------------------------------------------------------------------------
+void test_adherencia(std::uint64_t seed, double p_base) {
+    std::mt19937_64 rng(seed);
+    AdherenceConfig ac;
+    ac.rng_seed = static_cast<unsigned>(seed);
+    ac.p_continue_base = p_base;
+    ac.max_followups = static_cast<int>(seed % 4);
+    auto adher = std::make_shared<AdherenciaDecision>("AdherenciaDecision", ac);
+    TransitionDriver<AdherenciaDecision> drv(adher);
+
+    std::size_t eligible_medio = 0, returned_medio = 0;
+    double t = 0.0;
+    for (int step = 0; step < 200; ++step) {
+        t += std::uniform_int_distribution<int>(0, 3)(rng);
+        const int bag = std::uniform_int_distribution<int>(1, 4)(rng);
+        std::vector<Patient> sent;
+        for (int b = 0; b < bag; ++b) {
+            Patient p = make_patient(b, t, random_risk(rng));
+            p.followups_done = static_cast<std::int16_t>(std::uniform_int_distribution<int>(0, ac.max_followups + 1)(rng));
+            sent.push_back(p);
+            drv.inject(adher->In_Paciente, p);
+        }
+        drv.external(t);
+        drv.run_until(t);
+        CESFAM_CHECK(drv.time_next() == kInf);
+
+        auto da = drv.take(adher->Out_PacienteDA);
+        auto ra = drv.take(adher->Out_PacienteRA);
+        CESFAM_CHECK(da.size() + ra.size() == sent.size());
+
+        for (const Patient& p : da) {
+            const Patient& orig = sent[static_cast<std::size_t>(p.id_paciente)];
+            CESFAM_CHECK(orig.followups_done < ac.max_followups);
+            CESFAM_CHECK(p.followups_done == orig.followups_done + 1);
+            CESFAM_CHECK(p.resultado == AttentionResult::Seguimiento);
+            if (p_base <= 0.0) CESFAM_CHECK(false);
+            if (p.nivel_riesgo == RiskLevel::Medio) ++returned_medio;
+        }
+        for (const Patient& p : ra) {
+            const Patient& orig = sent[static_cast<std::size_t>(p.id_paciente)];
+            CESFAM_CHECK(p.followups_done == orig.followups_done);
+            CESFAM_CHECK((p.estado == PatientStatus::Finalizado && p.resultado == AttentionResult::Alta) ||
+                         (p.estado == PatientStatus::Derivado && p.resultado == AttentionResult::Derivacion));
+            // below the cap with p = 1 (and multipliers >= 1) nobody leaves
+            if (p_base >= 1.0 && p.nivel_riesgo != RiskLevel::Bajo) CESFAM_CHECK(orig.followups_done >= ac.max_followups);
+        }
+        for (const Patient& p : sent) {
+            if (p.nivel_riesgo == RiskLevel::Medio && p.followups_done < ac.max_followups) ++eligible_medio;
+        }
+    }
+    g_transitions += drv.transitions();
+
+    if (p_base > 0.0 && p_base < 1.0 && eligible_medio > 0) {
+        const double n = static_cast<double>(eligible_medio);
+        const double sd = std::sqrt(n * p_base * (1.0 - p_base));
+        CESFAM_CHECK(std::abs(static_cast<double>(returned_medio) - n * p_base) <= 5.0 * sd);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Shifts: an off-duty doctor finishes the patient in service, starts nobody
+// and hands every waiting or newly routed patient back at once; the router
+// only routes to the doctors on duty and holds patients while nobody is.
+// ---------------------------------------------------------------------------
+void test_shifts(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+
+    DoctorConfig dc;
+    dc.doctor_id = 1;
+    dc.rng_seed = static_cast<unsigned>(seed);
+    dc.service_mean = 60.0;
+    dc.patience_mean = (seed % 2) ? 300.0 : 0.0;
+    dc.shifts = true;
+    auto doc = std::make_shared<Medico>("Medico", dc);
+    TransitionDriver<Medico> drv(doc);
+
+    int injected = 0;
+    double t = 0.0;
+    bool on = true;
+    std::vector<Patient> out, gone, back;
+    std::vector<std::pair<double, double>> off;   // off-duty intervals
+
+    auto collect = [&]() {
+        for (auto& p : drv.take(doc->Out_Paciente)) out.push_back(p);
+        for (auto& p : drv.take(doc->Out_Abandono)) gone.push_back(p);
+        for (auto& p : drv.take(doc->Out_Relevo)) back.push_back(p);
+    };
+    auto check_state = [&]() {
+        const DoctorState& s = drv.state();
+        CESFAM_CHECK(s.on_duty == on);
+        CESFAM_CHECK(static_cast<std::size_t>(injected) == out.size() + gone.size() + back.size() + s.waiting() + (s.busy ? 1 : 0));
+        if (!on) CESFAM_CHECK(s.waiting() == 0);
+    };
+
+    for (int step = 0; step < 300; ++step) {
+        t += std::exponential_distribution<double>(1.0 / 30.0)(rng);
+        drv.run_until(t, false);
+        collect();
+        check_state();
+
+        if (std::uniform_int_distribution<int>(0, 9)(rng) == 0) {
+            on = !on;
+            drv.inject(doc->In_Turno, ShiftChange{on ? 2 : 1});
+            if (on) off.back().second = t; else off.emplace_back(t, kInf);
+        }
+        drv.inject(doc->In_Paciente, make_patient(injected++, t));
+        drv.external(t);
+        // handovers leave at the instant of the change or arrival
+        if (!on) CESFAM_CHECK(drv.time_next() == t);
+        drv.run_until(t);
+        collect();
+        check_state();
+    }
+    drv.run_until(kInf);
+    collect();
+    check_state();
+    g_transitions += drv.transitions();
+
+    auto off_at = [&](double x) {
+        return std::any_of(off.begin(), off.end(), [&](const std::pair<double, double>& o) { return x >= o.first && x < o.second; });
+    };
+    for (const auto& p : out) CESFAM_CHECK(!off_at(p.hora_atencion));
+    for (const auto& p : back) {
+        CESFAM_CHECK(p.medico_asignado == dc.doctor_id);
+        CESFAM_CHECK(p.estado != PatientStatus::Abandono);
+        CESFAM_CHECK(p.hora_atencion == 0.0);
+    }
+    if (on) CESFAM_CHECK(out.size() + gone.size() + back.size() == static_cast<std::size_t>(injected));
+
+    // Router: round-robin among doctors 0 .. on_duty-1, handed-over patients
+    // first, nothing routed while nobody is on duty.
+    const int doctors = 1 + static_cast<int>(seed % 6);
+    RouterConfig rc;
+    rc.doctors = doctors;
+    rc.shifts = true;
+    rc.on_duty = doctors;
+    auto router = std::make_shared<RouterMedicos>("RouterMedicos", rc);
+    TransitionDriver<RouterMedicos> rdrv(router);
+
+    int on_duty = doctors;
+    int rr = 0;
+    int next_id = 0;
+    std::vector<int> held;   // ids, in order
+    std::map<int, int> expected;
+    std::size_t routed = 0;
+    t = 0.0;
+    for (int step = 0; step < 200; ++step) {
+        t += std::uniform_int_distribution<int>(0, 2)(rng);
+        rdrv.run_until(t, false);
+
+        std::vector<int> batch;
+        if (std::uniform_int_distribution<int>(0, 3)(rng) == 0) {
+            on_duty = std::uniform_int_distribution<int>(0, doctors + 1)(rng);
+            rdrv.inject(router->In_turno, ShiftChange{on_duty});
+            on_duty = std::min(on_duty, doctors);
+        }
+        const int relevos = std::uniform_int_distribution<int>(0, 2)(rng);
+        for (int k = 0; k < relevos; ++k) {
+            Patient p = make_patient(next_id, t);
+            p.medico_asignado = 0;
+            rdrv.inject(router->In_relevo, p);
+            held.push_back(next_id++);
+        }
+        if (on_duty > 0) {
+            batch.swap(held);
+        }
+        const int bag = std::uniform_int_distribution<int>(0, 3)(rng);
+        for (int b = 0; b < bag; ++b) {
+            rdrv.inject(router->In_paciente, make_patient(next_id, t));
+            (on_duty > 0 ? batch : held).push_back(next_id++);
+        }
+        for (int id : batch) {
+            expected[id] = rr % on_duty;
+            rr = (rr % on_duty + 1) % on_duty;
+        }
+
+        rdrv.external(t);
+        rdrv.run_until(t);
+        CESFAM_CHECK(rdrv.state().held.size() == held.size());
+        CESFAM_CHECK(rdrv.state().on_duty == on_duty);
+        for (int d = 0; d < doctors; ++d) {
+            for (auto& p : rdrv.take(router->Out_to_doctor[static_cast<std::size_t>(d)])) {
+                CESFAM_CHECK(expected.count(p.id_paciente) == 1 && expected[p.id_paciente] == d);
+                CESFAM_CHECK(p.medico_asignado == -1);
+                ++routed;
+            }
+        }
+        CESFAM_CHECK(routed == expected.size());
+    }
+    g_transitions += rdrv.transitions();
+
+    // Calendar: mean_doctors is the time average of at() over one period.
+    ShiftCalendar cal;
+    cal.period = 100.0;
+    for (int e = 0, n = 1 + static_cast<int>(seed % 4); e < n; ++e) {
+        cal.entries.push_back({static_cast<double>(10 * e + 5 * (seed % 2)), std::uniform_int_distribution<int>(0, 5)(rng)});
+    }
+    double sum = 0.0;
+    for (int x = 0; x < 1000; ++x) sum += cal.at(0.05 + 0.1 * x);
+    CESFAM_CHECK(std::abs(sum / 1000.0 - cal.mean_doctors()) < 1e-9);
+}
+
+} // namespace
+
+int main() {
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::uint64_t seeds = 200;
+
+    for (std::uint64_t s = 1; s <= seeds; ++s) test_medico(s);
+    for (std::uint64_t s = 1; s <= seeds / 4; ++s) test_timing_wheel(s);
+    for (std::uint64_t s = 1; s <= seeds; ++s) test_medico_reneging(s);
+    for (std::uint64_t s = 1; s <= seeds; ++s) test_shifts(s);
+    for (std::uint64_t s = 1; s <= 8; ++s) test_calendar_queue(s);
+    test_block_rng();
+    for (std::uint64_t s = 1; s <= seeds / 4; ++s) test_agenda(s);
+    for (std::uint64_t s = 1; s <= seeds / 4; ++s) test_arena(s);
+    for (std::uint64_t s = 1; s <= seeds / 4; ++s) test_divergence(s);
+    for (std::uint64_t s = 1; s <= 16; ++s) test_arrival_stream(s);
+    for (std::uint64_t s = 1; s <= 8; ++s) test_kriging(s);
+    for (std::uint64_t s = 1; s <= seeds / 4; ++s) test_journey(s);
+    for (std::uint64_t s = 1; s <= seeds / 4; ++s) {
+        for (int d = 1; d <= 8; ++d) {
+            test_router(s * 16 + static_cast<std::uint64_t>(d), d, RoutingPolicy::RoundRobin);
+            test_router(s * 16 + static_cast<std::uint64_t>(d), d, RoutingPolicy::ShortestQueue);
+        }
+    }
+    test_routing_policy_names();
+    for (std::uint64_t s = 1; s <= seeds; ++s) {
+        for (double p : {0.0, 0.5, 1.0}) test_gestor(s, p);
+    }
+    test_triage_exhaustive();
+    for (std::uint64_t s = 1; s <= seeds; ++s) {
+        for (double p : {0.0, 0.3, 1.0}) test_adherencia(s, p);
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    const auto& c = cesfam::testing::check_counter();
+    std::cout << "Atomic property tests: " << c.checks << " checks, " << c.failures << " failed, " << g_transitions
+              << " transitions in " << ms << " ms (" << static_cast<double>(g_transitions) / ms / 1000.0
+              << " M transitions/s)\n";
+    return c.failures == 0 ? 0 : 1;
+}
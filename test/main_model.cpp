@@ -0,0 +1,544 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "utils/kpi.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/rare_event.hpp"
+#include "top_model/replication.hpp"
+#include "top_model/result_cache.hpp"
+#include "top_model/simulation.hpp"
+#include "top_model/whatif.hpp"
+#include "test/transition_driver.hpp"
+
+// Tests of the whole CESFAM run through the Stepper (what-if forks, the
+// rare-event importance function, model reuse between replications, the
+// in-process Simulation API, the result cache), with the checks of the atomic
+// property tests:
+// a failing check prints its location and the program exits with status 1.
+
+using namespace cesfam;
+
+namespace {
+
+// Two doctors for twice their capacity: queues build up before the fork.
+CesfamConfig overloaded(int doctors) {
+    CesfamConfig cfg;
+    cfg.generator.rng_seed = 11;
+    cfg.generator.arrivals_rate = 1.0 / 150.0;
+    cfg.generator.max_patients = 200;
+    cfg.case_manager.rng_seed = 12;
+    cfg.medical_staff.doctors = doctors;
+    cfg.medical_staff.service_mean = 600.0;
+    cfg.medical_staff.rng_seed_base = 1000;
+    cfg.adherence.rng_seed = 13;
+    return cfg;
+}
+
+// ---------------------------------------------------------------------------
+// Fork: a branch with the base configuration continues the run exactly, and
+// doctors added at the fork start working at the fork time.
+// ---------------------------------------------------------------------------
+void test_fork() {
+    const double t_fork = 6000.0, until = 60000.0;
+    const CesfamConfig base = overloaded(2);
+
+    WhatIfFork fork(base, 2);
+    const auto snap = fork.run_prefix(t_fork);
+    const auto results = fork.run_branches(snap, {{"same", base}, {"more", overloaded(5)}}, until);
+
+    const KpiSummary whole = run_replication(base, until);
+    const KpiSummary same = summarize({results[0].before.get(), results[0].after.get()});
+    CESFAM_CHECK(same.ra == whole.ra);
+    CESFAM_CHECK(same.rc == whole.rc);
+    CESFAM_CHECK(same.wait.n == whole.wait.n);
+    CESFAM_CHECK(std::abs(same.wait.mean - whole.wait.mean) <= 1e-9 * std::max(1.0, whole.wait.mean));
+
+    const ExitLog& more = *results[1].after;
+    CESFAM_CHECK(!more.ra.empty());
+    std::size_t extra = 0;
+    for (const auto& p : more.ra) {
+        CESFAM_CHECK(p.hora_atencion >= p.hora_llegada);
+        CESFAM_CHECK(p.hora_salida >= t_fork);
+        if (p.medico_asignado >= base.medical_staff.doctors) {
+            ++extra;
+            CESFAM_CHECK(p.hora_atencion >= t_fork);
+        }
+    }
+    CESFAM_CHECK(extra > 0);
+
+    // More doctors, shorter waits for the patients queued at the fork
+    const KpiSummary k_more = summarize({results[1].before.get(), results[1].after.get()});
+    CESFAM_CHECK(k_more.wait.mean < same.wait.mean);
+}
+
+// ---------------------------------------------------------------------------
+// Fork to fewer doctors under shortest_queue: the patients of the removed
+// doctors go to the least loaded of the remaining ones, so no doctor takes
+// an orphan while another has two fewer patients.
+// ---------------------------------------------------------------------------
+void test_fork_shortest_queue() {
+    const double t_fork = 9000.0, until = 60000.0;
+    for (RoutingPolicy before : {RoutingPolicy::RoundRobin, RoutingPolicy::ShortestQueue}) {
+        for (unsigned seed = 0; seed < 8; ++seed) {
+            CesfamConfig base = with_seed_offset(overloaded(5), 101 * seed);
+            base.generator.arrivals_rate = 1.0 / 100.0;
+            base.medical_staff.routing = before;
+            CesfamConfig fewer = base;
+            fewer.medical_staff.doctors = 3;
+            fewer.medical_staff.routing = RoutingPolicy::ShortestQueue;
+
+            WhatIfFork fork(base);
+            const auto snap = fork.run_prefix(t_fork);
+
+            CesfamConfig c = fewer;
+            c.exits = std::make_shared<ExitLog>();
+            auto model = std::make_shared<CESFAM>("CESFAM", c);
+            model->restore(*snap);
+            const RouterState r = model->snapshot(t_fork).router;
+            CESFAM_CHECK(r.load.size() == 3);
+            const int least = *std::min_element(r.load.begin(), r.load.end());
+            std::size_t routed = 0;
+            for (std::size_t i = 0; i < r.out_to_doc.size(); ++i) {
+                routed += r.out_to_doc[i].size();
+                if (!r.out_to_doc[i].empty()) CESFAM_CHECK(r.load[i] <= least + 1);
+            }
+            CESFAM_CHECK(routed > 0);
+
+            const auto results = fork.run_branches(snap, {{"fewer", fewer}}, until);
+            for (const auto& p : results[0].after->ra) {
+                CESFAM_CHECK(p.medico_asignado >= 0 && p.medico_asignado < 3);
+                CESFAM_CHECK(p.hora_atencion >= p.hora_llegada);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Rare-event importance under a shift calendar: doctors going off duty hand
+// their queues back (so a queue is no longer in arrival order) and, while
+// nobody is on duty, the router holds arrivals. oldest_wait() must still be
+// the longest wait over every waiting patient, at every step and at a horizon
+// that ends with patients held.
+// ---------------------------------------------------------------------------
+void test_oldest_wait_shifts() {
+    ShiftCalendar cal;
+    cal.entries = {{0.0, 3}, {3000.0, 2}, {4500.0, 1}, {6000.0, 0}, {12000.0, 2}};
+    CesfamConfig cfg = overloaded(3);
+    cfg.generator.arrivals_rate = 1.0 / 100.0;
+    cfg.medical_staff.shifts = std::make_shared<const ShiftCalendar>(cal);
+
+    auto longest = [](const CESFAM& m, RiskLevel risk, double now) {
+        const auto matches = [risk](const Patient& p) { return risk == RiskLevel::Unknown || p.nivel_riesgo == risk; };
+        double h = 0.0;
+        for (const auto& p : m.staff().router()->getState().held) {
+            if (matches(p)) h = std::max(h, now - p.hora_llegada);
+        }
+        for (const auto& doc : m.staff().doctors()) {
+            const DoctorState& d = doc->getState();
+            if (d.busy && matches(d.current)) h = std::max(h, d.current.tiempo_espera());
+            for (const auto& p : d.queue) {
+                if (p.estado != PatientStatus::Abandono && matches(p)) h = std::max(h, now - p.hora_llegada);
+            }
+        }
+        return h;
+    };
+
+    for (unsigned seed = 0; seed < 4; ++seed) {
+        const CesfamConfig c = with_seed_offset(cfg, 7919 * seed);
+        auto model = std::make_shared<CESFAM>("CESFAM", c);
+        Stepper stepper(model);
+        stepper.start();
+        bool held = false, unsorted = false;
+        while (stepper.time_next() < 15000.0) {
+            stepper.advance_one();
+            const double now = stepper.now();
+            held = held || !model->staff().router()->getState().held.empty();
+            for (const auto& doc : model->staff().doctors()) {
+                const auto& q = doc->getState().queue;
+                for (std::size_t i = 1; i < q.size(); ++i) unsorted = unsorted || q[i].hora_llegada < q[i - 1].hora_llegada;
+            }
+            for (RiskLevel risk : {RiskLevel::Unknown, RiskLevel::Alto, RiskLevel::Bajo}) {
+                CESFAM_CHECK(oldest_wait(*model, risk, now) == longest(*model, risk, now));
+            }
+        }
+        CESFAM_CHECK(held);
+        CESFAM_CHECK(unsorted);
+        stepper.stop();
+
+        // a horizon inside the 0-doctor interval: only held patients are waiting
+        auto gap = std::make_shared<CESFAM>("CESFAM", c);
+        Stepper s(gap);
+        s.start();
+        s.advance_until(9000.0);
+        const auto& h = gap->staff().router()->getState().held;
+        CESFAM_CHECK(!h.empty());
+        double first = 9000.0;
+        for (const auto& p : h) first = std::min(first, p.hora_llegada);
+        CESFAM_CHECK(oldest_wait(*gap, RiskLevel::Unknown, 9000.0) >= 9000.0 - first);
+        CESFAM_CHECK(9000.0 - first >= 3000.0);
+        s.stop();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ReplicationRunner: every run on the reused model matches a fresh one,
+// reneged patients included (nothing carries over between replications).
+// ---------------------------------------------------------------------------
+void test_runner_reuse() {
+    CesfamConfig cfg = overloaded(2);
+    cfg.medical_staff.patience_mean = 900.0;
+
+    ReplicationRunner runner;
+    for (unsigned r = 0; r < 4; ++r) {
+        const CesfamConfig rep = with_seed_offset(cfg, 7919 * r);
+        const KpiSummary reused = runner.run(rep, 30000.0);
+        const KpiSummary fresh = run_replication(rep, 30000.0);
+        CESFAM_CHECK(fresh.abandonos > 0);
+        CESFAM_CHECK(reused.abandonos == fresh.abandonos);
+        CESFAM_CHECK(reused.ra == fresh.ra);
+        CESFAM_CHECK(reused.rc == fresh.rc);
+        CESFAM_CHECK(reused.wait.mean == fresh.wait.mean);
+    }
+    CESFAM_CHECK(runner.builds() == 1);
+}
+
+bool same_run(const KpiSummary& a, const KpiSummary& b) {
+    return a.ra == b.ra && a.rc == b.rc && a.abandonos == b.abandonos && a.wait.n == b.wait.n
+        && a.wait.mean == b.wait.mean && a.wait.p90 == b.wait.p90;
+}
+
+// ---------------------------------------------------------------------------
+// Simulation: reset(seed) replays run_replication(with_seed_offset(cfg,
+// seed)), a run split over several run() calls equals one call, reset(cfg)
+// only accepts the same structure, and instances run concurrently.
+// ---------------------------------------------------------------------------
+void test_simulation() {
+    const double until = 30000.0;
+    CesfamConfig cfg = overloaded(3);
+    cfg.medical_staff.patience_mean = 1800.0;
+    cfg.adherence.p_continue_base = 0.5;
+    cfg.followup.rng_seed = 14;
+    cfg.followup.delay = 3600.0;
+    cfg.followup.jitter = 600.0;
+
+    Simulation sim(cfg);
+    std::vector<KpiSummary> expected;
+    for (unsigned seed = 0; seed < 6; ++seed) {
+        expected.push_back(run_replication(with_seed_offset(cfg, seed), until));
+        sim.reset(seed);
+        CESFAM_CHECK(sim.now() == 0.0);
+        CESFAM_CHECK(same_run(sim.run(until), expected.back()));
+    }
+    CESFAM_CHECK(expected[0].abandonos > 0);
+
+    // in pieces, in any seed order
+    for (unsigned seed : {4u, 1u}) {
+        sim.reset(seed);
+        sim.run(until / 3.0);
+        CESFAM_CHECK(sim.now() <= until / 3.0);
+        sim.run(until / 2.0);
+        CESFAM_CHECK(same_run(sim.run(until), expected[seed]));
+    }
+
+    // same structure: accepted, and becomes the base of reset(seed)
+    CesfamConfig slower = cfg;
+    slower.medical_staff.service_mean = 700.0;
+    sim.reset(slower);
+    CESFAM_CHECK(same_run(sim.run(until), run_replication(slower, until)));
+    sim.reset(2u);
+    CESFAM_CHECK(same_run(sim.run(until), run_replication(with_seed_offset(slower, 2), until)));
+
+    // structural changes: rejected, the model is left as it was
+    for (int change = 0; change < 3; ++change) {
+        CesfamConfig other = cfg;
+        if (change == 0) other.medical_staff.doctors = 4;
+        if (change == 1) other.medical_staff.routing = RoutingPolicy::ShortestQueue;
+        if (change == 2) other.followup.delay = 0.0;
+        bool threw = false;
+        try {
+            sim.reset(other);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        CESFAM_CHECK(threw);
+    }
+    sim.reset(0u);
+    CESFAM_CHECK(same_run(sim.run(until), run_replication(slower, until)));
+
+    // independent instances, one thread each
+    std::vector<KpiSummary> got(4);
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < got.size(); ++i) {
+        threads.emplace_back([&, i] {
+            Simulation own(cfg);
+            for (unsigned rep = 0; rep < 3; ++rep) {
+                own.reset(i);
+                got[i] = own.run(until);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (unsigned i = 0; i < got.size(); ++i) CESFAM_CHECK(same_run(got[i], expected[i]));
+
+    // a journey table records one run: reset is refused, the table is kept
+    const std::string table = (std::filesystem::temp_directory_path()
+                               / ("cesfam_sim_journey_" + std::to_string(::getpid()) + ".jt")).string();
+    CesfamConfig journey = cfg;
+    journey.journey = std::make_shared<JourneyWriter>(table, 64);
+    Simulation once(journey);
+    once.run(until);
+    const std::size_t rows = journey.journey->rows();
+    CESFAM_CHECK(rows > 0);
+    for (int how = 0; how < 2; ++how) {
+        bool threw = false;
+        try {
+            if (how == 0) once.reset(1u);
+            else once.reset(journey);
+        } catch (const std::logic_error&) {
+            threw = true;
+        }
+        CESFAM_CHECK(threw);
+    }
+    CESFAM_CHECK(once.run(until).ra == expected[0].ra && journey.journey->rows() == rows);
+    journey.journey->close();
+    std::filesystem::remove(table);
+}
+
+bool same_patient(const Patient& a, const Patient& b) {
+    return a.hora_llegada == b.hora_llegada && a.hora_atencion == b.hora_atencion && a.hora_salida == b.hora_salida
+        && a.id_paciente == b.id_paciente && a.medico_asignado == b.medico_asignado && a.edad == b.edad
+        && a.followups_done == b.followups_done && a.nivel_riesgo == b.nivel_riesgo && a.estado == b.estado
+        && a.resultado == b.resultado;
+}
+
+bool same_patients(const std::vector<Patient>& a, const std::vector<Patient>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), same_patient);
+}
+
+bool same_summary(const KpiSummary& a, const KpiSummary& b) {
+    auto same_wait = [](const WaitStats& x, const WaitStats& y) {
+        return x.n == y.n && x.mean == y.mean && x.p90 == y.p90 && x.max == y.max;
+    };
+    if (a.altas != b.altas || a.derivados != b.derivados || a.diverged != b.diverged || a.stopped_at != b.stopped_at) return false;
+    if (!same_run(a, b) || !same_wait(a.wait, b.wait)) return false;
+    for (std::size_t r = 0; r < a.wait_by_risk.size(); ++r) {
+        if (!same_wait(a.wait_by_risk[r], b.wait_by_risk[r])) return false;
+    }
+    return true;
+}
+
+std::string file_bytes(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// ---------------------------------------------------------------------------
+// ResultCache: a stored run reads back byte for byte; a different seed,
+// horizon, arrivals file, shift calendar or model version misses; a run
+// through ReplicationRunner is served from the cache the second time; an
+// entry whose last write fails is not renamed into place; and a directory
+// that can't be created disables the cache.
+// ---------------------------------------------------------------------------
+void test_result_cache() {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / ("cesfam_cache_test_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const double until = 20000.0;
+
+    const std::string arrivals = (dir / "arrivals.csv").string();
+    auto write_arrivals = [&](double spacing) {
+        std::ofstream f(arrivals);
+        f << "time,edad,riesgo\n";
+        const char* risk[] = {"alto", "medio", "bajo"};
+        for (int i = 0; i < 80; ++i) f << spacing * i << "," << 60 + i % 30 << "," << risk[i % 3] << "\n";
+    };
+    write_arrivals(120.0);
+
+    CesfamConfig cfg = overloaded(2);
+    cfg.generator.arrivals_csv_path = arrivals;
+    cfg.medical_staff.patience_mean = 900.0;
+    Simulation sim(cfg);
+    const KpiSummary k = sim.run(until);
+    const ExitLog exits = sim.exits();
+    CESFAM_CHECK(!exits.ra.empty() && !exits.ab.empty());
+
+    ResultCache cache((dir / "store").string(), "test-v1");
+    const std::string key = describe_run(cfg, until);
+    CESFAM_CHECK(!key.empty());
+    KpiSummary got;
+    ExitLog got_exits;
+    CESFAM_CHECK(!cache.load(key, got, &got_exits));
+    cache.store(key, k, exits);
+    CESFAM_CHECK(cache.load(key, got, &got_exits));
+    CESFAM_CHECK(same_summary(got, k));
+    CESFAM_CHECK(same_patients(got_exits.ra, exits.ra));
+    CESFAM_CHECK(same_patients(got_exits.rc, exits.rc));
+    CESFAM_CHECK(same_patients(got_exits.ab, exits.ab));
+    CESFAM_CHECK(cache.hits() == 1 && cache.misses() == 1);
+
+    // the same run stored twice writes the same bytes (no struct padding)
+    {
+        ResultCache twin((dir / "twin").string(), "test-v1");
+        twin.store(key, k, exits);
+        detail::Hash128 h;
+        h.update(key);
+        const std::string name = h.hex() + ".res";
+        CESFAM_CHECK(file_bytes(cache.directory() / name) == file_bytes(twin.directory() / name));
+    }
+
+    auto misses = [&](const std::string& other) {
+        KpiSummary unused;
+        return !other.empty() && other != key && !cache.load(other, unused);
+    };
+    CESFAM_CHECK(misses(describe_run(with_seed_offset(cfg, 1), until)));
+    CESFAM_CHECK(misses(describe_run(cfg, until + 1.0)));
+
+    ShiftCalendar day;
+    day.entries = {{0.0, 2}, {7200.0, 3}};
+    CesfamConfig shifted = cfg;
+    shifted.medical_staff.shifts = std::make_shared<const ShiftCalendar>(day);
+    const std::string shifted_key = describe_run(shifted, until);
+    CESFAM_CHECK(misses(shifted_key));
+    cache.store(shifted_key, k, exits);
+    day.entries[1].doctors = 4;
+    shifted.medical_staff.shifts = std::make_shared<const ShiftCalendar>(day);
+    CESFAM_CHECK(misses(describe_run(shifted, until)));
+
+    write_arrivals(121.0);   // same path, new contents
+    CESFAM_CHECK(misses(describe_run(cfg, until)));
+    write_arrivals(120.0);
+    CESFAM_CHECK(cache.load(describe_run(cfg, until), got));
+
+    ResultCache rebuilt((dir / "store").string(), "test-v2");
+    CESFAM_CHECK(!rebuilt.load(key, got));
+
+    // through the runners: the second run is read back, not simulated
+    CesfamConfig cached = cfg;
+    cached.cache = std::make_shared<ResultCache>((dir / "runs").string(), "test-v1");
+    ReplicationRunner first, second;
+    const KpiSummary simulated = first.run(cached, until);
+    const KpiSummary served = second.run(cached, until);
+    CESFAM_CHECK(same_run(simulated, k) && same_run(served, k));
+    CESFAM_CHECK(cached.cache->hits() == 1 && second.builds() == 0);
+
+    // a final flush that fails leaves no entry behind
+    if (fs::exists("/dev/full")) {
+        ResultCache full((dir / "full").string(), "test-v1");
+        const std::string small = describe_run(with_seed_offset(cfg, 2), until);
+        detail::Hash128 h;
+        h.update(small);
+        const fs::path entry = full.directory() / (h.hex() + ".res");
+        std::ostringstream tmp;
+        tmp << entry.string() << ".tmp." << ::getpid() << "." << std::hash<std::thread::id>{}(std::this_thread::get_id());
+        fs::create_symlink("/dev/full", tmp.str());
+        full.store(small, k, ExitLog{});   // fits in the stream buffer: only close() writes
+        CESFAM_CHECK(!fs::exists(fs::symlink_status(entry)));
+        CESFAM_CHECK(!fs::exists(fs::symlink_status(tmp.str())));
+    }
+
+    // a directory that can't be created (its parent is a file) disables the
+    // cache instead of throwing
+    std::ofstream((dir / "file").string()) << "not a directory\n";
+    const std::string blocked = (dir / "file" / "cache").string();
+    ResultCache broken(blocked, "test-v1");
+    CESFAM_CHECK(static_cast<bool>(broken.error()));
+    broken.store(key, k, exits);
+    CESFAM_CHECK(!broken.load(key, got));
+    CESFAM_CHECK(open_result_cache(blocked) == nullptr);
+
+    fs::remove_all(dir);
+}
+
+// ---------------------------------------------------------------------------
+// Live feed: the multi-run drivers refuse a stream their runs would share.
+// ---------------------------------------------------------------------------
+void test_live_feed_rejected() {
+    CesfamConfig cfg = overloaded(2);
+    cfg.generator.arrivals_stream_path = "-";
+
+    bool threw = false;
+    try {
+        WhatIfFork fork(cfg);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CESFAM_CHECK(threw);
+
+    threw = false;
+    WhatIfFork fork(overloaded(2));
+    const auto snap = fork.run_prefix(600.0);
+    try {
+        fork.run_branches(snap, {{"live", cfg}}, 1200.0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CESFAM_CHECK(threw);
+
+    threw = false;
+    try {
+        RareEventSplitter splitter(cfg, RareEventConfig{});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CESFAM_CHECK(threw);
+}
+
+// ---------------------------------------------------------------------------
+// Rare events: a threshold at or past the horizon is rejected, and a risk no
+// patient has is reported through risk_runs instead of passing as P = 0.
+// ---------------------------------------------------------------------------
+void test_rare_event_guards() {
+    const CesfamConfig cfg = overloaded(2);   // default_age 70: every patient is medio
+    RareEventConfig rc;
+    rc.until = 3600.0;
+    rc.threshold = rc.until;
+    bool threw = false;
+    try {
+        RareEventSplitter splitter(cfg, rc);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CESFAM_CHECK(threw);
+
+    rc.threshold = 1200.0;
+    rc.levels = 1;
+    rc.effort = 4;
+    rc.threads = 1;
+    rc.risk = RiskLevel::Alto;
+    const RareEventResult none = RareEventSplitter(cfg, rc).run();
+    CESFAM_CHECK(none.risk_runs == 0 && none.probability == 0.0);
+    rc.risk = RiskLevel::Medio;
+    CESFAM_CHECK(RareEventSplitter(cfg, rc).run().risk_runs == 4);
+}
+
+} // namespace
+
+int main() {
+    test_fork();
+    test_fork_shortest_queue();
+    test_oldest_wait_shifts();
+    test_runner_reuse();
+    test_simulation();
+    test_live_feed_rejected();
+    test_rare_event_guards();
+    test_result_cache();
+
+    const auto& c = cesfam::testing::check_counter();
+    std::cout << "Model tests: " << c.checks << " checks, " << c.failures << " failed\n";
+    return c.failures == 0 ? 0 : 1;
+}
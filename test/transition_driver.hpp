@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "utils/cadmium_includes.hpp"
+
+namespace cesfam::testing {
+
+/// Drives one atomic model directly, without a coordinator: scripted input
+/// bags go into its input ports, and output() / the transition functions are
+/// called exactly as a Cadmium simulator would (output before an internal or
+/// confluent transition, input ports cleared afterwards). Outputs accumulate
+/// on the model's output ports until take(). Nothing is logged or allocated
+/// per step beyond what the model itself does, so tests can afford millions
+/// of transitions.
+template <class M>
+class TransitionDriver {
+  public:
+    explicit TransitionDriver(std::shared_ptr<M> model, double t0 = 0.0)
+    : model_(std::move(model))
+    , last_(t0)
+    {}
+
+    M& model() { return *model_; }
+    const auto& state() const { return model_->getState(); }
+
+    /// Time of the last transition.
+    double now() const { return last_; }
+
+    /// Absolute time of the next internal event.
+    double time_next() const { return last_ + atomic().timeAdvance(); }
+
+    std::size_t transitions() const { return transitions_; }
+
+    /// Adds `msg` to the input bag delivered by the next external().
+    template <typename T>
+    void inject(const cadmium::Port<T>& port, T msg) {
+        port->addMessage(std::move(msg));
+    }
+
+    /// Delivers the pending input bags at absolute time `t`. At t ==
+    /// time_next() this is a confluent transition (outputs are produced first).
+    void external(double t) {
+        const double tn = time_next();
+        if (t < last_ || t > tn) throw std::logic_error("TransitionDriver::external: t outside [now, time_next]");
+        if (t == tn) {
+            atomic().output();
+            atomic().confluentTransition(t - last_);
+        } else {
+            atomic().externalTransition(t - last_);
+        }
+        for (const auto& p : model_->getInPorts()) p->clear();
+        last_ = t;
+        ++transitions_;
+    }
+
+    /// Executes the next internal event. Returns false if the model is passive.
+    bool internal() {
+        const double tn = time_next();
+        if (tn == std::numeric_limits<double>::infinity()) return false;
+        atomic().output();
+        atomic().internalTransition();
+        last_ = tn;
+        ++transitions_;
+        return true;
+    }
+
+    /// Executes internal events while time_next() <= t (or < t when
+    /// `inclusive` is false, leaving an event at t for a confluent external).
+    std::size_t run_until(double t, bool inclusive = true) {
+        std::size_t n = 0;
+        for (double tn = time_next(); inclusive ? tn <= t : tn < t; tn = time_next()) {
+            if (!internal()) break;
+            ++n;
+        }
+        return n;
+    }
+
+    /// Messages produced on `port` since the last take() of that port.
+    template <typename T>
+    std::vector<T> take(const cadmium::Port<T>& port) {
+        std::vector<T> out(port->getBag().begin(), port->getBag().end());
+        port->clear();
+        return out;
+    }
+
+  private:
+    // The models override the state-taking overloads, which hide these.
+    cadmium::AtomicInterface& atomic() const { return *model_; }
+
+    std::shared_ptr<M> model_;
+    double last_ = 0.0;
+    std::size_t transitions_ = 0;
+};
+
+/// Minimal assertion bookkeeping for the property tests.
+struct CheckCounter {
+    std::size_t checks = 0;
+    std::size_t failures = 0;
+};
+
+inline CheckCounter& check_counter() {
+    static CheckCounter c;
+    return c;
+}
+
+inline bool check(bool ok, const char* expr, const char* file, int line) {
+    auto& c = check_counter();
+    ++c.checks;
+    if (!ok) {
+        // report only the first few, a broken property usually fails everywhere
+        if (++c.failures <= 20) std::cerr << file << ":" << line << ": CHECK failed: " << expr << "\n";
+    }
+    return ok;
+}
+
+} // namespace cesfam::testing
+
+#define CESFAM_CHECK(expr) ::cesfam::testing::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
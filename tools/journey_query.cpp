@@ -0,0 +1,217 @@
+// Group-by aggregates over a journey table (memory-mapped, blocks decoded in parallel).
+//
+// Usage: CESFAM_JOURNEY <table> [group_by=riesgo] [threads=hardware] [sep=;]
+//   group_by: comma-separated subset of riesgo, medico, hora, resultado, followups
+//   (hora = floor(hora_llegada / 3600)). Prints one CSV row per group.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/journey_table.hpp"
+#include "utils/worker_pool.hpp"
+
+using namespace cesfam;
+
+enum class GroupKey { Riesgo, Medico, Hora, Resultado, Followups };
+
+static bool parse_key(const std::string& s, GroupKey& k) {
+    if (s == "riesgo") k = GroupKey::Riesgo;
+    else if (s == "medico") k = GroupKey::Medico;
+    else if (s == "hora") k = GroupKey::Hora;
+    else if (s == "resultado") k = GroupKey::Resultado;
+    else if (s == "followups") k = GroupKey::Followups;
+    else return false;
+    return true;
+}
+
+static const char* key_name(GroupKey k) {
+    switch (k) {
+        case GroupKey::Riesgo: return "riesgo";
+        case GroupKey::Medico: return "medico";
+        case GroupKey::Hora: return "hora";
+        case GroupKey::Resultado: return "resultado";
+        default: return "followups";
+    }
+}
+
+struct Agg {
+    std::uint64_t n = 0;
+    double espera_sum = 0.0;
+    double espera_max = 0.0;
+    double atencion_sum = 0.0;
+    std::uint64_t followups_sum = 0;
+
+    void merge(const Agg& o) {
+        n += o.n;
+        espera_sum += o.espera_sum;
+        espera_max = std::max(espera_max, o.espera_max);
+        atencion_sum += o.atencion_sum;
+        followups_sum += o.followups_sum;
+    }
+};
+
+// Up to four group keys packed into one integer: riesgo and resultado take
+// their byte, the other keys share the remaining bits (at least 16 each). A
+// value that doesn't fit its width is an error, never a merged group.
+using Groups = std::unordered_map<std::uint64_t, Agg>;
+
+static int key_bits(GroupKey k, const std::vector<GroupKey>& keys) {
+    auto narrow = [](GroupKey g) { return g == GroupKey::Riesgo || g == GroupKey::Resultado; };
+    if (narrow(k)) return 8;
+    const auto n_narrow = std::count_if(keys.begin(), keys.end(), narrow);
+    const auto n_wide = static_cast<std::ptrdiff_t>(keys.size()) - n_narrow;
+    return static_cast<int>(std::min<std::ptrdiff_t>(48, (64 - 8 * n_narrow) / n_wide));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <table> [group_by=riesgo] [threads=hardware] [sep=;]\n";
+        return 1;
+    }
+    const std::string path = argv[1];
+    const std::string group_by = argc >= 3 ? argv[2] : "riesgo";
+    const std::string sep = argc >= 5 ? argv[4] : ";";
+
+    unsigned threads = std::thread::hardware_concurrency();
+    if (argc >= 4) {
+        const std::string s = argv[3];
+        char* end = nullptr;
+        errno = 0;
+        const long n = std::strtol(s.c_str(), &end, 10);
+        if (s.empty() || *end != '\0' || errno == ERANGE || n < 0 || n > std::numeric_limits<int>::max()) {
+            std::cerr << "[ERROR] threads must be a non-negative integer (0 = hardware): " << s << "\n";
+            return 1;
+        }
+        threads = static_cast<unsigned>(n);
+    }
+
+    std::vector<GroupKey> keys;
+    {
+        std::stringstream ss(group_by);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            GroupKey k;
+            if (!parse_key(item, k)) {
+                std::cerr << "[ERROR] Unknown group_by key: " << item << "\n";
+                return 1;
+            }
+            keys.push_back(k);
+        }
+        if (keys.size() > 4) {
+            std::cerr << "[ERROR] At most 4 group_by keys\n";
+            return 1;
+        }
+    }
+    auto uses = [&](GroupKey k) { return std::find(keys.begin(), keys.end(), k) != keys.end(); };
+    std::vector<int> bits(keys.size()), shift(keys.size());
+    for (std::size_t i = keys.size(), at = 0; i-- > 0;) {
+        bits[i] = key_bits(keys[i], keys);
+        shift[i] = static_cast<int>(at);
+        at += static_cast<std::size_t>(bits[i]);
+    }
+
+    try {
+        const auto t0 = std::chrono::steady_clock::now();
+        JourneyFile table(path);
+        const auto& blocks = table.blocks();
+
+        WorkerPool pool(threads);
+        const std::size_t workers = std::max<std::size_t>(1, std::min<std::size_t>(pool.size(), blocks.size()));
+        std::vector<Groups> partial(workers);
+
+        // Each worker takes a contiguous range of blocks and decodes only the
+        // columns the query needs.
+        pool.parallel_for(workers, [&](std::size_t w) {
+            Groups& groups = partial[w];
+            std::vector<double> espera, atencion, llegada;
+            std::vector<std::int64_t> medico, followups;
+            const std::size_t first = blocks.size() * w / workers;
+            const std::size_t last = blocks.size() * (w + 1) / workers;
+
+            for (std::size_t b = first; b < last; ++b) {
+                const auto& blk = blocks[b];
+                JourneyFile::doubles(blk, JourneyColumn::Espera, espera);
+                JourneyFile::doubles(blk, JourneyColumn::TiempoAtencion, atencion);
+                JourneyFile::ints(blk, JourneyColumn::Followups, followups);
+                if (uses(GroupKey::Hora)) JourneyFile::doubles(blk, JourneyColumn::Llegada, llegada);
+                if (uses(GroupKey::Medico)) JourneyFile::ints(blk, JourneyColumn::Medico, medico);
+                const std::uint8_t* riesgo = JourneyFile::bytes(blk, JourneyColumn::Riesgo);
+                const std::uint8_t* resultado = JourneyFile::bytes(blk, JourneyColumn::Resultado);
+
+                std::uint64_t last_key = ~0ULL;
+                Agg* agg = nullptr;
+                for (std::size_t i = 0; i < blk.rows; ++i) {
+                    std::uint64_t key = 0;
+                    for (std::size_t j = 0; j < keys.size(); ++j) {
+                        std::uint64_t v = 0;
+                        switch (keys[j]) {
+                            case GroupKey::Riesgo: v = riesgo[i]; break;
+                            case GroupKey::Resultado: v = resultado[i]; break;
+                            case GroupKey::Medico: v = static_cast<std::uint64_t>(medico[i] + 1); break;
+                            case GroupKey::Hora: v = static_cast<std::uint64_t>(std::max(0.0, std::floor(llegada[i] / 3600.0))); break;
+                            case GroupKey::Followups: v = static_cast<std::uint64_t>(followups[i]); break;
+                        }
+                        if (v >> bits[j]) {
+                            throw std::runtime_error(std::string("group_by ") + key_name(keys[j]) + " value doesn't fit in "
+                                                     + std::to_string(bits[j]) + " bits (fewer group_by keys leave it more)");
+                        }
+                        key |= v << shift[j];
+                    }
+                    if (key != last_key) {
+                        agg = &groups[key];
+                        last_key = key;
+                    }
+                    ++agg->n;
+                    agg->espera_sum += espera[i];
+                    agg->espera_max = std::max(agg->espera_max, espera[i]);
+                    agg->atencion_sum += atencion[i];
+                    agg->followups_sum += static_cast<std::uint64_t>(followups[i]);
+                }
+            }
+        });
+
+        std::map<std::uint64_t, Agg> merged;
+        for (const auto& g : partial) {
+            for (const auto& [k, a] : g) merged[k].merge(a);
+        }
+
+        for (GroupKey k : keys) std::cout << key_name(k) << sep;
+        std::cout << "visits" << sep << "espera_mean_s" << sep << "espera_max_s" << sep << "atencion_mean_s"
+                  << sep << "followups_mean\n";
+        for (const auto& [packed, a] : merged) {
+            for (std::size_t i = 0; i < keys.size(); ++i) {
+                const std::uint64_t v = (packed >> shift[i]) & ((1ULL << bits[i]) - 1);
+                switch (keys[i]) {
+                    case GroupKey::Riesgo: std::cout << to_string(static_cast<RiskLevel>(v)); break;
+                    case GroupKey::Resultado: std::cout << to_string(static_cast<AttentionResult>(v)); break;
+                    case GroupKey::Medico: std::cout << static_cast<std::int64_t>(v) - 1; break;
+                    default: std::cout << v; break;
+                }
+                std::cout << sep;
+            }
+            const double n = static_cast<double>(a.n);
+            std::cout << a.n << sep << a.espera_sum / n << sep << a.espera_max << sep << a.atencion_sum / n
+                      << sep << static_cast<double>(a.followups_sum) / n << "\n";
+        }
+
+        std::cerr << table.rows() << " rows, " << blocks.size() << " blocks, " << table.bytes() << " bytes in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() << " s\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Live progress of a running CESFAM_V2 (live.shm), read from its shared memory
+// segment without touching the simulation.
+//
+// Usage: CESFAM_MONITOR [name=/cesfam_live] [interval_ms=1000] [doctors=0]
+//   Prints one line per interval until the run ends; `doctors` > 0 adds the
+//   longest queues (doctor:queue, * = busy).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+
+#include "utils/live_metrics.hpp"
+
+using namespace cesfam;
+
+int main(int argc, char** argv) {
+    const std::string name = argc > 1 ? argv[1] : "/cesfam_live";
+    const int interval_ms = std::max(1, argc > 2 ? std::atoi(argv[2]) : 1000);
+    const int top = std::max(0, argc > 3 ? std::atoi(argv[3]) : 0);
+    const auto interval = std::chrono::milliseconds(interval_ms);
+
+    // the run may not have created the segment yet
+    std::unique_ptr<LiveMetricsReader> reader;
+    for (int tries = 0; !reader; ++tries) {
+        try {
+            reader = std::make_unique<LiveMetricsReader>(name);
+        } catch (const std::exception& e) {
+            if (tries == 0) std::cerr << "[INFO] " << e.what() << ", waiting...\n";
+            std::this_thread::sleep_for(interval);
+        }
+    }
+
+    LiveSample s;
+    std::vector<int> order(static_cast<std::size_t>(reader->doctors()));
+    std::cout << std::fixed << std::setprecision(1);
+    while (true) {
+        if (!reader->read(s)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        const std::size_t busy = static_cast<std::size_t>(std::count(s.busy.begin(), s.busy.end(), 1));
+        const std::uint64_t queued = std::accumulate(s.queue.begin(), s.queue.end(), std::uint64_t{0});
+        std::cout << "t=" << s.time << " events=" << s.events << " ev/s=" << s.events_per_sec
+                  << " RA=" << s.ra << " RC=" << s.rc
+                  << " busy=" << busy << "/" << s.busy.size() << " queued=" << queued;
+        if (top > 0) {
+            std::iota(order.begin(), order.end(), 0);
+            const std::size_t k = std::min(order.size(), static_cast<std::size_t>(top));
+            std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(k), order.end(),
+                              [&](int a, int b) { return s.queue[static_cast<std::size_t>(a)] > s.queue[static_cast<std::size_t>(b)]; });
+            std::cout << " top:";
+            for (std::size_t i = 0; i < k; ++i) {
+                const auto d = static_cast<std::size_t>(order[i]);
+                std::cout << " " << d << ":" << s.queue[d] << (s.busy[d] ? "*" : "");
+            }
+        }
+        std::cout << std::endl;
+
+        // the writer clears `running` when it finishes; a killed one doesn't
+        if (!s.running) break;
+        if (::kill(static_cast<pid_t>(s.writer_pid), 0) != 0) {
+            std::cerr << "[WARN] writer process " << s.writer_pid << " is gone\n";
+            break;
+        }
+        std::this_thread::sleep_for(interval);
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "data_structures/patient.hpp"
+#include "utils/csv_arrivals.hpp"
+#include "top_model/cesfam.hpp"
+
+namespace cesfam {
+
+/// External arrival rate and risk mix (fractions indexed by RiskLevel; the
+/// Unknown slot is always 0 because GestorCasos classifies on entry).
+struct ArrivalProfile {
+    double rate = 0.0;                       // patients / second
+    std::array<double, 4> mix{};
+};
+
+/// Same age heuristic GestorCasos applies to unclassified patients.
+inline RiskLevel risk_from_age(int edad) {
+    if (edad >= 80) return RiskLevel::Alto;
+    if (edad >= 70) return RiskLevel::Medio;
+    return RiskLevel::Bajo;
+}
+
+/// A live feed (arrivals.stream) can't be read ahead: its nominal rate is
+/// taken from arrivals.rate.
+inline ArrivalProfile arrival_profile(const GeneratorConfig& g) {
+    ArrivalProfile a;
+    if (g.arrivals_csv_path.empty() || !g.arrivals_stream_path.empty()) {
+        a.rate = std::max(0.0, g.arrivals_rate);
+        a.mix[static_cast<std::size_t>(risk_from_age(g.default_age))] = 1.0;
+        return a;
+    }
+
+    const auto schedule = read_arrivals_csv(g.arrivals_csv_path);
+    if (schedule.empty()) return a;
+    for (const auto& ev : schedule) {
+        RiskLevel r = ev.riesgo;
+        if (r == RiskLevel::Unknown) r = risk_from_age(ev.edad > 0 ? ev.edad : g.default_age);
+        a.mix[static_cast<std::size_t>(r)] += 1.0;
+    }
+    for (auto& m : a.mix) m /= static_cast<double>(schedule.size());
+
+    // Mean rate over the schedule (n arrivals spread over n mean inter-arrival gaps).
+    const double span = schedule.back().time - schedule.front().time;
+    const double n = static_cast<double>(schedule.size());
+    a.rate = span > 0.0 ? (n - 1.0) / span : 0.0;
+    return a;
+}
+
+/// Steady-state estimate of the CESFAM flow as an open queueing network:
+/// Poisson arrivals -> consent gate -> c exponential doctors -> adherence
+/// feedback (truncated at max_followups) back to the consent gate.
+struct AnalyticEstimate {
+    double lambda_external = 0.0;   // patients / second entering from outside
+    double lambda_doctors = 0.0;    // visits / second reaching the doctors
+    double visits_per_patient = 0.0;
+
+    double throughput_ra = 0.0;     // exits / second after the adherence decision
+    double throughput_rc = 0.0;     // exits / second at the consent gate
+
+    int doctors = 0;                // c: router.doctors, or the calendar's mean staff on duty
+    double utilization = 0.0;       // rho = lambda_doctors / (c mu)
+    bool stable = false;
+
+    // Doctor stage: one shared queue (M/M/c), c independent queues fed by an
+    // even Poisson split (M/M/1 x c), and c queues fed by a cyclic split of a
+    // Poisson stream (E_c/M/1 x c, exactly what the round-robin router does).
+    double wq_mmc = 0.0;            // mean wait, seconds
+    double wq_p90_mmc = 0.0;
+    double wq_mm1 = 0.0;
+    double wq_p90_mm1 = 0.0;
+    double wq_rr = 0.0;
+    double wq_p90_rr = 0.0;
+
+    // Wait of the model matching the configured routing policy.
+    double wq = 0.0;
+    double wq_p90 = 0.0;
+    double sojourn = 0.0;           // wq + service mean
+};
+
+/// Erlang C probability of waiting for c servers and offered load a = lambda/mu
+/// (computed through the Erlang B recursion, stable for large c).
+inline double erlang_c(int c, double a) {
+    if (c <= 0) return 1.0;
+    const double rho = a / c;
+    if (rho >= 1.0) return 1.0;
+    double b = 1.0;
+    for (int k = 1; k <= c; ++k) b = a * b / (k + a * b);
+    return b / (1.0 - rho * (1.0 - b));
+}
+
+/// GI/M/1 root sigma = A*(mu (1 - sigma)) for Erlang(c, lambda) inter-arrivals,
+/// i.e. one doctor receiving every c-th patient of a Poisson(lambda) stream.
+inline double erlang_split_sigma(int c, double lambda, double mu) {
+    double sigma = lambda / (c * mu);
+    for (int it = 0; it < 1000; ++it) {
+        const double next = std::pow(lambda / (lambda + mu * (1.0 - sigma)), c);
+        if (std::abs(next - sigma) < 1e-13) return next;
+        sigma = next;
+    }
+    return sigma;
+}
+
+inline AnalyticEstimate estimate_queueing_network(const CesfamConfig& cfg, const ArrivalProfile& arrivals) {
+    AnalyticEstimate e;
+    const double inf = std::numeric_limits<double>::infinity();
+
+    const double a = std::clamp(cfg.case_manager.consent_p_accept, 0.0, 1.0);
+    const int k_max = std::max(0, cfg.adherence.max_followups);
+
+    // Per external arrival: doctor visits V, consent-gate entries E, RA exits.
+    double visits = 0.0, entries = 0.0, ra = 0.0;
+    for (std::size_t r = 1; r < arrivals.mix.size(); ++r) {
+        if (arrivals.mix[r] <= 0.0) continue;
+        double mult = 1.0;
+        switch (static_cast<RiskLevel>(r)) {
+            case RiskLevel::Alto:  mult = cfg.adherence.mult_alto; break;
+            case RiskLevel::Medio: mult = cfg.adherence.mult_medio; break;
+            case RiskLevel::Bajo:  mult = cfg.adherence.mult_bajo; break;
+            default: break;
+        }
+        const double p = std::clamp(cfg.adherence.p_continue_base * mult, 0.0, 1.0);
+        const double q = p * a;   // a visit leads to another visit
+
+        double v = 0.0, qk = 1.0;
+        for (int k = 0; k <= k_max; ++k) {
+            v += qk;
+            qk *= q;
+        }
+        v *= a;
+
+        const double returns = (k_max > 0) ? p * (v - a * std::pow(q, k_max)) : 0.0;
+        visits += arrivals.mix[r] * v;
+        entries += arrivals.mix[r] * (1.0 + returns);
+        ra += arrivals.mix[r] * (v - returns);
+    }
+
+    e.lambda_external = arrivals.rate;
+    e.visits_per_patient = visits;
+    e.lambda_doctors = arrivals.rate * visits;
+    e.throughput_ra = arrivals.rate * ra;
+    e.throughput_rc = arrivals.rate * entries * (1.0 - a);
+
+    // With a shift calendar router.doctors is ignored: use the long-run
+    // (time-averaged) staff on duty.
+    const auto& staff = cfg.medical_staff;
+    const int c = std::max(1, staff.shifts ? static_cast<int>(std::lround(staff.shifts->mean_doctors())) : staff.doctors);
+    e.doctors = c;
+    const double s = cfg.medical_staff.service_mean;
+    if (s <= 0.0) {
+        e.stable = true;
+        return e;
+    }
+    const double mu = 1.0 / s;
+    const double lambda = e.lambda_doctors;
+
+    e.utilization = lambda / (c * mu);
+    e.stable = e.utilization < 1.0;
+
+    if (!e.stable) {
+        e.wq_mmc = e.wq_p90_mmc = e.wq_mm1 = e.wq_p90_mm1 = e.wq_rr = e.wq_p90_rr = inf;
+    } else {
+        // M/M/c: P(Wq > t) = C exp(-(c mu - lambda) t)
+        const double pc = erlang_c(c, lambda / mu);
+        const double drain = c * mu - lambda;
+        e.wq_mmc = pc / drain;
+        e.wq_p90_mmc = pc > 0.1 ? std::log(pc / 0.1) / drain : 0.0;
+
+        // M/M/1 per doctor with lambda/c: P(Wq > t) = rho exp(-(mu - lambda/c) t)
+        const double rho = e.utilization;
+        const double drain1 = mu - lambda / c;
+        e.wq_mm1 = rho / drain1;
+        e.wq_p90_mm1 = rho > 0.1 ? std::log(rho / 0.1) / drain1 : 0.0;
+
+        // E_c/M/1 per doctor: P(Wq > t) = sigma exp(-mu (1 - sigma) t)
+        const double sigma = erlang_split_sigma(c, lambda, mu);
+        const double drain_rr = mu * (1.0 - sigma);
+        e.wq_rr = sigma / drain_rr;
+        e.wq_p90_rr = sigma > 0.1 ? std::log(sigma / 0.1) / drain_rr : 0.0;
+    }
+
+    if (cfg.medical_staff.routing == RoutingPolicy::ShortestQueue) {
+        e.wq = e.wq_mmc;
+        e.wq_p90 = e.wq_p90_mmc;
+    } else {
+        e.wq = e.wq_rr;
+        e.wq_p90 = e.wq_p90_rr;
+    }
+    e.sojourn = e.wq + s;
+    return e;
+}
+
+inline AnalyticEstimate estimate_queueing_network(const CesfamConfig& cfg) {
+    return estimate_queueing_network(cfg, arrival_profile(cfg.generator));
+}
+
+} // namespace cesfam
@@ -1,61 +1,353 @@
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
 #include <string>
 #include <memory>
+#include <vector>
+#include <utility>
 
 #include "utils/cadmium_includes.hpp"
+#include "utils/arena.hpp"
+#include "utils/live_metrics.hpp"
 #include "data_structures/patient.hpp"
 
 #include "atomics/generator.hpp"
 #include "atomics/case_manager.hpp"
 #include "atomics/adherence.hpp"
+#include "atomics/followup.hpp"
+#include "atomics/recorder.hpp"
+#include "atomics/journey_recorder.hpp"
 #include "coupled/medical_staff.hpp"
 
 namespace cesfam {
 
+class ResultCache;   // top_model/result_cache.hpp
+
 struct CesfamConfig {
     GeneratorConfig generator;
     CaseManagerConfig case_manager;
     MedicalStaffConfig medical_staff;
     AdherenceConfig adherence;
+    FollowupConfig followup;   // followup.delay > 0 adds the appointment scheduler on the DA loop
+
+    // Optional in-memory record of RA/RC exits (nullptr = no recorder)
+    std::shared_ptr<ExitLog> exits;
+
+    // Optional per-visit journey table (nullptr = not written)
+    std::shared_ptr<JourneyWriter> journey;
+
+    // Optional arena for the atomic state containers (nullptr = heap). Only
+    // release it once the model is gone (see RunArena).
+    std::shared_ptr<RunArena> arena;
+
+    // Optional shared-memory segment with live figures for external monitors
+    // (nullptr = none). The run loop must bracket each event instant (see
+    // Stepper::set_live).
+    std::shared_ptr<LiveMetrics> live;
+
+    // Optional on-disk cache of replication results (nullptr = always
+    // simulate). Only the in-memory replication runners use it (see
+    // run_replication); the model itself ignores it.
+    std::shared_ptr<ResultCache> cache;
+};
+
+/// Full model state at an event boundary, used to fork a running simulation.
+/// `exits` is the exit history up to `time`, shared read-only by every fork.
+struct CesfamSnapshot {
+    double time = 0.0;
+    GeneratorState generator;
+    CaseManagerState case_manager;
+    RouterState router;
+    std::vector<DoctorState> doctors;
+    AdherenceState adherence;
+    FollowupState followup;
+    std::shared_ptr<const ExitLog> exits;
 };
 
 class CESFAM : public cadmium::Coupled {
   public:
     cadmium::Port<Patient> Out_PacienteRA;
     cadmium::Port<Patient> Out_PacienteRC;
+    cadmium::Port<Patient> Out_PacienteAB;   // reneged in a doctor queue
 
     explicit CESFAM(std::string id, CesfamConfig cfg)
     : cadmium::Coupled(id)
-    , cfg_(std::move(cfg))
+    , cfg_(with_arena(std::move(cfg)))
     {
         Out_PacienteRA = addOutPort<Patient>("Out_PacienteRA");
         Out_PacienteRC = addOutPort<Patient>("Out_PacienteRC");
+        Out_PacienteAB = addOutPort<Patient>("Out_PacienteAB");
 
         auto gen = addComponent<GeneratorPacientes>("GeneradorPacientes", cfg_.generator);
         auto gestor = addComponent<GestorCasos>("GestorCasos", cfg_.case_manager);
-        auto equipo = addComponent<EquipoMedico>("EquipoMedico", cfg_.medical_staff);
+        if (cfg_.medical_staff.flatten) {
+            flat_staff_.build(*this, cfg_.medical_staff);
+        } else {
+            equipo_ = addComponent<EquipoMedico>("EquipoMedico", cfg_.medical_staff);
+        }
         auto adher = addComponent<AdherenciaDecision>("AdherenciaDecision", cfg_.adherence);
+        gen_ = gen;
+        gestor_ = gestor;
+        adher_ = adher;
 
         // Generator -> Case manager
         addCoupling(gen->Out_pacientes, gestor->In_paciente);
 
-        // Case manager -> Medical staff
-        addCoupling(gestor->Out_pacienteAC, equipo->In_Paciente);
-
-        // Medical staff -> Adherence/decision
-        addCoupling(equipo->Out_Paciente, adher->In_Paciente);
+        // Case manager -> Medical staff -> Adherence/decision. Flattened, the
+        // router and doctors sit on this level: no EquipoMedico coordinator and
+        // no hop through its ports, but every doctor coupling is scanned on
+        // each collection of this level.
+        std::vector<std::shared_ptr<cadmium::PortInterface>> reneged;   // every source of abandonments
+        if (equipo_) {
+            addCoupling(gestor->Out_pacienteAC, equipo_->In_Paciente);
+            addCoupling(equipo_->Out_Paciente, adher->In_Paciente);
+            reneged.push_back(equipo_->Out_Abandono);
+        } else {
+            addCoupling(gestor->Out_pacienteAC, flat_staff_.router()->In_paciente);
+            for (const auto& doc : flat_staff_.doctors()) {
+                addCoupling(doc->Out_Paciente, adher->In_Paciente);
+                reneged.push_back(doc->Out_Abandono);
+            }
+        }
 
-        // Adherence return loop -> Case manager
-        addCoupling(adher->Out_PacienteDA, gestor->In_PacienteDA);
+        // Adherence return loop -> Case manager (through the follow-up agenda
+        // when returns are booked ahead)
+        if (cfg_.followup.delay > 0.0) {
+            auto agenda = addComponent<AgendaControles>("AgendaControles", cfg_.followup);
+            addCoupling(adher->Out_PacienteDA, agenda->In_PacienteDA);
+            addCoupling(agenda->Out_PacienteDA, gestor->In_PacienteDA);
+            agenda_ = agenda;
+        } else {
+            addCoupling(adher->Out_PacienteDA, gestor->In_PacienteDA);
+        }
 
         // Final exits
         addCoupling(adher->Out_PacienteRA, Out_PacienteRA);
         addCoupling(gestor->Out_PacienteRC, Out_PacienteRC);
+        for (const auto& p : reneged) addCoupling(p, Out_PacienteAB);
+
+        if (cfg_.exits) {
+            auto reg = addComponent<RegistroSalidas>("RegistroSalidas", cfg_.exits);
+            addCoupling(adher->Out_PacienteRA, reg->In_PacienteRA);
+            addCoupling(gestor->Out_PacienteRC, reg->In_PacienteRC);
+            for (const auto& p : reneged) addCoupling(p, reg->In_PacienteAB);
+            recorder_ = reg;
+        }
+
+        if (cfg_.journey) {
+            auto visits = addComponent<RegistroVisitas>("RegistroVisitas", cfg_.journey);
+            addCoupling(adher->Out_PacienteDA, visits->In_PacienteDA);
+            addCoupling(adher->Out_PacienteRA, visits->In_PacienteRA);
+        }
+    }
+
+    /// Whether reset(cfg) can reuse this model: same staff structure (size,
+    /// routing policy, layout), same optional recorders,
+    /// follow-up agenda, arena and live metrics segment, and no live arrival feed.
+    bool reusable_for(const CesfamConfig& cfg) const {
+        return staff().same_structure(cfg.medical_staff)
+            && (cfg.followup.delay > 0.0) == static_cast<bool>(agenda_)
+            && static_cast<bool>(cfg.exits) == static_cast<bool>(cfg_.exits)
+            && cfg.journey == cfg_.journey
+            && cfg.arena == cfg_.arena
+            && cfg.live == cfg_.live
+            && cfg.generator.arrivals_stream_path.empty()
+            && cfg_.generator.arrivals_stream_path.empty();
+    }
+
+    /// Loads a new configuration and puts every atomic back in its initial
+    /// state, so the same model (and its coordinator, see Stepper::reset) runs
+    /// another replication without being rebuilt. Requires reusable_for(cfg).
+    void reset(CesfamConfig cfg) {
+        if (!reusable_for(cfg)) throw std::invalid_argument("CESFAM::reset: configuration changes the model structure");
+        cfg_ = with_arena(std::move(cfg));
+        gen_->reset(cfg_.generator);
+        gestor_->reset(cfg_.case_manager);
+        if (equipo_) {
+            equipo_->reset(cfg_.medical_staff);
+        } else {
+            flat_staff_.reset(cfg_.medical_staff);
+        }
+        adher_->reset(cfg_.adherence);
+        if (agenda_) agenda_->reset(cfg_.followup);
+        if (recorder_) recorder_->reset(cfg_.exits);
+    }
+
+    const CesfamConfig& config() const { return cfg_; }
+    /// Router and doctors, wherever they sit (EquipoMedico or, flattened, this model).
+    const StaffComponents& staff() const { return equipo_ ? equipo_->staff() : flat_staff_; }
+    const std::shared_ptr<GeneratorPacientes>& generator() const { return gen_; }
+
+    /// Patients waiting at a doctor (not in service, not reneged) or, while
+    /// nobody is on duty, at the router.
+    std::size_t queued() const {
+        std::size_t n = 0;
+        for (const auto& d : staff().doctors()) n += d->getState().waiting();
+        return n + staff().router()->getState().held.size();
+    }
+
+    /// Patients generated and not yet out (RA, RC or reneged). Needs the exit
+    /// log (cfg.exits); 0 without it.
+    std::size_t in_system() const {
+        if (!cfg_.exits) return 0;
+        const std::size_t generated = static_cast<std::size_t>(gen_->getState().next_id - 1);
+        const std::size_t exited = cfg_.exits->ra.size() + cfg_.exits->rc.size() + cfg_.exits->ab.size();
+        return generated > exited ? generated - exited : 0;
+    }
+
+    /// Copies every atomic state. Only meaningful between event instants
+    /// (e.g. after Stepper::advance_until(t)), with t the current time.
+    CesfamSnapshot snapshot(double t) const {
+        CesfamSnapshot snap;
+        snap.time = t;
+        snap.generator = gen_->getState();
+        snap.case_manager = gestor_->getState();
+        snap.router = staff().router()->getState();
+        snap.doctors.reserve(staff().doctors().size());
+        for (const auto& d : staff().doctors()) snap.doctors.push_back(d->getState());
+        snap.adherence = adher_->getState();
+        if (agenda_) snap.followup = agenda_->getState();
+        if (cfg_.exits) snap.exits = std::make_shared<const ExitLog>(*cfg_.exits);
+        return snap;
+    }
+
+    /// Loads a snapshot into this (freshly built, not yet started) model; start
+    /// the simulation at snap.time afterwards. The configuration may differ from
+    /// the one that produced the snapshot: extra doctors start idle, and the
+    /// patients of removed doctors (or of doctors off duty at snap.time under
+    /// the model's shift calendar) are re-routed at the fork instant, under the
+    /// model's routing policy.
+    void restore(const CesfamSnapshot& snap) {
+        const double t = snap.time;
+
+        auto g = snap.generator;
+        g.now = t;
+        gen_->setState(std::move(g));
+
+        auto c = snap.case_manager;
+        c.now = t;
+        gestor_->setState(std::move(c));
+
+        auto a = snap.adherence;
+        a.now = t;
+        adher_->setState(std::move(a));
+
+        if (agenda_) {
+            auto f = snap.followup;
+            f.now = t;
+            agenda_->setState(std::move(f));
+        } else if (snap.followup.pending() > 0) {
+            throw std::invalid_argument("CESFAM::restore: the snapshot has booked follow-ups and the model has no agenda");
+        }
+
+        const auto& docs = staff().doctors();
+        const std::size_t n = docs.size();
+        const auto& cal = staff().calendar();
+        const int on_duty = cal ? std::min(static_cast<int>(n), cal->calendar().at(t)) : static_cast<int>(n);
+
+        auto r = snap.router;
+        r.now = t;
+        r.on_duty = on_duty;
+        r.rr_index = on_duty > 0 ? r.rr_index % on_duty : 0;
+        std::vector<Patient> orphans;
+        for (auto& p : r.held) orphans.push_back(std::move(p));
+        r.held.clear();
+        for (std::size_t i = static_cast<std::size_t>(on_duty); i < r.out_to_doc.size(); ++i) {
+            for (auto& p : r.out_to_doc[i]) orphans.push_back(std::move(p));
+            r.out_to_doc[i].clear();
+        }
+        r.out_to_doc.resize(n);
+        r.to_send.clear();
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!r.out_to_doc[i].empty()) r.to_send.push_back(static_cast<int>(i));
+        }
+        r.load.assign(n, 0);
+
+        for (std::size_t i = 0; i < snap.doctors.size(); ++i) {
+            auto d = snap.doctors[i];
+            for (auto& p : d.out_relevo) orphans.push_back(std::move(p));
+            d.out_relevo.clear();
+            if (i < n) {
+                d.now = t;
+                d.on_duty = static_cast<int>(i) < on_duty;
+                if (!d.on_duty) {
+                    // Off duty at the fork: its queue waits for a doctor on duty
+                    for (auto h : d.queue_timer) d.wheel.cancel(h);
+                    for (auto& p : d.queue) {
+                        if (p.estado != PatientStatus::Abandono) orphans.push_back(std::move(p));
+                    }
+                    d.queue_head += d.queue.size();
+                    d.queue.clear();
+                    d.queue_timer.clear();
+                    d.abandoned = 0;
+                }
+                r.load[i] = static_cast<int>(d.waiting() + r.out_to_doc[i].size()) + (d.busy ? 1 : 0);
+                docs[i]->setState(std::move(d));
+                continue;
+            }
+            // Removed doctor: its patient in service and its queue (except the
+            // patients that already reneged) wait again.
+            if (d.busy) {
+                d.current.hora_atencion = 0.0;
+                d.current.hora_salida = 0.0;
+                d.current.medico_asignado = -1;
+                d.current.estado = PatientStatus::EnEsperaAtencion;
+                orphans.push_back(std::move(d.current));
+            }
+            for (auto& p : d.queue) {
+                if (p.estado != PatientStatus::Abandono) orphans.push_back(std::move(p));
+            }
+        }
+        // Extra doctors start idle, at the fork instant
+        for (std::size_t i = snap.doctors.size(); i < n; ++i) {
+            auto d = docs[i]->getState();
+            d.now = t;
+            d.on_duty = static_cast<int>(i) < on_duty;
+            docs[i]->setState(std::move(d));
+        }
+
+        for (auto& p : orphans) {
+            p.medico_asignado = -1;
+            if (on_duty == 0) {
+                r.held.push_back(std::move(p));
+                continue;
+            }
+            r.route(cfg_.medical_staff.routing, std::move(p));
+        }
+        staff().router()->setState(std::move(r));
+        if (cal) cal->setState(cal->state_at(t));
+
+        if (recorder_) {
+            RecorderState rs;
+            rs.now = t;
+            recorder_->setState(rs);
+        }
     }
 
   private:
+    // Hands the arena to every atomic that keeps containers in its state,
+    // and the live metrics segment to those that publish to it.
+    static CesfamConfig with_arena(CesfamConfig cfg) {
+        cfg.case_manager.memory = cfg.arena;
+        cfg.medical_staff.memory = cfg.arena;
+        cfg.adherence.memory = cfg.arena;
+        cfg.followup.memory = cfg.arena;
+        cfg.case_manager.live = cfg.live;
+        cfg.medical_staff.live = cfg.live;
+        cfg.adherence.live = cfg.live;
+        return cfg;
+    }
+
     CesfamConfig cfg_;
+
+    std::shared_ptr<GeneratorPacientes> gen_;
+    std::shared_ptr<GestorCasos> gestor_;
+    std::shared_ptr<EquipoMedico> equipo_;     // nullptr when flattened
+    StaffComponents flat_staff_;               // router and doctors when flattened
+    std::shared_ptr<AdherenciaDecision> adher_;
+    std::shared_ptr<AgendaControles> agenda_;
+    std::shared_ptr<RegistroSalidas> recorder_;
 };
 
 } // namespace cesfam
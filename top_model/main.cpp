@@ -1,10 +1,18 @@
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <filesystem>
+#include <chrono>
 
 #include "utils/ini_reader.hpp"
 #include "top_model/cesfam.hpp"
+#include "top_model/params.hpp"
+#include "top_model/analytic.hpp"
+#include "utils/kpi.hpp"
+#include "utils/live_metrics.hpp"
+#include "utils/log_filter.hpp"
+#include "utils/stepper.hpp"
 
 // Cadmium v2 simulation engine + logger
 //
@@ -21,6 +29,19 @@
   #error "Cadmium v2 root coordinator header not found. Check CADMIUM_V2_INCLUDE points to .../cadmium_v2/include"
 #endif
 
+// Parallel root coordinator: only with `make PARALLEL=1` (OpenMP + Cadmium's
+// concurrent execution support). Atomics keep their RNG in the state, so
+// transitions of different models may run concurrently.
+#if defined(CESFAM_PARALLEL)
+  #if __has_include(<cadmium/core/simulation/parallel_root_coordinator.hpp>)
+    #include <cadmium/core/simulation/parallel_root_coordinator.hpp>
+  #elif __has_include(<cadmium/simulation/parallel_root_coordinator.hpp>)
+    #include <cadmium/simulation/parallel_root_coordinator.hpp>
+  #else
+    #error "Cadmium v2 parallel root coordinator header not found (PARALLEL=1 needs a Cadmium v2 with parallel execution)"
+  #endif
+#endif
+
 #if __has_include(<cadmium/core/logger/csv.hpp>)
   #include <cadmium/core/logger/csv.hpp>
 #elif __has_include(<cadmium/simulation/logger/csv.hpp>)
@@ -32,26 +53,41 @@
 // Some Cadmium v2 variants expose setLogger(logger_ptr), others expose
 // setLogger<LoggerType>(args...). We provide a tiny SFINAE-based helper.
 namespace cesfam_compat {
-  template <class Root>
-  auto attach_csv_logger(Root& root, const std::string& file, const std::string& sep, int)
-      -> decltype(root.template setLogger<cadmium::CSVLogger>(file, sep), void()) {
-    root.template setLogger<cadmium::CSVLogger>(file, sep);
+  template <class Logger, class Root>
+  auto attach_logger(Root& root, const std::string& file, const std::string& sep, int)
+      -> decltype(root.template setLogger<Logger>(file, sep), void()) {
+    root.template setLogger<Logger>(file, sep);
   }
 
-  template <class Root>
-  auto attach_csv_logger(Root& root, const std::string& file, const std::string& sep, long)
-      -> decltype(root.setLogger(std::make_shared<cadmium::CSVLogger>(file, sep)), void()) {
-    root.setLogger(std::make_shared<cadmium::CSVLogger>(file, sep));
+  template <class Logger, class Root>
+  auto attach_logger(Root& root, const std::string& file, const std::string& sep, long)
+      -> decltype(root.setLogger(std::make_shared<Logger>(file, sep)), void()) {
+    root.setLogger(std::make_shared<Logger>(file, sep));
   }
 
   template <class Root>
-  void attach_csv_logger(Root& root, const std::string& file, const std::string& sep) {
-    attach_csv_logger(root, file, sep, 0);
+  void attach_csv_logger(Root& root, const std::string& file, const std::string& sep, bool filtered) {
+    if (filtered) attach_logger<cesfam::FilteredCSVLogger>(root, file, sep, 0);
+    else attach_logger<cadmium::CSVLogger>(root, file, sep, 0);
   }
 }  // namespace cesfam_compat
 
 using namespace cesfam;
 
+template <class Root, class... SimArgs>
+static void run_root(Root& root, const std::string& out_csv, const std::string& csv_sep, bool filtered_log,
+                     double until, SimArgs... sim_args) {
+    cesfam_compat::attach_csv_logger(root, out_csv, csv_sep, filtered_log);
+
+    root.start();
+    if (until <= 0.0) {
+        root.simulate(std::numeric_limits<double>::infinity(), sim_args...);
+    } else {
+        root.simulate(until, sim_args...);
+    }
+    root.stop();
+}
+
 int main(int argc, char** argv) {
     std::string params_path = "input_data/params.ini";
     if (argc >= 2) params_path = argv[1];
@@ -66,38 +102,24 @@ int main(int argc, char** argv) {
     }
 
     // ---- Build config -------------------------------------------------------
-    const int global_seed = get_int(kv, "simulation.rng_seed", 1);
-
     CesfamConfig cfg;
-
-    // Generator
-    cfg.generator.rng_seed = static_cast<unsigned>(get_int(kv, "generator.rng_seed", global_seed));
-    cfg.generator.arrivals_rate = get_double(kv, "arrivals.rate", 0.05);
-    cfg.generator.arrivals_csv_path = get_string(kv, "arrivals.csv", "");
-    cfg.generator.max_patients = get_int(kv, "arrivals.max_patients", 100);
-    cfg.generator.default_age = get_int(kv, "patients.default_age", 70);
-
-    // Case manager
-    cfg.case_manager.rng_seed = static_cast<unsigned>(get_int(kv, "case_manager.rng_seed", global_seed + 1));
-    cfg.case_manager.consent_p_accept = get_double(kv, "consent.p_accept", 1.0);
-
-    // Medical staff
-    cfg.medical_staff.doctors = get_int(kv, "router.doctors", 3);
-    cfg.medical_staff.service_mean = get_double(kv, "service.mean", 600.0);
-    cfg.medical_staff.rng_seed_base = static_cast<unsigned>(get_int(kv, "service.rng_seed_base", 1000));
-
-    // Adherence / decision
-    cfg.adherence.rng_seed = static_cast<unsigned>(get_int(kv, "adherence.rng_seed", global_seed + 2));
-    cfg.adherence.p_continue_base = get_double(kv, "adherence.p_continue_base", 0.30);
-    cfg.adherence.mult_alto = get_double(kv, "adherence.mult_alto", 1.20);
-    cfg.adherence.mult_medio = get_double(kv, "adherence.mult_medio", 1.00);
-    cfg.adherence.mult_bajo = get_double(kv, "adherence.mult_bajo", 0.80);
-    cfg.adherence.max_followups = get_int(kv, "adherence.max_followups", 3);
+    try {
+        cfg = load_cesfam_config(kv);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
 
     // ---- Simulation params --------------------------------------------------
     const double until = get_double(kv, "simulation.until", 3600.0);
     const std::string out_csv = get_string(kv, "simulation.log_csv", "simulation_results/cesfam_log.csv");
     const std::string csv_sep = get_string(kv, "simulation.csv_sep", ";");
+    const int parallel_threads = get_int(kv, "simulation.parallel_threads", 1);
+    const bool estimate = get_bool(kv, "analysis.estimate", false);
+    const LogSpec log_spec = load_log_spec(kv);
+    const std::string journey_path = get_string(kv, "journey.path", "");
+    const int journey_block_rows = get_int(kv, "journey.block_rows", 65536);
+    const std::string live_shm = get_string(kv, "live.shm", "");
 
     // Ensure output folder exists
     try {
@@ -109,20 +131,111 @@ int main(int argc, char** argv) {
         std::cerr << "[WARN] Could not create output directories: " << e.what() << "\n";
     }
 
+    // ---- Analytical estimate (validation) -----------------------------------
+    AnalyticEstimate est;
+    if (estimate) {
+        try {
+            const auto t0 = std::chrono::steady_clock::now();
+            est = estimate_queueing_network(cfg);
+            const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "Analytical estimate (" << us << " us): doctors=" << est.doctors
+                      << " rho=" << est.utilization
+                      << (est.stable ? "" : " (unstable)")
+                      << " visits/patient=" << est.visits_per_patient
+                      << " RA/h=" << est.throughput_ra * 3600.0
+                      << " RC/h=" << est.throughput_rc * 3600.0
+                      << " wait_mean=" << est.wq << "s wait_p90=" << est.wq_p90 << "s\n";
+        } catch (const std::exception& e) {
+            std::cerr << "[WARN] Analytical estimate failed: " << e.what() << "\n";
+        }
+        cfg.exits = std::make_shared<ExitLog>();
+    }
+
+    // ---- Per-visit journey table ---------------------------------------------
+    if (!journey_path.empty()) {
+        try {
+            std::filesystem::path jp(journey_path);
+            if (jp.has_parent_path()) std::filesystem::create_directories(jp.parent_path());
+            cfg.journey = std::make_shared<JourneyWriter>(journey_path, static_cast<std::size_t>(std::max(1, journey_block_rows)));
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // ---- Live metrics for external monitors ----------------------------------
+    if (!live_shm.empty()) {
+        try {
+            cfg.live = std::make_shared<LiveMetrics>(live_shm, StaffComponents::roster_size(cfg.medical_staff));
+            std::cout << "Live metrics: shared memory " << live_shm << " (CESFAM_MONITOR " << live_shm << ")\n";
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << "\n";
+            return 1;
+        }
+    }
+
     // ---- Build model & run --------------------------------------------------
     auto model = std::make_shared<CESFAM>("CESFAM", cfg);
-    auto root = cadmium::RootCoordinator(model);
+    if (log_spec.active()) apply_log_filter(*model, log_spec);
+
+    bool ran = false;
+    if (parallel_threads > 1 && cfg.live) {
+        std::cerr << "[WARN] simulation.parallel_threads ignored: live.shm runs the sequential coordinator\n";
+    } else if (parallel_threads > 1) {
+#if defined(CESFAM_PARALLEL)
+        auto root = cadmium::ParallelRootCoordinator(model);
+        run_root(root, out_csv, csv_sep, log_spec.active(), until, static_cast<std::size_t>(parallel_threads));
+        std::cout << "Simulation finished (" << parallel_threads << " threads). Log: " << out_csv << "\n";
+        ran = true;
+#else
+        std::cerr << "[WARN] simulation.parallel_threads ignored: build with `make PARALLEL=1`\n";
+#endif
+    }
 
-    cesfam_compat::attach_csv_logger(root, out_csv, csv_sep);
+    if (!ran && cfg.live) {
+        // Same run through a Stepper, which brackets each event instant for
+        // the live metrics seqlock (RootCoordinator has no per-event hook).
+        Stepper stepper(model);
+        stepper.set_live(cfg.live.get());
+        cesfam_compat::attach_csv_logger(stepper, out_csv, csv_sep, log_spec.active());
+        stepper.start();
+        const double end = until <= 0.0 ? std::numeric_limits<double>::infinity() : until;
+        while (stepper.time_next() < end) stepper.advance_one();   // stops at the last event, as RootCoordinator
+        stepper.stop();
+        cfg.live->finish();
+        std::cout << "Simulation finished. Log: " << out_csv << "\n";
+        ran = true;
+    }
 
-    root.start();
-    if (until <= 0.0) {
-        root.simulate(std::numeric_limits<double>::infinity());
-    } else {
-        root.simulate(until);
+    if (!ran) {
+        auto root = cadmium::RootCoordinator(model);
+        run_root(root, out_csv, csv_sep, log_spec.active(), until);
+        std::cout << "Simulation finished. Log: " << out_csv << "\n";
+    }
+
+    int status = 0;
+    if (cfg.journey) {
+        try {
+            cfg.journey->close();
+            std::cout << "Journey table: " << journey_path << " (" << cfg.journey->rows() << " visits)\n";
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << "\n";
+            status = 1;   // the run itself finished: still print the summaries below
+        }
     }
-    root.stop();
 
-    std::cout << "Simulation finished. Log: " << out_csv << "\n";
-    return 0;
+    if (const ArrivalStream* feed = model->generator()->stream()) {
+        std::cout << "Arrivals feed: " << feed->count() << " events read";
+        if (feed->late() > 0) std::cout << ", " << feed->late() << " out of order beyond the look-ahead (delayed)";
+        if (feed->malformed() > 0) std::cout << ", " << feed->malformed() << " malformed lines skipped";
+        std::cout << "\n";
+    }
+
+    if (estimate && until > 0.0) {
+        const KpiSummary k = summarize(*cfg.exits);
+        std::cout << "Simulated:                   RA/h=" << k.ra * 3600.0 / until
+                  << " RC/h=" << k.rc * 3600.0 / until
+                  << " wait_mean=" << k.wait.mean << "s wait_p90=" << k.wait.p90 << "s\n";
+    }
+    return status;
 }
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "utils/ini_reader.hpp"
+#include "utils/csv_arrivals.hpp"
+#include "top_model/params.hpp"
+#include "top_model/optimizer.hpp"
+
+using namespace cesfam;
+
+int main(int argc, char** argv) {
+    std::string params_path = "input_data/params.ini";
+    if (argc >= 2) params_path = argv[1];
+
+    std::unordered_map<std::string, std::string> kv;
+    try {
+        kv = read_kv_file(params_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        std::cerr << "Usage: " << argv[0] << " [path/to/params.ini]\n";
+        return 1;
+    }
+
+    // ---- Build config -------------------------------------------------------
+    CesfamConfig base;
+    try {
+        base = load_cesfam_config(kv);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+
+    OptimizerConfig ocfg;
+    ocfg.sla_p90 = get_double(kv, "optimizer.sla_p90", 1800.0);
+    const std::string risk = get_string(kv, "optimizer.risk", "alto");
+    ocfg.min_doctors = get_int(kv, "optimizer.min_doctors", 1);
+    ocfg.max_doctors = get_int(kv, "optimizer.max_doctors", 64);
+    ocfg.min_reps = get_int(kv, "optimizer.min_reps", 5);
+    ocfg.max_reps = get_int(kv, "optimizer.max_reps", 40);
+    ocfg.batch = get_int(kv, "optimizer.batch", 5);
+    ocfg.confidence = get_double(kv, "optimizer.confidence", 0.95);
+    ocfg.threads = static_cast<unsigned>(get_int(kv, "optimizer.threads", 0));
+    ocfg.until = get_double(kv, "simulation.until", 3600.0);
+    ocfg.screen = get_bool(kv, "optimizer.screen", false);
+
+    const std::string out_csv = get_string(kv, "optimizer.trace_csv", "simulation_results/optimizer_trace.csv");
+    const std::string csv_sep = get_string(kv, "simulation.csv_sep", ";");
+
+    try {
+        std::filesystem::path out_path(out_csv);
+        if (out_path.has_parent_path()) {
+            std::filesystem::create_directories(out_path.parent_path());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Could not create output directories: " << e.what() << "\n";
+    }
+
+    // ---- Search --------------------------------------------------------------
+    OptimizerResult res;
+    double wall_s = 0.0;
+    try {
+        ocfg.risk = parse_risk_filter("optimizer.risk", risk);
+        check_no_live_feed(base, "optimizer");
+        CapacityOptimizer opt(base, ocfg);
+        const auto t0 = std::chrono::steady_clock::now();
+        res = opt.run();
+        wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+
+    std::ofstream out(out_csv);
+    out << "doctors" << csv_sep << "reps" << csv_sep << "p90_mean_s" << csv_sep << "p90_lower_s" << csv_sep
+        << "p90_upper_s" << csv_sep << "verdict" << csv_sep << "conclusive" << csv_sep << "screened"
+        << csv_sep << "rho" << csv_sep << "empty_reps\n";
+    for (const auto& c : res.evaluated) {
+        out << c.doctors << csv_sep << c.p90.n << csv_sep << c.p90.mean << csv_sep << c.p90.lower() << csv_sep
+            << c.p90.upper() << csv_sep << to_string(c.verdict) << csv_sep << (c.conclusive ? 1 : 0) << csv_sep
+            << (c.screened ? 1 : 0) << csv_sep << c.rho << csv_sep << c.empty << "\n";
+        if (c.screened) {
+            std::cout << "  doctors=" << c.doctors << " rho=" << c.rho << " infeasible (analytical screen)\n";
+            continue;
+        }
+        std::cout << "  doctors=" << c.doctors << " reps=" << c.p90.n << " p90=" << c.p90.mean
+                  << " [" << c.p90.lower() << ", " << c.p90.upper() << "] " << to_string(c.verdict)
+                  << (c.conclusive ? "" : " (max_reps)");
+        if (c.empty > 0) std::cout << " (" << c.empty << " reps without " << risk_filter_label(ocfg.risk) << " patients)";
+        std::cout << "\n";
+    }
+
+    std::cout << "Optimizer: " << res.evaluated.size() << " candidates, " << res.replications
+              << " replications, " << wall_s << " s wall\n";
+    if (base.cache) std::cout << "Result cache: " << base.cache->stats() << "\n";
+    if (!res.found) {
+        std::cout << "No staff count up to optimizer.max_doctors=" << ocfg.max_doctors
+                  << " meets p90 <= " << ocfg.sla_p90 << " s\n";
+        return 2;
+    }
+    std::cout << "Minimum doctors: " << res.best.doctors << " (p90 " << risk_filter_label(ocfg.risk) << " = "
+              << res.best.p90.mean << " s, " << static_cast<int>(ocfg.confidence * 100.0) << "% CI ["
+              << res.best.p90.lower() << ", " << res.best.p90.upper() << "], " << res.best.p90.n
+              << " replications)\n"
+              << "Trace: " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "utils/ini_reader.hpp"
+#include "top_model/params.hpp"
+#include "top_model/rare_event.hpp"
+
+using namespace cesfam;
+
+int main(int argc, char** argv) {
+    std::string params_path = "input_data/params.ini";
+    if (argc >= 2) params_path = argv[1];
+
+    std::unordered_map<std::string, std::string> kv;
+    try {
+        kv = read_kv_file(params_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        std::cerr << "Usage: " << argv[0] << " [path/to/params.ini]\n";
+        return 1;
+    }
+
+    RareEventConfig rcfg;
+    rcfg.threshold = get_double(kv, "rare.threshold", 14400.0);
+    const std::string risk = get_string(kv, "rare.risk", "all");
+    rcfg.levels = get_int(kv, "rare.levels", 8);
+    rcfg.effort = get_int(kv, "rare.effort", 1000);
+    rcfg.mc_reps = get_int(kv, "rare.mc_reps", 0);
+    rcfg.confidence = get_double(kv, "rare.confidence", 0.95);
+    rcfg.seed = static_cast<std::uint64_t>(get_int(kv, "rare.seed", 12345));
+    rcfg.threads = static_cast<unsigned>(get_int(kv, "rare.threads", 0));
+    rcfg.until = get_double(kv, "rare.until", get_double(kv, "simulation.until", 86400.0));
+
+    const std::string out_csv = get_string(kv, "rare.results_csv", "simulation_results/rare_event.csv");
+    const std::string csv_sep = get_string(kv, "simulation.csv_sep", ";");
+
+    try {
+        std::filesystem::path out_path(out_csv);
+        if (out_path.has_parent_path()) {
+            std::filesystem::create_directories(out_path.parent_path());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Could not create output directories: " << e.what() << "\n";
+    }
+
+    RareEventResult res;
+    try {
+        rcfg.risk = parse_risk_filter("rare.risk", risk);
+        const CesfamConfig base = load_cesfam_config(kv);
+        check_no_live_feed(base, "rare-event splitting");
+        RareEventSplitter splitter(base, rcfg);
+        const auto t0 = std::chrono::steady_clock::now();
+        res = splitter.run();
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::cout << "P(" << risk_filter_label(rcfg.risk) << " wait > " << rcfg.threshold << " s within " << rcfg.until
+                  << " s) = " << res.probability << " [" << res.lower << ", " << res.upper << "]"
+                  << " rel.err " << res.rel_error << "\n";
+        std::cout << "  splitting: " << res.stages.size() << " stages x " << rcfg.effort << " trajectories, "
+                  << res.events << " events, " << wall_s << " s wall\n";
+        for (const auto& s : res.stages) {
+            std::cout << "    level " << s.level << " s: " << s.hits << "/" << s.trials << "\n";
+        }
+        if (res.risk_runs == 0) {
+            std::cerr << "[WARN] no replication had a " << risk_filter_label(rcfg.risk)
+                      << " patient reach the doctors: P = 0 is trivial (check rare.risk, patients.default_age"
+                         " and the arrivals)\n";
+        }
+
+        if (res.mc_reps > 0) {
+            const double p_mc = static_cast<double>(res.mc_hits) / static_cast<double>(res.mc_reps);
+            std::cout << "  crude MC: " << res.mc_hits << "/" << res.mc_reps << " = " << p_mc << ", "
+                      << res.mc_events << " events\n";
+            // events crude MC would need for the splitting relative error
+            if (res.probability > 0.0 && res.rel_error > 0.0) {
+                const double per_rep = static_cast<double>(res.mc_events) / static_cast<double>(res.mc_reps);
+                const double reps = (1.0 - res.probability) / (res.probability * res.rel_error * res.rel_error);
+                std::cout << "  crude MC for the same rel.err: ~" << reps << " runs, ~" << reps * per_rep
+                          << " events\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+
+    std::ofstream out(out_csv);
+    out << "level_s" << csv_sep << "trials" << csv_sep << "hits" << csv_sep << "p_stage" << csv_sep << "p_cum\n";
+    double cum = 1.0;
+    for (const auto& s : res.stages) {
+        cum *= s.probability();
+        out << s.level << csv_sep << s.trials << csv_sep << s.hits << csv_sep << s.probability() << csv_sep << cum
+            << "\n";
+    }
+
+    std::cout << "Results: " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <chrono>
+#include <csignal>
+#include <iostream>
+
+#include "utils/ini_reader.hpp"
+#include "top_model/params.hpp"
+#include "top_model/realtime.hpp"
+
+using namespace cesfam;
+
+int main(int argc, char** argv) {
+    std::string params_path = "input_data/params.ini";
+    if (argc >= 2) params_path = argv[1];
+
+    std::unordered_map<std::string, std::string> kv;
+    try {
+        kv = read_kv_file(params_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        std::cerr << "Usage: " << argv[0] << " [path/to/params.ini]\n";
+        return 1;
+    }
+
+    // A dashboard closing the FIFO must not kill the simulation.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const double until = get_double(kv, "simulation.until", 3600.0);
+
+    RealtimeConfig rt;
+    rt.speed = get_double(kv, "realtime.speed", 60.0);
+    rt.kpi_interval = get_double(kv, "realtime.kpi_interval", 300.0);
+    rt.output = get_string(kv, "realtime.output", "-");
+    rt.buffer = static_cast<std::size_t>(std::max(1, get_int(kv, "realtime.buffer", 256)));
+
+    // KPIs may go to stdout: status messages go to stderr.
+    try {
+        RealtimeRunner runner(load_cesfam_config(kv), rt);
+        const auto t0 = std::chrono::steady_clock::now();
+        const std::size_t records = runner.run(until);
+        std::cerr << "Real-time run finished: " << records << " KPI records in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count()
+                  << " s wall (speed " << rt.speed << "x)\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
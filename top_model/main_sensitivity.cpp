@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "utils/ini_reader.hpp"
+#include "top_model/sensitivity.hpp"
+
+using namespace cesfam;
+
+using KV = std::unordered_map<std::string, std::string>;
+
+// Factors are declared in params.ini as
+//   sensitivity.factor.<params key> = lo, hi
+static std::vector<SensitivityFactor> read_factors(const KV& kv) {
+    const std::string prefix = "sensitivity.factor.";
+
+    std::vector<SensitivityFactor> factors;
+    for (const auto& [k, v] : kv) {
+        if (k.rfind(prefix, 0) != 0) continue;
+        factors.push_back(parse_sensitivity_factor(k.substr(prefix.size()), v));
+    }
+    std::sort(factors.begin(), factors.end(),
+              [](const SensitivityFactor& a, const SensitivityFactor& b) { return a.key < b.key; });
+    return factors;
+}
+
+int main(int argc, char** argv) {
+    std::string params_path = "input_data/params.ini";
+    if (argc >= 2) params_path = argv[1];
+
+    KV kv;
+    try {
+        kv = read_kv_file(params_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        std::cerr << "Usage: " << argv[0] << " [path/to/params.ini]\n";
+        return 1;
+    }
+
+    SensitivityConfig scfg;
+    try {
+        scfg.method = parse_sensitivity_method(get_string(kv, "sensitivity.method", "morris"));
+        scfg.output = parse_sensitivity_output(get_string(kv, "sensitivity.output", "wait_mean"));
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+    scfg.trajectories = get_int(kv, "sensitivity.trajectories", 20);
+    scfg.levels = get_int(kv, "sensitivity.levels", 4);
+    scfg.samples = get_int(kv, "sensitivity.samples", 128);
+    scfg.reps = get_int(kv, "sensitivity.reps", 1);
+    scfg.bootstrap = get_int(kv, "sensitivity.bootstrap", 500);
+    scfg.confidence = get_double(kv, "sensitivity.confidence", 0.95);
+    scfg.seed = static_cast<std::uint64_t>(get_int(kv, "sensitivity.seed", 12345));
+    scfg.common_random_numbers = get_bool(kv, "sensitivity.common_random_numbers", true);
+    scfg.threads = static_cast<unsigned>(get_int(kv, "sensitivity.threads", 0));
+    scfg.until = get_double(kv, "simulation.until", 3600.0);
+
+    const std::string out_csv = get_string(kv, "sensitivity.results_csv", "simulation_results/sensitivity.csv");
+    const std::string csv_sep = get_string(kv, "simulation.csv_sep", ";");
+
+    try {
+        std::filesystem::path out_path(out_csv);
+        if (out_path.has_parent_path()) {
+            std::filesystem::create_directories(out_path.parent_path());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Could not create output directories: " << e.what() << "\n";
+    }
+
+    const bool sobol = scfg.method == SensitivityMethod::Sobol;
+    SensitivityResult res;
+    try {
+        const std::vector<SensitivityFactor> factors = read_factors(kv);
+        if (factors.empty()) {
+            std::cerr << "[ERROR] No sensitivity.factor.<key> = lo, hi entries in " << params_path << "\n";
+            return 1;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        res = run_sensitivity(kv, factors, scfg);
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::cout << (sobol ? "Sobol" : "Morris") << " sensitivity of " << to_string(scfg.output) << ": "
+                  << factors.size() << " factors, " << res.runs << " runs (" << res.builds << " models built), "
+                  << wall_s << " s wall\n";
+        std::cout << "  response mean=" << res.mean << " var=" << res.variance << "\n";
+        if (const auto cache = load_cesfam_config(kv).cache) std::cout << "Result cache: " << cache->stats() << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+
+    std::ofstream out(out_csv);
+    if (sobol) {
+        out << "factor" << csv_sep << "lo" << csv_sep << "hi" << csv_sep << "s1" << csv_sep << "s1_lower" << csv_sep
+            << "s1_upper" << csv_sep << "st" << csv_sep << "st_lower" << csv_sep << "st_upper\n";
+    } else {
+        out << "factor" << csv_sep << "lo" << csv_sep << "hi" << csv_sep << "mu_star" << csv_sep << "mu_star_lower"
+            << csv_sep << "mu_star_upper" << csv_sep << "mu" << csv_sep << "sigma\n";
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (const auto& f : res.factors) {
+        out << f.factor.key << csv_sep << f.factor.lo << csv_sep << f.factor.hi << csv_sep;
+        std::cout << "  " << std::left << std::setw(28) << f.factor.key << std::right;
+        if (sobol) {
+            out << f.s1 << csv_sep << f.s1_ci.lower << csv_sep << f.s1_ci.upper << csv_sep << f.st << csv_sep
+                << f.st_ci.lower << csv_sep << f.st_ci.upper << "\n";
+            std::cout << " S1=" << f.s1 << " [" << f.s1_ci.lower << ", " << f.s1_ci.upper << "]"
+                      << "  ST=" << f.st << " [" << f.st_ci.lower << ", " << f.st_ci.upper << "]\n";
+        } else {
+            out << f.mu_star << csv_sep << f.mu_star_ci.lower << csv_sep << f.mu_star_ci.upper << csv_sep << f.mu
+                << csv_sep << f.sigma << "\n";
+            std::cout << " mu*=" << f.mu_star << " [" << f.mu_star_ci.lower << ", " << f.mu_star_ci.upper << "]"
+                      << "  mu=" << f.mu << "  sigma=" << f.sigma << "\n";
+        }
+    }
+
+    std::cout << "Results: " << out_csv << "\n";
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "utils/ini_reader.hpp"
+#include "utils/stats.hpp"
+#include "top_model/surrogate.hpp"
+
+using namespace cesfam;
+
+using KV = std::unordered_map<std::string, std::string>;
+
+static std::vector<std::string> split_list(const std::string& v) {
+    std::vector<std::string> out;
+    std::stringstream ss(v);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim_copy(item);
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+static void ensure_parent(const std::string& path) {
+    try {
+        std::filesystem::path p(path);
+        if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Could not create output directories: " << e.what() << "\n";
+    }
+}
+
+// Query points: a CSV whose header names (at least) every swept key.
+static std::vector<std::vector<double>> read_queries(const std::string& path, const std::string& sep,
+                                                     const std::vector<SurrogateAxis>& axes) {
+    std::ifstream in(path);
+    if (!in.is_open()) throw std::runtime_error("Cannot open surrogate queries: " + path);
+    std::string line;
+    if (!std::getline(in, line)) return {};
+    const std::vector<std::string> header = detail::split_fields(line, sep);
+    std::vector<std::size_t> col;
+    for (const auto& a : axes) {
+        const auto it = std::find(header.begin(), header.end(), a.key);
+        if (it == header.end()) throw std::runtime_error("Surrogate queries without column " + a.key + ": " + path);
+        col.push_back(static_cast<std::size_t>(it - header.begin()));
+    }
+    std::vector<std::vector<double>> out;
+    while (std::getline(in, line)) {
+        if (trim_copy(line).empty()) continue;
+        const std::vector<std::string> f = detail::split_fields(line, sep);
+        std::vector<double> q;
+        for (std::size_t c : col) {
+            double v = 0.0;
+            if (c >= f.size() || !detail::parse_number(f[c], v)) {
+                throw std::runtime_error("Bad surrogate query line: " + line);
+            }
+            q.push_back(v);
+        }
+        out.push_back(std::move(q));
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::string params_path = "input_data/params.ini";
+    if (argc >= 2) params_path = argv[1];
+
+    KV kv;
+    try {
+        kv = read_kv_file(params_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        std::cerr << "Usage: " << argv[0] << " [path/to/params.ini]\n";
+        return 1;
+    }
+
+    const std::string csv_sep = get_string(kv, "simulation.csv_sep", ";");
+    const double confidence = get_double(kv, "sweep.confidence", 0.95);
+    const std::vector<std::string> data_paths = split_list(
+        get_string(kv, "surrogate.data", get_string(kv, "sweep.results_csv", "simulation_results/sweep_results.csv")));
+    const std::string query_path = get_string(kv, "surrogate.query", "");
+    const std::string pred_csv = get_string(kv, "surrogate.predictions_csv",
+                                            "simulation_results/surrogate_predictions.csv");
+    const std::string next_csv = get_string(kv, "surrogate.next_csv", "simulation_results/surrogate_next.csv");
+    const int next = get_int(kv, "surrogate.next", 8);
+    const int candidates = get_int(kv, "surrogate.candidates", 4096);
+    const auto seed = static_cast<std::uint64_t>(get_int(kv, "surrogate.seed", 12345));
+    const bool log_scale = get_bool(kv, "surrogate.log", true);
+
+    try {
+        const auto t0 = std::chrono::steady_clock::now();
+        const SweepSurrogate sur(read_sweep_results(data_paths, csv_sep, confidence), log_scale, confidence);
+        const double fit_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        const StochasticKriging& m = sur.model();
+        std::cout << "Surrogate of " << (sur.log_scale() ? "log " : "") << "wait_mean_s: " << m.size() << " points";
+        if (sur.data().skipped > 0) std::cout << " (" << sur.data().skipped << " rows without interval or with divergent replications skipped)";
+        std::cout << ", fitted in " << fit_ms << " ms\n";
+        std::cout << "  process sd=" << m.process_sd() << "  leave-one-out rmse=" << sur.loo_rmse() << " s\n";
+        for (std::size_t k = 0; k < sur.axes().size(); ++k) {
+            const SurrogateAxis& a = sur.axes()[k];
+            std::cout << "  " << std::left << std::setw(28) << a.key << std::right << " [" << a.lo << ", " << a.hi
+                      << "]  length scale=" << m.length_scale(k) << "\n";
+        }
+
+        if (!query_path.empty()) {
+            const std::vector<std::vector<double>> queries = read_queries(query_path, csv_sep, sur.axes());
+            std::vector<SurrogatePrediction> preds(queries.size());
+            const auto q0 = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < queries.size(); ++i) preds[i] = sur.predict(queries[i]);
+            const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - q0).count();
+
+            ensure_parent(pred_csv);
+            std::ofstream out(pred_csv);
+            for (const auto& a : sur.axes()) out << a.key << csv_sep;
+            out << "wait_mean_s" << csv_sep << "sd" << csv_sep << "lower" << csv_sep << "upper\n";
+            for (std::size_t i = 0; i < queries.size(); ++i) {
+                for (double v : queries[i]) out << v << csv_sep;
+                out << preds[i].mean << csv_sep << preds[i].sd << csv_sep << preds[i].lower << csv_sep
+                    << preds[i].upper << "\n";
+            }
+            std::cout << "Predicted " << queries.size() << " points ("
+                      << (queries.empty() ? 0.0 : us / static_cast<double>(queries.size())) << " us each): " << pred_csv
+                      << "\n";
+        }
+
+        if (next > 0) {
+            const auto points = sur.propose(static_cast<std::size_t>(next), static_cast<std::size_t>(std::max(1, candidates)),
+                                            seed);
+            ensure_parent(next_csv);
+            std::ofstream out(next_csv);
+            for (std::size_t k = 0; k < sur.axes().size(); ++k) out << (k ? csv_sep : "") << sur.axes()[k].key;
+            out << "\n";
+            for (const auto& p : points) {
+                for (std::size_t k = 0; k < p.size(); ++k) out << (k ? csv_sep : "") << p[k];
+                out << "\n";
+            }
+            std::cout << "Next design points (" << points.size() << ", for sweep.points): " << next_csv << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
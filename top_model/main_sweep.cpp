@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "utils/ini_reader.hpp"
+#include "top_model/params.hpp"
+#include "top_model/sweep.hpp"
+
+using namespace cesfam;
+
+using KV = std::unordered_map<std::string, std::string>;
+
+// Axes are declared in params.ini as
+//   sweep.vary.<params key> = v1, v2, ...
+// and the sweep runs their cartesian product.
+static std::vector<SweepPoint> read_points(const KV& kv) {
+    const std::string prefix = "sweep.vary.";
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> axes;
+    for (const auto& [k, v] : kv) {
+        if (k.rfind(prefix, 0) != 0) continue;
+        std::vector<std::string> values;
+        std::stringstream ss(v);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item = trim_copy(item);
+            if (!item.empty()) values.push_back(item);
+        }
+        if (!values.empty()) axes.emplace_back(k.substr(prefix.size()), std::move(values));
+    }
+    std::sort(axes.begin(), axes.end());
+
+    std::vector<SweepPoint> points;
+    std::vector<std::size_t> idx(axes.size(), 0);
+    while (true) {
+        SweepPoint p;
+        KV overrides = kv;
+        for (std::size_t a = 0; a < axes.size(); ++a) {
+            overrides[axes[a].first] = axes[a].second[idx[a]];
+            p.overrides.emplace_back(axes[a].first, axes[a].second[idx[a]]);
+        }
+        p.config = load_cesfam_config(overrides);
+        for (const auto& [key, value] : p.overrides) check_staff_override(key, p.config, "sweep");
+        check_no_live_feed(p.config, "sweep");
+        points.push_back(std::move(p));
+
+        std::size_t a = axes.size();
+        while (a > 0 && ++idx[a - 1] == axes[a - 1].second.size()) idx[--a] = 0;
+        if (a == 0) break;
+    }
+    return points;
+}
+
+// Or listed one per row in a CSV (sweep.points): the header names the
+// params keys, e.g. the next design points proposed by CESFAM_SURROGATE.
+static std::vector<SweepPoint> read_points_csv(const KV& kv, const std::string& path, const std::string& sep) {
+    std::ifstream in(path);
+    if (!in.is_open()) throw std::runtime_error("Cannot open sweep points: " + path);
+
+    auto split = [&](const std::string& line) {
+        std::vector<std::string> out;
+        std::size_t pos = 0;
+        while (true) {
+            const std::size_t next = line.find(sep, pos);
+            out.push_back(trim_copy(line.substr(pos, next == std::string::npos ? std::string::npos : next - pos)));
+            if (next == std::string::npos) break;
+            pos = next + sep.size();
+        }
+        return out;
+    };
+
+    std::string line;
+    if (!std::getline(in, line)) throw std::runtime_error("Empty sweep points: " + path);
+    const std::vector<std::string> keys = split(line);
+
+    std::vector<SweepPoint> points;
+    while (std::getline(in, line)) {
+        if (trim_copy(line).empty()) continue;
+        const std::vector<std::string> values = split(line);
+        if (values.size() != keys.size()) throw std::runtime_error("Bad sweep points line: " + line);
+        SweepPoint p;
+        KV overrides = kv;
+        for (std::size_t a = 0; a < keys.size(); ++a) {
+            overrides[keys[a]] = values[a];
+            p.overrides.emplace_back(keys[a], values[a]);
+        }
+        p.config = load_cesfam_config(overrides);
+        for (const auto& [key, value] : p.overrides) check_staff_override(key, p.config, "sweep");
+        check_no_live_feed(p.config, "sweep");
+        points.push_back(std::move(p));
+    }
+    if (points.empty()) throw std::runtime_error("No points in " + path);
+    return points;
+}
+
+int main(int argc, char** argv) {
+    std::string params_path = "input_data/params.ini";
+    if (argc >= 2) params_path = argv[1];
+
+    KV kv;
+    try {
+        kv = read_kv_file(params_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        std::cerr << "Usage: " << argv[0] << " [path/to/params.ini]\n";
+        return 1;
+    }
+
+    SweepConfig scfg;
+    scfg.reps = get_int(kv, "sweep.reps", 5);
+    scfg.threads = static_cast<unsigned>(get_int(kv, "sweep.threads", 0));
+    scfg.screen = get_bool(kv, "sweep.screen", false);
+    scfg.confidence = get_double(kv, "sweep.confidence", 0.95);
+    scfg.until = get_double(kv, "simulation.until", 3600.0);
+    scfg.divergence = load_divergence_config(kv);
+
+    const std::string out_csv = get_string(kv, "sweep.results_csv", "simulation_results/sweep_results.csv");
+    const std::string csv_sep = get_string(kv, "simulation.csv_sep", ";");
+    const std::string points_csv = get_string(kv, "sweep.points", "");
+
+    try {
+        std::filesystem::path out_path(out_csv);
+        if (out_path.has_parent_path()) {
+            std::filesystem::create_directories(out_path.parent_path());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARN] Could not create output directories: " << e.what() << "\n";
+    }
+
+    std::vector<SweepPoint> points;
+    std::vector<SweepResult> results;
+    try {
+        points = points_csv.empty() ? read_points(kv) : read_points_csv(kv, points_csv, csv_sep);
+        const auto t0 = std::chrono::steady_clock::now();
+        results = run_sweep(points, scfg);
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::size_t screened = 0, diverged = 0, diverged_points = 0;
+        for (const auto& r : results) {
+            screened += r.screened ? 1 : 0;
+            diverged += r.diverged;
+            diverged_points += r.diverged > 0 ? 1 : 0;
+        }
+        std::cout << "Sweep: " << points.size() << " points (" << screened << " screened as unstable), "
+                  << (points.size() - screened) * static_cast<std::size_t>(std::max(1, scfg.reps))
+                  << " replications";
+        if (scfg.divergence.active()) {
+            std::cout << " (" << diverged << " stopped early as divergent, " << diverged_points
+                      << " points marked unstable)";
+        }
+        std::cout << ", " << wall_s << " s wall\n";
+        if (points.front().config.cache) std::cout << "Result cache: " << points.front().config.cache->stats() << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << "\n";
+        return 1;
+    }
+
+    std::ofstream out(out_csv);
+    for (const auto& [key, value] : points.front().overrides) out << key << csv_sep;
+    out << "rho" << csv_sep << "stable" << csv_sep << "screened" << csv_sep << "wq_analytic_s" << csv_sep
+        << "wq_p90_analytic_s" << csv_sep << "reps" << csv_sep << "wait_mean_s" << csv_sep << "wait_mean_lower_s"
+        << csv_sep << "wait_mean_upper_s" << csv_sep << "wait_p90_s" << csv_sep << "ra_mean" << csv_sep << "diverged\n";
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        const SweepResult& r = results[i];
+        for (const auto& [key, value] : points[i].overrides) out << value << csv_sep;
+        out << r.estimate.utilization << csv_sep << (r.unstable() ? 0 : 1) << csv_sep << (r.screened ? 1 : 0)
+            << csv_sep << r.estimate.wq << csv_sep << r.estimate.wq_p90 << csv_sep << r.reps << csv_sep;
+        if (r.wait_mean.n > 0) {
+            out << r.wait_mean.mean << csv_sep << r.wait_mean.lower() << csv_sep << r.wait_mean.upper() << csv_sep
+                << r.wait_p90.mean << csv_sep << r.ra.mean;
+        } else {
+            // screened or partly divergent: no simulated KPIs to report
+            out << csv_sep << csv_sep << csv_sep << csv_sep;
+        }
+        out << csv_sep << r.diverged << "\n";
+    }
+
+    std::cout << "Results: " << out_csv << "\n";
+    return 0;
+}
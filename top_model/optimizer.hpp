@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils/kpi.hpp"
+#include "utils/stats.hpp"
+#include "utils/worker_pool.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/replication.hpp"
+#include "top_model/analytic.hpp"
+
+namespace cesfam {
+
+struct OptimizerConfig {
+    double sla_p90 = 1800.0;            // seconds: p90 wait of `risk` patients must stay below
+    RiskLevel risk = RiskLevel::Alto;   // Unknown = all patients
+
+    int min_doctors = 1;
+    int max_doctors = 64;
+
+    int min_reps = 5;                   // replications before the first decision
+    int max_reps = 40;                  // give up deciding after this many
+    int batch = 5;                      // replications added per round
+    double confidence = 0.95;
+
+    double until = 3600.0;
+    unsigned seed_stride = 7919;        // replication r uses seeds + r * seed_stride
+    unsigned threads = 0;
+
+    // Reject staff counts the analytical model finds unstable (rho >= 1)
+    // without simulating. That is a steady-state verdict: over a finite
+    // horizon (until, max_patients) an overloaded staff can still meet the
+    // SLA, so only enable it when `until` is long against the transient.
+    bool screen = false;
+};
+
+enum class Verdict : std::uint8_t { Undecided=0, Feasible, Infeasible };
+
+inline const char* to_string(Verdict v) {
+    switch (v) {
+        case Verdict::Feasible: return "feasible";
+        case Verdict::Infeasible: return "infeasible";
+        default: return "undecided";
+    }
+}
+
+struct CandidateResult {
+    int doctors = 0;
+    MeanCI p90;                         // CI on the mean (over replications) of the p90 wait
+    std::size_t empty = 0;              // replications without any `risk` exit (no p90, not in the CI)
+    Verdict verdict = Verdict::Undecided;
+    bool conclusive = false;            // false: max_reps reached, decided on the mean
+    bool screened = false;              // rejected by the analytical screen, not simulated
+    double rho = 0.0;                   // analytical doctor utilization
+};
+
+struct OptimizerResult {
+    bool found = false;
+    CandidateResult best;                      // smallest feasible staff count
+    std::vector<CandidateResult> evaluated;    // in evaluation order
+    std::size_t replications = 0;
+};
+
+/// Smallest router.doctors whose p90 wait (for one risk level) meets an SLA.
+/// Not defined with a shift calendar (std::invalid_argument).
+///
+/// The search brackets the answer by doubling the staff count until a feasible
+/// count is found and then bisects the bracket; feasibility is monotone in the
+/// number of doctors. Each candidate is evaluated with sequential batches of
+/// parallel replications (common random numbers across candidates) and a t
+/// confidence interval on the mean p90: the candidate is dropped as soon as the
+/// interval lies entirely above the SLA, accepted once it lies entirely below,
+/// and decided on the mean if max_reps is reached first. With `screen`, staff
+/// counts the analytical queueing model finds unstable are rejected without
+/// simulating.
+///
+/// A replication in which no `risk` patient left has no p90: it is counted in
+/// CandidateResult::empty and left out of the interval. A candidate whose
+/// replications are all empty stops the search with std::runtime_error.
+class CapacityOptimizer {
+  public:
+    CapacityOptimizer(CesfamConfig base, OptimizerConfig cfg)
+    : base_(std::move(base))
+    , cfg_(std::move(cfg))
+    , pool_(cfg_.threads)
+    , arrivals_(arrival_profile(base_.generator))
+    {
+        if (base_.medical_staff.shifts) {
+            throw std::invalid_argument("The optimizer searches router.doctors, but shifts.csv sets the staff on duty "
+                                        "(router.doctors is ignored): drop shifts.csv to size the staff");
+        }
+        if (cfg_.min_doctors < 1) cfg_.min_doctors = 1;
+        if (cfg_.max_doctors < cfg_.min_doctors) cfg_.max_doctors = cfg_.min_doctors;
+        if (cfg_.batch < 1) cfg_.batch = 1;
+        if (cfg_.min_reps < 2) cfg_.min_reps = 2;
+        if (cfg_.max_reps < cfg_.min_reps) cfg_.max_reps = cfg_.min_reps;
+    }
+
+    OptimizerResult run() {
+        OptimizerResult res;
+
+        // Bracket: lo is known infeasible (or below the range), hi feasible.
+        int lo = cfg_.min_doctors - 1;
+        int hi = -1;
+        for (int d = cfg_.min_doctors; ; d = std::min(cfg_.max_doctors, d * 2)) {
+            if (feasible(d, res)) {
+                hi = d;
+                break;
+            }
+            lo = d;
+            if (d == cfg_.max_doctors) break;
+        }
+        if (hi < 0) return res;
+
+        while (hi - lo > 1) {
+            const int mid = lo + (hi - lo) / 2;
+            if (feasible(mid, res)) hi = mid;
+            else lo = mid;
+        }
+
+        res.found = true;
+        res.best = cache_.at(hi);
+        return res;
+    }
+
+    CandidateResult evaluate(int doctors, std::size_t* replications = nullptr) {
+        CesfamConfig cfg = base_;
+        cfg.medical_staff.doctors = doctors;
+
+        CandidateResult cand;
+        cand.doctors = doctors;
+
+        std::vector<double> samples;
+        int runs = 0;
+        while (runs < cfg_.max_reps) {
+            const int first = runs;
+            const int want = runs == 0 ? std::max(cfg_.min_reps, cfg_.batch) : cfg_.batch;
+            const int n = std::min(want, cfg_.max_reps - first);
+
+            std::vector<double> batch(static_cast<std::size_t>(n));
+            std::vector<char> measured(static_cast<std::size_t>(n), 0);
+            pool_.parallel_for(batch.size(), [&](std::size_t i) {
+                const unsigned offset = cfg_.seed_stride * static_cast<unsigned>(first + static_cast<int>(i));
+                const KpiSummary k = run_replication(with_seed_offset(cfg, offset), cfg_.until);
+                const WaitStats& w = cfg_.risk == RiskLevel::Unknown ? k.wait : wait_for(k, cfg_.risk);
+                measured[i] = w.n > 0 ? 1 : 0;
+                batch[i] = w.p90;
+            });
+            runs += n;
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                if (measured[i]) samples.push_back(batch[i]);
+                else ++cand.empty;
+            }
+            if (replications) *replications += batch.size();
+
+            cand.p90 = mean_ci(samples, cfg_.confidence);
+            if (samples.size() < 2) continue;   // no interval yet
+            if (cand.p90.lower() > cfg_.sla_p90) {
+                cand.verdict = Verdict::Infeasible;
+                cand.conclusive = true;
+                return cand;
+            }
+            if (cand.p90.upper() <= cfg_.sla_p90) {
+                cand.verdict = Verdict::Feasible;
+                cand.conclusive = true;
+                return cand;
+            }
+        }
+
+        if (samples.empty()) {
+            const std::string who = cfg_.risk == RiskLevel::Unknown ? "" : std::string(to_string(cfg_.risk)) + " ";
+            throw std::runtime_error("No " + who + "patients generated in " + std::to_string(runs)
+                                     + " replications with " + std::to_string(doctors)
+                                     + " doctors (check optimizer.risk)");
+        }
+        cand.verdict = cand.p90.mean <= cfg_.sla_p90 ? Verdict::Feasible : Verdict::Infeasible;
+        return cand;
+    }
+
+  private:
+    bool feasible(int doctors, OptimizerResult& res) {
+        auto it = cache_.find(doctors);
+        if (it == cache_.end()) {
+            CesfamConfig cfg = base_;
+            cfg.medical_staff.doctors = doctors;
+            const AnalyticEstimate est = estimate_queueing_network(cfg, arrivals_);
+
+            CandidateResult c;
+            if (cfg_.screen && !est.stable) {
+                c.doctors = doctors;
+                c.verdict = Verdict::Infeasible;
+                c.screened = true;
+            } else {
+                c = evaluate(doctors, &res.replications);
+            }
+            c.rho = est.utilization;
+            it = cache_.emplace(doctors, c).first;
+            res.evaluated.push_back(c);
+        }
+        return it->second.verdict == Verdict::Feasible;
+    }
+
+    CesfamConfig base_;
+    OptimizerConfig cfg_;
+    WorkerPool pool_;
+    ArrivalProfile arrivals_;
+    std::map<int, CandidateResult> cache_;
+};
+
+} // namespace cesfam
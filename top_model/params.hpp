@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "utils/ini_reader.hpp"
+#include "utils/csv_arrivals.hpp"
+#include "utils/divergence.hpp"
+#include "utils/csv_shifts.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/result_cache.hpp"
+
+namespace cesfam {
+
+/// Builds the CESFAM configuration from the key/value pairs of params.ini.
+/// Shared by every executable so that all of them read the same keys.
+inline CesfamConfig load_cesfam_config(const std::unordered_map<std::string, std::string>& kv) {
+    const int global_seed = get_int(kv, "simulation.rng_seed", 1);
+
+    CesfamConfig cfg;
+
+    // Generator
+    cfg.generator.rng_seed = static_cast<unsigned>(get_int(kv, "generator.rng_seed", global_seed));
+    cfg.generator.arrivals_rate = get_double(kv, "arrivals.rate", 0.05);
+    cfg.generator.arrivals_csv_path = get_string(kv, "arrivals.csv", "");
+    cfg.generator.arrivals_stream_path = get_string(kv, "arrivals.stream", "");
+    cfg.generator.stream_lookahead = static_cast<std::size_t>(std::max(1, get_int(kv, "arrivals.stream_lookahead", 64)));
+    cfg.generator.max_patients = get_int(kv, "arrivals.max_patients", 100);
+    cfg.generator.default_age = get_int(kv, "patients.default_age", 70);
+
+    // Case manager
+    cfg.case_manager.rng_seed = static_cast<unsigned>(get_int(kv, "case_manager.rng_seed", global_seed + 1));
+    cfg.case_manager.consent_p_accept = get_double(kv, "consent.p_accept", 1.0);
+
+    // Medical staff
+    cfg.medical_staff.doctors = get_int(kv, "router.doctors", 3);
+    cfg.medical_staff.service_mean = get_double(kv, "service.mean", 600.0);
+    cfg.medical_staff.patience_mean = get_double(kv, "patience.mean", 0.0);
+    cfg.medical_staff.patience_tick = get_double(kv, "patience.tick", 1.0);
+    cfg.medical_staff.rng_seed_base = static_cast<unsigned>(get_int(kv, "service.rng_seed_base", 1000));
+    cfg.medical_staff.routing = parse_routing_policy(get_string(kv, "router.policy", "round_robin"));
+    cfg.medical_staff.flatten = get_bool(kv, "router.flatten", false);
+    const std::string shifts_csv = get_string(kv, "shifts.csv", "");
+    if (!shifts_csv.empty()) {
+        cfg.medical_staff.shifts = std::make_shared<const ShiftCalendar>(
+            read_shifts_csv(shifts_csv, get_double(kv, "shifts.period", 0.0)));
+    }
+
+    // Adherence / decision
+    cfg.adherence.rng_seed = static_cast<unsigned>(get_int(kv, "adherence.rng_seed", global_seed + 2));
+    cfg.adherence.p_continue_base = get_double(kv, "adherence.p_continue_base", 0.30);
+    cfg.adherence.mult_alto = get_double(kv, "adherence.mult_alto", 1.20);
+    cfg.adherence.mult_medio = get_double(kv, "adherence.mult_medio", 1.00);
+    cfg.adherence.mult_bajo = get_double(kv, "adherence.mult_bajo", 0.80);
+    cfg.adherence.max_followups = get_int(kv, "adherence.max_followups", 3);
+    if (cfg.adherence.max_followups > std::numeric_limits<std::int16_t>::max()) {
+        // Patient::followups_done is 16 bits: past this it wraps and the cap never stops the loop
+        throw std::invalid_argument("adherence.max_followups = " + std::to_string(cfg.adherence.max_followups)
+                                    + ": at most " + std::to_string(std::numeric_limits<std::int16_t>::max()));
+    }
+
+    // Follow-up appointments (DA returns booked ahead)
+    cfg.followup.rng_seed = static_cast<unsigned>(get_int(kv, "followup.rng_seed", global_seed + 3));
+    cfg.followup.delay = get_double(kv, "followup.delay", 0.0);
+    cfg.followup.jitter = get_double(kv, "followup.jitter", 0.0);
+
+    // Result cache of the in-memory replications (sweep, optimizer, sensitivity)
+    const std::string cache_dir = get_string(kv, "cache.dir", "");
+    if (!cache_dir.empty()) cfg.cache = open_result_cache(cache_dir);
+
+    return cfg;
+}
+
+/// With shifts.csv the calendar sets the staff on duty and router.doctors is
+/// ignored, so a tool that varies it (sweep axis, what-if branch, sensitivity
+/// factor) would compare identical runs. Throws std::invalid_argument when
+/// `key` is router.doctors and `cfg` has a calendar.
+inline void check_staff_override(const std::string& key, const CesfamConfig& cfg, const std::string& where) {
+    if (key == "router.doctors" && cfg.medical_staff.shifts) {
+        throw std::invalid_argument(where + " varies router.doctors, but shifts.csv sets the staff on duty "
+                                    "(router.doctors is ignored): vary the calendar or drop shifts.csv");
+    }
+}
+
+/// A live feed (arrivals.stream) is read once, as one run consumes it. A tool
+/// that builds several generators (clinics, replications, branches, clones)
+/// would have them all read the same FIFO or stdin concurrently, so only
+/// CESFAM_V2 and CESFAM_REALTIME take it. Throws std::invalid_argument when
+/// `cfg` has a stream.
+inline void check_no_live_feed(const CesfamConfig& cfg, const std::string& where) {
+    if (!cfg.generator.arrivals_stream_path.empty()) {
+        throw std::invalid_argument(where + " can't read arrivals.stream (a live feed is consumed by a single run): "
+                                    "use arrivals.csv or run CESFAM_V2 / CESFAM_REALTIME");
+    }
+}
+
+/// Patients a tool measures (optimizer.risk, rare.risk): one risk level, or
+/// all/todos for every patient (RiskLevel::Unknown). parse_risk() maps any
+/// other word to Unknown as well, so a typo such as "alta" would silently
+/// measure everyone; throws std::invalid_argument instead.
+inline RiskLevel parse_risk_filter(const std::string& key, const std::string& value) {
+    std::string s = trim_copy(value);
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return std::tolower(c); });
+    if (s == "all" || s == "todos") return RiskLevel::Unknown;
+    const RiskLevel r = parse_risk(s);
+    if (r == RiskLevel::Unknown) {
+        throw std::invalid_argument(key + " = '" + value + "': expected alto, medio, bajo (high, medium, low) or all");
+    }
+    return r;
+}
+
+/// Label of a parse_risk_filter() value: the risk level, or "all".
+inline const char* risk_filter_label(RiskLevel r) {
+    return r == RiskLevel::Unknown ? "all" : to_string(r);
+}
+
+/// Online divergence check of in-memory replications (divergence.*).
+inline DivergenceConfig load_divergence_config(const std::unordered_map<std::string, std::string>& kv) {
+    DivergenceConfig d;
+    d.interval = get_double(kv, "divergence.interval", 0.0);
+    d.window = get_int(kv, "divergence.window", d.window);
+    d.confirm = get_int(kv, "divergence.confirm", d.confirm);
+    d.alpha = get_double(kv, "divergence.alpha", d.alpha);
+    return d;
+}
+
+} // namespace cesfam
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils/stats.hpp"
+#include "utils/stepper.hpp"
+#include "utils/worker_pool.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/replication.hpp"
+
+namespace cesfam {
+
+struct RareEventConfig {
+    double threshold = 14400.0;         // seconds: the event is a wait above this
+    RiskLevel risk = RiskLevel::Unknown;   // patients considered (Unknown = all)
+    double until = 86400.0;             // horizon of one run
+
+    int levels = 8;                     // intermediate levels threshold * k / levels
+    int effort = 1000;                  // trajectories per stage (fixed effort)
+    int mc_reps = 0;                    // > 0: also run crude Monte Carlo for comparison
+
+    double confidence = 0.95;
+    unsigned seed_stride = 7919;
+    std::uint64_t seed = 12345;         // clone reseeding
+    unsigned threads = 0;
+};
+
+struct SplittingStage {
+    double level = 0.0;                 // importance value to reach (seconds of wait)
+    std::size_t trials = 0;
+    std::size_t hits = 0;
+    double probability() const { return trials ? static_cast<double>(hits) / static_cast<double>(trials) : 0.0; }
+};
+
+struct RareEventResult {
+    double probability = 0.0;
+    double rel_error = 0.0;             // approximate relative standard error
+    double lower = 0.0;
+    double upper = 0.0;
+    std::vector<SplittingStage> stages;
+    std::size_t events = 0;             // simulation steps over every trajectory
+    std::size_t risk_runs = 0;          // stage-0 trajectories where a `risk` patient reached the staff
+
+    // crude Monte Carlo (mc_reps > 0)
+    std::size_t mc_reps = 0;
+    std::size_t mc_hits = 0;
+    std::size_t mc_events = 0;
+};
+
+/// Importance function: the longest wait, so far, of a `risk` patient that is
+/// queued at a doctor, held by the router while nobody is on duty, or has just
+/// started service (in seconds at time `now`). The event "some `risk` patient
+/// waits more than T" happens exactly when it reaches T.
+inline double oldest_wait(const CESFAM& model, RiskLevel risk, double now) {
+    const auto matches = [risk](const Patient& p) { return risk == RiskLevel::Unknown || p.nivel_riesgo == risk; };
+    // Without shifts queues are FIFO and the first match is the oldest one;
+    // handovers re-append older patients behind younger ones.
+    const bool fifo = !model.staff().calendar();
+    double h = 0.0;
+    for (const auto& p : model.staff().router()->getState().held) {
+        if (matches(p)) h = std::max(h, now - p.hora_llegada);
+    }
+    for (const auto& doc : model.staff().doctors()) {
+        const DoctorState& d = doc->getState();
+        if (d.busy && matches(d.current)) h = std::max(h, d.current.tiempo_espera());
+        for (const auto& p : d.queue) {
+            if (p.estado != PatientStatus::Abandono && matches(p)) {
+                h = std::max(h, now - p.hora_llegada);
+                if (fifo) break;
+            }
+        }
+    }
+    return h;
+}
+
+/// Whether a `risk` patient is at the staff now: held by the router, queued
+/// at a doctor or in service.
+inline bool has_patient(const CESFAM& model, RiskLevel risk) {
+    const auto matches = [risk](const Patient& p) { return risk == RiskLevel::Unknown || p.nivel_riesgo == risk; };
+    const auto& held = model.staff().router()->getState().held;
+    if (std::any_of(held.begin(), held.end(), matches)) return true;
+    for (const auto& doc : model.staff().doctors()) {
+        const DoctorState& d = doc->getState();
+        if (d.busy && matches(d.current)) return true;
+        if (std::any_of(d.queue.begin(), d.queue.end(), matches)) return true;
+    }
+    return false;
+}
+
+/// Gives every RNG of a snapshot a fresh, stream-specific state, so clones of
+/// the same entrance state evolve independently.
+inline void reseed(CesfamSnapshot& snap, std::uint64_t seed, std::uint64_t stream) {
+    std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                      static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)};
+    std::mt19937_64 master(seq);
+    snap.generator.rng.seed(static_cast<std::uint32_t>(master()));
+    snap.case_manager.rng.seed(static_cast<std::uint32_t>(master()));
+    snap.adherence.rng.seed(static_cast<std::uint32_t>(master()));
+    for (auto& d : snap.doctors) d.rng.seed(static_cast<std::uint32_t>(master()));
+    snap.followup.rng.seed(static_cast<std::uint32_t>(master()));
+}
+
+/// Probability that a `risk` patient waits more than `threshold` within one
+/// run of length `until`, by fixed-effort multilevel splitting.
+///
+/// The importance function is oldest_wait(). Stage 0 runs `effort`
+/// independent replications until they reach threshold/levels (or the
+/// horizon); the model state at each crossing is snapshotted. Every next stage
+/// restarts `effort` trajectories from those entrance states (round-robin,
+/// each clone reseeded) towards the next level. The estimate is the product of
+/// the stage hit fractions; its relative error uses the usual
+/// independent-stage approximation sum (1 - p_k) / (n p_k), which ignores the
+/// correlation between clones of one entrance state.
+///
+/// Throws std::invalid_argument if `threshold` is not below `until` (no wait
+/// could exceed it). RareEventResult::risk_runs tells a rare event apart from
+/// an impossible one: 0 means no `risk` patient ever reached the staff.
+class RareEventSplitter {
+  public:
+    RareEventSplitter(CesfamConfig base, RareEventConfig cfg)
+    : base_(std::move(base))
+    , cfg_(std::move(cfg))
+    , pool_(cfg_.threads)
+    {
+        // Every trajectory builds its own generator; they can't share one live feed.
+        if (!base_.generator.arrivals_stream_path.empty()) {
+            throw std::invalid_argument("RareEventSplitter: a live arrival feed (arrivals.stream) can't be split");
+        }
+        if (!(cfg_.threshold < cfg_.until)) {
+            throw std::invalid_argument("RareEventSplitter: threshold (" + std::to_string(cfg_.threshold)
+                                        + " s) must be below the horizon (" + std::to_string(cfg_.until)
+                                        + " s), no wait can exceed it");
+        }
+        base_.exits = nullptr;          // snapshots don't need the exit history
+        base_.journey = nullptr;
+        if (cfg_.levels < 1) cfg_.levels = 1;
+        if (cfg_.effort < 1) cfg_.effort = 1;
+    }
+
+    RareEventResult run() {
+        RareEventResult res;
+        const std::size_t n = static_cast<std::size_t>(cfg_.effort);
+
+        std::vector<std::shared_ptr<const CesfamSnapshot>> entrances;
+        double relvar = 0.0;
+        res.probability = 1.0;
+
+        for (int k = 1; k <= cfg_.levels; ++k) {
+            SplittingStage stage;
+            stage.level = cfg_.threshold * k / cfg_.levels;
+            stage.trials = n;
+
+            std::vector<std::shared_ptr<const CesfamSnapshot>> next(n);
+            std::vector<char> hit(n, 0);
+            std::vector<std::size_t> steps(n, 0);
+            std::vector<char> saw_risk(n, 0);
+            pool_.parallel_for(n, [&](std::size_t j) {
+                Worker& w = acquire();
+                if (k == 1) {
+                    w.start(with_seed_offset(base_, cfg_.seed_stride * static_cast<unsigned>(j)));
+                } else {
+                    CesfamSnapshot s = *entrances[j % entrances.size()];
+                    reseed(s, cfg_.seed, static_cast<std::uint64_t>(k) << 32 | j);
+                    w.start(base_, s);
+                }
+                hit[j] = w.run_to(stage.level, cfg_.risk, cfg_.until, k == 1) ? 1 : 0;
+                saw_risk[j] = w.saw_risk ? 1 : 0;
+                if (hit[j] && k < cfg_.levels) {
+                    next[j] = std::make_shared<const CesfamSnapshot>(w.model->snapshot(w.stepper->now()));
+                }
+                steps[j] = w.stepper->steps();
+                release(w);
+            });
+
+            for (std::size_t j = 0; j < n; ++j) {
+                res.events += steps[j];
+                stage.hits += hit[j];
+                if (k == 1) res.risk_runs += saw_risk[j];
+            }
+            res.stages.push_back(stage);
+
+            const double p = stage.probability();
+            res.probability *= p;
+            if (p == 0.0) break;        // no trajectory reached this level
+            relvar += (1.0 - p) / (static_cast<double>(n) * p);
+
+            entrances.clear();
+            for (auto& s : next) {
+                if (s) entrances.push_back(std::move(s));
+            }
+        }
+
+        if (res.probability > 0.0) {
+            res.rel_error = std::sqrt(relvar);
+            const double z = normal_quantile(0.5 + cfg_.confidence / 2.0);
+            res.lower = std::max(0.0, res.probability * (1.0 - z * res.rel_error));
+            res.upper = res.probability * (1.0 + z * res.rel_error);
+        }
+
+        if (cfg_.mc_reps > 0) run_crude(res);
+        return res;
+    }
+
+  private:
+    // One reusable model + coordinator per concurrent trajectory.
+    struct Worker {
+        std::shared_ptr<CESFAM> model;
+        std::unique_ptr<Stepper> stepper;
+        bool saw_risk = false;          // run_to(..., watch = true) met a `risk` patient
+
+        void start(const CesfamConfig& cfg) {
+            if (model && model->reusable_for(cfg)) {
+                model->reset(cfg);
+                stepper->reset(0.0);
+            } else {
+                model = std::make_shared<CESFAM>("CESFAM", cfg);
+                stepper = std::make_unique<Stepper>(model);
+            }
+            stepper->start();
+        }
+
+        void start(const CesfamConfig& cfg, const CesfamSnapshot& snap) {
+            if (!model) {
+                model = std::make_shared<CESFAM>("CESFAM", cfg);
+                stepper = std::make_unique<Stepper>(model, snap.time);
+            }
+            model->restore(snap);
+            stepper->reset(snap.time);
+            stepper->start();
+        }
+
+        // Simulates until the importance function reaches `level` (true) or
+        // the horizon ends (false). Stops right after the crossing event. With
+        // `watch`, also records in saw_risk whether a `risk` patient showed up.
+        bool run_to(double level, RiskLevel risk, double until, bool watch = false) {
+            saw_risk = !watch;
+            const auto crossed = [&](double now) {
+                if (!saw_risk) saw_risk = has_patient(*model, risk);
+                return oldest_wait(*model, risk, now) >= level;
+            };
+            if (crossed(stepper->now())) return true;
+            while (stepper->time_next() < until) {
+                stepper->advance_one();
+                if (crossed(stepper->now())) return true;
+            }
+            // patients still queued at the horizon
+            stepper->advance_until(until);
+            return crossed(until);
+        }
+    };
+
+    Worker& acquire() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (free_.empty()) {
+            workers_.push_back(std::make_unique<Worker>());
+            return *workers_.back();
+        }
+        Worker* w = free_.back();
+        free_.pop_back();
+        return *w;
+    }
+
+    void release(Worker& w) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        free_.push_back(&w);
+    }
+
+    void run_crude(RareEventResult& res) {
+        const std::size_t n = static_cast<std::size_t>(cfg_.mc_reps);
+        std::vector<char> hit(n, 0);
+        std::vector<std::size_t> steps(n, 0);
+        pool_.parallel_for(n, [&](std::size_t j) {
+            Worker& w = acquire();
+            // different seeds from the splitting stage 0
+            w.start(with_seed_offset(base_, cfg_.seed_stride * static_cast<unsigned>(cfg_.effort + j)));
+            hit[j] = w.run_to(cfg_.threshold, cfg_.risk, cfg_.until) ? 1 : 0;
+            steps[j] = w.stepper->steps();
+            release(w);
+        });
+        res.mc_reps = n;
+        for (std::size_t j = 0; j < n; ++j) {
+            res.mc_hits += hit[j];
+            res.mc_events += steps[j];
+        }
+    }
+
+    CesfamConfig base_;
+    RareEventConfig cfg_;
+    WorkerPool pool_;
+
+    std::mutex mtx_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<Worker*> free_;
+};
+
+} // namespace cesfam
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/async_line_writer.hpp"
+#include "utils/kpi.hpp"
+#include "utils/stepper.hpp"
+#include "top_model/cesfam.hpp"
+
+namespace cesfam {
+
+struct RealtimeConfig {
+    double speed = 60.0;             // simulated seconds per wall-clock second (<= 0: as fast as possible)
+    double kpi_interval = 300.0;     // simulated seconds between KPI records
+    std::string output = "-";        // JSON-lines destination: file, FIFO or "-" (stdout)
+    std::size_t buffer = 256;        // records held for a slow consumer before dropping the oldest
+};
+
+/// Rolling indicators at one instant. Waits are those of the RA exits since the
+/// previous record; counts are cumulative.
+struct KpiTick {
+    double time = 0.0;
+    double lag = 0.0;                // wall-clock seconds behind the paced schedule
+    std::size_t ra = 0;
+    std::size_t rc = 0;
+    std::size_t ab = 0;              // reneged in a doctor queue
+    std::size_t derivados = 0;
+    std::size_t in_system = 0;       // generated and not yet exited
+    std::size_t queued = 0;          // waiting at a doctor or held by the router (CESFAM::queued)
+    std::size_t busy = 0;            // doctors attending
+    std::vector<std::size_t> queues; // per doctor
+    WaitStats wait;
+    std::array<WaitStats, 4> wait_by_risk{};
+    std::size_t dropped = 0;         // records the consumer has missed so far
+};
+
+inline std::string to_json(const KpiTick& k) {
+    auto stats = [](std::ostringstream& os, const WaitStats& w) {
+        os << "{\"n\":" << w.n << ",\"mean\":" << w.mean << ",\"p90\":" << w.p90 << ",\"max\":" << w.max << "}";
+    };
+
+    std::ostringstream os;
+    os << "{\"t\":" << k.time << ",\"lag_s\":" << k.lag << ",\"ra\":" << k.ra << ",\"rc\":" << k.rc
+       << ",\"ab\":" << k.ab << ",\"derivados\":" << k.derivados << ",\"in_system\":" << k.in_system << ",\"queued\":" << k.queued
+       << ",\"busy\":" << k.busy << ",\"queues\":[";
+    for (std::size_t i = 0; i < k.queues.size(); ++i) os << (i ? "," : "") << k.queues[i];
+    os << "],\"wait\":";
+    stats(os, k.wait);
+    os << ",\"wait_by_risk\":{";
+    bool first = true;
+    for (RiskLevel r : {RiskLevel::Alto, RiskLevel::Medio, RiskLevel::Bajo}) {
+        os << (first ? "" : ",") << "\"" << to_string(r) << "\":";
+        stats(os, k.wait_by_risk[static_cast<std::size_t>(r)]);
+        first = false;
+    }
+    os << "},\"dropped\":" << k.dropped << "}";
+    return os.str();
+}
+
+/// Runs the CESFAM paced against the wall clock (`speed` times real time) and
+/// streams a KpiTick as one JSON line every `kpi_interval` simulated seconds.
+///
+/// Every event waits for its wall-clock instant before executing, so records
+/// leave on schedule; if the model can't keep up it runs unpaced and reports
+/// the lag. Records go through an AsyncLineWriter and the simulation never
+/// waits for the consumer.
+class RealtimeRunner {
+  public:
+    RealtimeRunner(CesfamConfig cfg, RealtimeConfig rt)
+    : rt_(std::move(rt))
+    , exits_(std::make_shared<ExitLog>())
+    {
+        if (!(rt_.kpi_interval > 0.0)) rt_.kpi_interval = 300.0;
+        cfg.exits = exits_;
+        model_ = std::make_shared<CESFAM>("CESFAM", cfg);
+    }
+
+    /// Returns the number of KPI records emitted.
+    std::size_t run(double until) {
+        if (until <= 0.0) until = std::numeric_limits<double>::infinity();
+
+        AsyncLineWriter writer(rt_.output, rt_.buffer);
+        Stepper stepper(model_);
+        stepper.start();
+
+        wall0_ = Clock::now();
+        std::size_t records = 0;
+        for (double tick = rt_.kpi_interval; ; tick += rt_.kpi_interval) {
+            const double t_end = std::min(tick, until);
+
+            for (double t = stepper.time_next(); t < t_end; t = stepper.time_next()) {
+                pace(t);
+                stepper.advance_one();
+            }
+            const double lag = pace(t_end);
+            stepper.advance_until(t_end);
+
+            KpiTick k = sample(t_end, lag);
+            k.dropped = writer.dropped();
+            writer.push(to_json(k));
+            ++records;
+
+            if (t_end >= until) break;
+            if (until == std::numeric_limits<double>::infinity() &&
+                stepper.time_next() == std::numeric_limits<double>::infinity()) break;
+        }
+
+        stepper.stop();
+        writer.close();
+        return records;
+    }
+
+    const ExitLog& exits() const { return *exits_; }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    // Sleeps until the wall-clock instant of simulated time t; returns the lag
+    // (seconds) if that instant has already passed.
+    double pace(double t) const {
+        if (!(rt_.speed > 0.0)) return 0.0;
+        const auto target = wall0_ + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(t / rt_.speed));
+        const auto now = Clock::now();
+        if (now < target) {
+            std::this_thread::sleep_until(target);
+            return 0.0;
+        }
+        return std::chrono::duration<double>(now - target).count();
+    }
+
+    KpiTick sample(double t, double lag) {
+        KpiTick k;
+        k.time = t;
+        k.lag = lag;
+        k.ra = exits_->ra.size();
+        k.rc = exits_->rc.size();
+        k.ab = exits_->ab.size();
+
+        std::vector<double> all;
+        std::array<std::vector<double>, 4> by_risk;
+        for (; ra_cursor_ < exits_->ra.size(); ++ra_cursor_) {
+            const Patient& p = exits_->ra[ra_cursor_];
+            all.push_back(p.tiempo_espera());
+            by_risk[static_cast<std::size_t>(p.nivel_riesgo)].push_back(p.tiempo_espera());
+            if (p.resultado == AttentionResult::Derivacion) ++derivados_;
+        }
+        k.derivados = derivados_;
+        k.wait = wait_stats(all);
+        for (std::size_t r = 0; r < by_risk.size(); ++r) k.wait_by_risk[r] = wait_stats(by_risk[r]);
+
+        const auto& doctors = model_->staff().doctors();
+        k.queues.reserve(doctors.size());
+        for (const auto& d : doctors) {
+            const DoctorState& s = d->getState();
+            k.queues.push_back(s.waiting());
+            if (s.busy) ++k.busy;
+        }
+        k.queued = model_->queued();
+        k.in_system = model_->in_system();
+        return k;
+    }
+
+    RealtimeConfig rt_;
+    std::shared_ptr<ExitLog> exits_;
+    std::shared_ptr<CESFAM> model_;
+
+    Clock::time_point wall0_;
+    std::size_t ra_cursor_ = 0;
+    std::size_t derivados_ = 0;
+};
+
+} // namespace cesfam
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils/cadmium_includes.hpp"
+#include "utils/stepper.hpp"
+#include "utils/worker_pool.hpp"
+#include "data_structures/patient.hpp"
+
+#include "atomics/hospital.hpp"
+#include "atomics/recorder.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/replication.hpp"
+
+namespace cesfam {
+
+/// Referral hospital partition: input port fed by the runner + hospital + recorder.
+class HospitalRegional : public cadmium::Coupled {
+  public:
+    cadmium::Port<Patient> In_Derivacion;
+    cadmium::Port<Patient> Out_Paciente;
+
+    HospitalRegional(std::string id, HospitalConfig cfg, std::shared_ptr<ExitLog> exits)
+    : cadmium::Coupled(id)
+    {
+        In_Derivacion = addInPort<Patient>("In_Derivacion");
+        Out_Paciente = addOutPort<Patient>("Out_Paciente");
+
+        auto hosp = addComponent<HospitalReferencia>("HospitalReferencia", cfg);
+        auto reg = addComponent<RegistroSalidas>("RegistroSalidas", std::move(exits));
+
+        addCoupling(In_Derivacion, hosp->In_Derivacion);
+        addCoupling(hosp->Out_Paciente, Out_Paciente);
+        addCoupling(hosp->Out_Paciente, reg->In_PacienteRA);
+    }
+};
+
+struct RegionalConfig {
+    int clinics = 4;
+    double transfer_delay = 1800.0;  // seconds CESFAM -> hospital; also the sync lookahead
+    unsigned threads = 0;            // 0 = hardware concurrency
+
+    unsigned seed_stride = 7919;     // per-clinic offset applied to every seed
+    int id_stride = 1000000;         // per-clinic offset applied to patient ids
+
+    CesfamConfig clinic;             // template for every CESFAM
+    HospitalConfig hospital;
+};
+
+struct ClinicSummary {
+    int clinic = 0;
+    std::size_t ra = 0;
+    std::size_t rc = 0;
+    std::size_t derivados = 0;
+    std::size_t steps = 0;
+};
+
+struct RegionalSummary {
+    std::vector<ClinicSummary> clinics;
+    std::size_t hospital_in = 0;     // referrals delivered to the hospital before `until`
+    std::size_t hospital_out = 0;    // referrals discharged by the hospital
+    std::size_t windows = 0;
+};
+
+/// Regional network: N independent CESFAM models plus one shared referral
+/// hospital, simulated as separate partitions.
+///
+/// Clinics only talk to the hospital, and every referral takes
+/// `transfer_delay` seconds to arrive. That delay is the lookahead of a
+/// conservative synchronization: time is split into windows of length
+/// transfer_delay, all clinics (and the hospital) advance one window in
+/// parallel, and the referrals produced inside the window are delivered to the
+/// hospital at t + transfer_delay, i.e. never before the hospital's next window.
+class RedRegional {
+  public:
+    explicit RedRegional(RegionalConfig cfg)
+    : cfg_(std::move(cfg))
+    , pool_(cfg_.threads)
+    {
+        if (cfg_.clinics <= 0) cfg_.clinics = 1;
+        if (!(cfg_.transfer_delay > 0.0)) {
+            throw std::invalid_argument("region.transfer_delay must be > 0 (it is the synchronization lookahead)");
+        }
+
+        clinics_.reserve(cfg_.clinics);
+        for (int i = 0; i < cfg_.clinics; ++i) {
+            Partition part;
+            part.exits = std::make_shared<ExitLog>();
+
+            CesfamConfig c = clinic_config(i);
+            c.exits = part.exits;
+            part.stepper = std::make_unique<Stepper>(
+                std::make_shared<CESFAM>("CESFAM_" + std::to_string(i), c));
+            clinics_.push_back(std::move(part));
+        }
+
+        hospital_exits_ = std::make_shared<ExitLog>();
+        hospital_model_ = std::make_shared<HospitalRegional>("HospitalRegional", cfg_.hospital, hospital_exits_);
+        hospital_ = std::make_unique<Stepper>(hospital_model_);
+    }
+
+    RegionalSummary run(double until) {
+        if (until <= 0.0) until = std::numeric_limits<double>::infinity();
+
+        for (auto& c : clinics_) c.stepper->start();
+        hospital_->start();
+
+        RegionalSummary summary;
+        const std::size_t n = clinics_.size();
+
+        double w_start = 0.0;
+        while (w_start < until) {
+            const double w_end = std::min(w_start + cfg_.transfer_delay, until);
+
+            // Clinics and hospital are independent inside a window.
+            pool_.parallel_for(n + 1, [&](std::size_t i) {
+                if (i < n) clinics_[i].stepper->advance_until(w_end);
+                else hospital_->advance_until(w_end);
+            });
+
+            // Barrier: hand this window's referrals to the hospital.
+            for (auto& c : clinics_) {
+                const auto& ra = c.exits->ra;
+                for (; c.cursor < ra.size(); ++c.cursor) {
+                    const Patient& p = ra[c.cursor];
+                    if (p.resultado != AttentionResult::Derivacion) continue;
+                    hospital_->inject(hospital_model_->In_Derivacion, p, p.hora_salida + cfg_.transfer_delay);
+                    ++c.derivados;
+                }
+            }
+
+            ++summary.windows;
+            w_start = w_end;
+
+            if (until == std::numeric_limits<double>::infinity() && idle()) break;
+        }
+
+        for (auto& c : clinics_) c.stepper->stop();
+        hospital_->stop();
+
+        for (std::size_t i = 0; i < n; ++i) {
+            ClinicSummary cs;
+            cs.clinic = static_cast<int>(i);
+            cs.ra = clinics_[i].exits->ra.size();
+            cs.rc = clinics_[i].exits->rc.size();
+            cs.derivados = clinics_[i].derivados;
+            cs.steps = clinics_[i].stepper->steps();
+            summary.clinics.push_back(cs);
+        }
+        summary.hospital_in = hospital_in();
+        summary.hospital_out = hospital_exits_->ra.size();
+        return summary;
+    }
+
+    const ExitLog& clinic_exits(int i) const { return *clinics_.at(static_cast<std::size_t>(i)).exits; }
+    const ExitLog& hospital_exits() const { return *hospital_exits_; }
+
+  private:
+    struct Partition {
+        std::unique_ptr<Stepper> stepper;
+        std::shared_ptr<ExitLog> exits;
+        std::size_t cursor = 0;      // next RA record to inspect for referrals
+        std::size_t derivados = 0;
+    };
+
+    CesfamConfig clinic_config(int i) const {
+        CesfamConfig c = with_seed_offset(cfg_.clinic, cfg_.seed_stride * static_cast<unsigned>(i));
+        c.generator.id_offset = cfg_.id_stride * i;
+        return c;
+    }
+
+    bool idle() const {
+        for (const auto& c : clinics_) {
+            if (c.stepper->time_next() != std::numeric_limits<double>::infinity()) return false;
+        }
+        return hospital_->time_next() == std::numeric_limits<double>::infinity();
+    }
+
+    std::size_t hospital_in() const {
+        std::size_t delivered = 0;
+        for (const auto& c : clinics_) {
+            for (const auto& p : c.exits->ra) {
+                if (p.resultado == AttentionResult::Derivacion &&
+                    p.hora_salida + cfg_.transfer_delay < hospital_->now()) ++delivered;
+            }
+        }
+        return delivered;
+    }
+
+    RegionalConfig cfg_;
+    WorkerPool pool_;
+
+    std::vector<Partition> clinics_;
+
+    std::shared_ptr<ExitLog> hospital_exits_;
+    std::shared_ptr<HospitalRegional> hospital_model_;
+    std::unique_ptr<Stepper> hospital_;
+};
+
+} // namespace cesfam
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "utils/divergence.hpp"
+#include "utils/kpi.hpp"
+#include "utils/stepper.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/result_cache.hpp"
+
+namespace cesfam {
+
+/// Same configuration with every RNG seed shifted by `offset` (independent
+/// replication / independent clinic).
+inline CesfamConfig with_seed_offset(CesfamConfig c, unsigned offset) {
+    c.generator.rng_seed += offset;
+    c.case_manager.rng_seed += offset;
+    c.medical_staff.rng_seed_base += offset;
+    c.adherence.rng_seed += offset;
+    c.followup.rng_seed += offset;
+    return c;
+}
+
+/// Runs one replication in memory (no CSV log) and summarizes its exits.
+/// The model state lives in a per-thread arena, dropped in one go once the
+/// model is destroyed.
+///
+/// With an active `div`, the doctor queues and the patients in system are
+/// sampled every div.interval simulated seconds, and a run found divergent
+/// (see DivergenceMonitor) stops there: the summary has diverged = true and
+/// only covers the exits up to stopped_at.
+///
+/// With cfg.cache, a run already simulated by this build (same
+/// configuration, seeds, horizon and divergence check) is read back instead.
+inline KpiSummary run_replication(CesfamConfig cfg, double until, const DivergenceConfig& div = {}) {
+    const std::string key = cfg.cache ? describe_run(cfg, until, div) : std::string();
+    if (cfg.cache) {
+        KpiSummary cached;
+        if (cfg.cache->load(key, cached)) return cached;
+    }
+
+    thread_local const auto arena = std::make_shared<RunArena>();
+    auto exits = std::make_shared<ExitLog>();
+    cfg.exits = exits;
+    cfg.arena = arena;
+
+    bool diverged = false;
+    double end = until;
+    {
+        auto model = std::make_shared<CESFAM>("CESFAM", cfg);
+        Stepper stepper(model);
+        stepper.start();
+        if (div.active()) {
+            DivergenceMonitor monitor(div);
+            for (double t = div.interval; t < until && !diverged; t += div.interval) {
+                stepper.advance_until(t);
+                diverged = monitor.add(static_cast<double>(model->queued()), static_cast<double>(model->in_system()));
+                if (diverged) end = t;
+            }
+        }
+        if (!diverged) stepper.advance_until(until);
+        stepper.stop();
+    }
+    arena->release();
+
+    KpiSummary k = summarize(*exits);
+    k.diverged = diverged;
+    k.stopped_at = diverged ? end : 0.0;
+    if (cfg.cache) cfg.cache->store(key, k, *exits);
+    return k;
+}
+
+/// Runs replications on one reusable model. The CESFAM and its coordinator
+/// are built on the first run and only reset afterwards, unless a
+/// configuration changes the model structure (see CESFAM::reusable_for).
+/// The atomic states live in the runner's arena: a reset recycles their
+/// blocks, and a rebuild drops the old model's memory with one release.
+/// Like run_replication, it reads cached results back (cfg.cache).
+/// Not thread-safe: use one runner per thread.
+class ReplicationRunner {
+  public:
+    explicit ReplicationRunner(bool use_arena = true)
+    : arena_(use_arena ? std::make_shared<RunArena>() : nullptr)
+    {}
+
+    KpiSummary run(CesfamConfig cfg, double until) {
+        exits_->ra.clear();
+        exits_->rc.clear();
+        exits_->ab.clear();
+        cfg.exits = exits_;
+        cfg.arena = arena_;
+
+        const std::shared_ptr<ResultCache> cache = cfg.cache;
+        const std::string key = cache ? describe_run(cfg, until) : std::string();
+        if (cache) {
+            KpiSummary cached;
+            if (cache->load(key, cached, exits_.get())) return cached;
+        }
+
+        if (model_ && model_->reusable_for(cfg)) {
+            model_->reset(std::move(cfg));
+            stepper_->reset();
+        } else {
+            stepper_.reset();
+            model_.reset();
+            if (arena_) arena_->release();
+            model_ = std::make_shared<CESFAM>("CESFAM", std::move(cfg));
+            stepper_ = std::make_unique<Stepper>(model_);
+            ++builds_;
+        }
+
+        stepper_->start();
+        stepper_->advance_until(until);
+        stepper_->stop();
+        KpiSummary k = summarize(*exits_);
+        if (cache) cache->store(key, k, *exits_);
+        return k;
+    }
+
+    /// Models constructed so far (the rest of the runs reused one).
+    std::size_t builds() const { return builds_; }
+
+  private:
+    std::shared_ptr<ExitLog> exits_ = std::make_shared<ExitLog>();
+    std::shared_ptr<RunArena> arena_;
+    std::shared_ptr<CESFAM> model_;
+    std::unique_ptr<Stepper> stepper_;
+    std::size_t builds_ = 0;
+};
+
+} // namespace cesfam
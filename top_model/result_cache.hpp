@@ -0,0 +1,374 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "utils/divergence.hpp"
+#include "utils/kpi.hpp"
+#include "top_model/cesfam.hpp"
+
+namespace cesfam {
+
+namespace detail {
+
+/// 128-bit hash of a byte stream (two independent 64-bit lanes). Names cache
+/// entries; not meant to resist deliberate collisions (entries also keep
+/// their full description, see ResultCache).
+class Hash128 {
+  public:
+    void update(const void* data, std::size_t n) {
+        const auto* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < n; ++i) {
+            a_ = (a_ ^ p[i]) * 0x100000001b3ULL;                     // FNV-1a
+            b_ = (b_ + p[i] + 1) * 0x9e3779b97f4a7c15ULL;
+            b_ ^= b_ >> 29;
+        }
+    }
+    void update(const std::string& s) { update(s.data(), s.size()); }
+
+    std::string hex() const {
+        std::uint64_t a = a_, b = b_;
+        a ^= a >> 33; a *= 0xff51afd7ed558ccdULL; a ^= a >> 33;
+        b ^= b >> 31; b *= 0xc4ceb9fe1a85ec53ULL; b ^= b >> 32;
+        std::ostringstream os;
+        os << std::hex << std::setfill('0') << std::setw(16) << a << std::setw(16) << b;
+        return os.str();
+    }
+
+  private:
+    std::uint64_t a_ = 0xcbf29ce484222325ULL;
+    std::uint64_t b_ = 0x6a09e667f3bcc909ULL;
+};
+
+/// Hash of a whole file's contents ("" if it can't be read).
+inline std::string hash_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return {};
+    Hash128 h;
+    std::vector<char> buf(1 << 16);
+    while (in) {
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        h.update(buf.data(), static_cast<std::size_t>(in.gcount()));
+    }
+    return h.hex();
+}
+
+} // namespace detail
+
+/// Hand-bumped model version for builds outside the makefile, which passes
+/// CESFAM_MODEL_VERSION instead (a hash of the model sources and of the
+/// flags that change results, e.g. BLOCK_RNG). Bump it with any change that
+/// alters what a run produces.
+#ifndef CESFAM_MODEL_VERSION
+#define CESFAM_MODEL_VERSION "model-1"
+#endif
+
+/// Version of the simulated model, the same in every tool built together, so
+/// CESFAM_SWEEP, CESFAM_OPTIMIZER and CESFAM_SENSITIVITY share cache entries.
+inline const char* model_version() { return CESFAM_MODEL_VERSION; }
+
+/// Every input that determines a run's results, one `key = value` per line:
+/// the generator, case manager, medical staff, adherence and follow-up
+/// fields, the contents of the arrivals and shifts files, the horizon and the
+/// divergence check. Seeds are part of the configuration. Empty when the run
+/// can't be cached (live arrival feed, journey table, unreadable arrivals file).
+inline std::string describe_run(const CesfamConfig& cfg, double until, const DivergenceConfig& div = {}) {
+    if (!cfg.generator.arrivals_stream_path.empty() || cfg.journey) return {};
+
+    std::ostringstream os;
+    os.precision(17);
+    const auto& g = cfg.generator;
+    os << "until = " << until << "\n";
+    os << "generator.rng_seed = " << g.rng_seed << "\n";
+    os << "generator.arrivals_rate = " << g.arrivals_rate << "\n";
+    if (!g.arrivals_csv_path.empty()) {
+        const std::string h = detail::hash_file(g.arrivals_csv_path);
+        if (h.empty()) return {};
+        os << "generator.arrivals_csv = " << h << "\n";
+    }
+    os << "generator.max_patients = " << g.max_patients << "\n";
+    os << "generator.default_age = " << g.default_age << "\n";
+    os << "generator.id_offset = " << g.id_offset << "\n";
+
+    os << "case_manager.rng_seed = " << cfg.case_manager.rng_seed << "\n";
+    os << "case_manager.consent_p_accept = " << cfg.case_manager.consent_p_accept << "\n";
+
+    const auto& m = cfg.medical_staff;
+    os << "medical_staff.doctors = " << m.doctors << "\n";
+    os << "medical_staff.service_mean = " << m.service_mean << "\n";
+    os << "medical_staff.rng_seed_base = " << m.rng_seed_base << "\n";
+    os << "medical_staff.routing = " << to_string(m.routing) << "\n";
+    os << "medical_staff.patience_mean = " << m.patience_mean << "\n";
+    os << "medical_staff.patience_tick = " << m.patience_tick << "\n";
+    os << "medical_staff.flatten = " << m.flatten << "\n";
+    if (m.shifts) {
+        os << "medical_staff.shifts.period = " << m.shifts->period << "\n";
+        os << "medical_staff.shifts =";
+        for (const auto& e : m.shifts->entries) os << " " << e.time << ":" << e.doctors;
+        os << "\n";
+    }
+
+    const auto& a = cfg.adherence;
+    os << "adherence.rng_seed = " << a.rng_seed << "\n";
+    os << "adherence.p_continue_base = " << a.p_continue_base << "\n";
+    os << "adherence.mult = " << a.mult_alto << " " << a.mult_medio << " " << a.mult_bajo << "\n";
+    os << "adherence.max_followups = " << a.max_followups << "\n";
+
+    os << "followup.rng_seed = " << cfg.followup.rng_seed << "\n";
+    os << "followup.delay = " << cfg.followup.delay << "\n";
+    os << "followup.jitter = " << cfg.followup.jitter << "\n";
+
+    if (div.active()) {
+        os << "divergence = " << div.interval << " " << div.window << " " << div.confirm << " " << div.alpha << "\n";
+    }
+    return os.str();
+}
+
+/// On-disk, content-addressed cache of replication results: the KPI summary
+/// and the per-patient exits (RA, RC and reneged) of each run.
+///
+/// An entry lives at <dir>/<model version>/<hash of describe_run()>.res and
+/// starts with the description itself, which load() compares in full, so a
+/// different configuration can never be served even if hashes collide. A
+/// changed model gets a new version directory (see model_version): older ones
+/// are never read again and can be deleted. Writes go to a temporary file
+/// renamed into place, so concurrent threads and processes may share a
+/// directory.
+class ResultCache {
+  public:
+    explicit ResultCache(std::string dir, std::string version = model_version())
+    : dir_(std::filesystem::path(dir) / version)
+    , version_(std::move(version))
+    {
+        std::filesystem::create_directories(dir_, error_);
+    }
+
+    const std::filesystem::path& directory() const { return dir_; }
+
+    /// Why the directory couldn't be created (empty if it exists). load()
+    /// and store() of a cache that failed simply miss.
+    const std::error_code& error() const { return error_; }
+
+    /// The stored result of the run `description` (see describe_run), if any.
+    /// `exits` (optional) receives its per-patient outputs.
+    bool load(const std::string& description, KpiSummary& k, ExitLog* exits = nullptr) const {
+        if (description.empty()) return false;
+        std::ifstream in(path_of(description), std::ios::binary);
+        if (!in.is_open() || !read_entry(in, description, k, exits)) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void store(const std::string& description, const KpiSummary& k, const ExitLog& exits) const {
+        if (description.empty()) return;
+        const auto path = path_of(description);
+        std::ostringstream tmp_name;
+        tmp_name << path.string() << ".tmp." << ::getpid() << "." << std::hash<std::thread::id>{}(std::this_thread::get_id());
+        const std::string tmp = tmp_name.str();
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return;   // read-only cache: just don't store
+            out << kMagic << "\n" << version_ << "\n" << description << "\n";
+            write_summary(out, k);
+            write_patients(out, exits.ra);
+            write_patients(out, exits.rc);
+            write_patients(out, exits.ab);
+            out.close();   // flushes: a failing final write (disk full) shows up here
+            if (!out) {
+                std::remove(tmp.c_str());
+                return;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) std::remove(tmp.c_str());
+    }
+
+    std::size_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::size_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    /// "N hits, M misses (<dir>)", for the runners' summaries.
+    std::string stats() const {
+        std::ostringstream os;
+        os << hits() << " hits, " << misses() << " misses (" << dir_.string() << ")";
+        return os.str();
+    }
+
+  private:
+    // Summaries and patients are written field by field (never as raw
+    // structs, whose padding bytes are indeterminate), so identical runs
+    // produce identical files.
+    static constexpr const char* kMagic = "CESFAM-RESULT 2";
+    static constexpr std::size_t kWaitBytes = sizeof(std::uint64_t) + 3 * sizeof(double);
+    static constexpr std::size_t kSummaryBytes = 5 * sizeof(std::uint64_t) + 1 + sizeof(double) + 5 * kWaitBytes;
+    static constexpr std::size_t kPatientBytes = 3 * sizeof(double) + sizeof(PatientId) + sizeof(std::int32_t)
+                                               + 2 * sizeof(std::int16_t) + 3;
+
+    template <class T>
+    static void put(char*& p, T v) {
+        std::memcpy(p, &v, sizeof v);
+        p += sizeof v;
+    }
+    template <class T>
+    static void take(const char*& p, T& v) {
+        std::memcpy(&v, p, sizeof v);
+        p += sizeof v;
+    }
+
+    static void put_wait(char*& p, const WaitStats& w) {
+        put(p, static_cast<std::uint64_t>(w.n));
+        put(p, w.mean);
+        put(p, w.p90);
+        put(p, w.max);
+    }
+    static void take_wait(const char*& p, WaitStats& w) {
+        std::uint64_t n = 0;
+        take(p, n);
+        w.n = static_cast<std::size_t>(n);
+        take(p, w.mean);
+        take(p, w.p90);
+        take(p, w.max);
+    }
+
+    static void write_summary(std::ostream& out, const KpiSummary& k) {
+        char buf[kSummaryBytes];
+        char* p = buf;
+        for (std::size_t v : {k.ra, k.rc, k.altas, k.derivados, k.abandonos}) put(p, static_cast<std::uint64_t>(v));
+        put(p, static_cast<std::uint8_t>(k.diverged));
+        put(p, k.stopped_at);
+        put_wait(p, k.wait);
+        for (const auto& w : k.wait_by_risk) put_wait(p, w);
+        out.write(buf, sizeof buf);
+    }
+
+    static bool read_summary(std::istream& in, KpiSummary& k) {
+        char buf[kSummaryBytes];
+        if (!in.read(buf, sizeof buf)) return false;
+        const char* p = buf;
+        for (std::size_t* v : {&k.ra, &k.rc, &k.altas, &k.derivados, &k.abandonos}) {
+            std::uint64_t n = 0;
+            take(p, n);
+            *v = static_cast<std::size_t>(n);
+        }
+        std::uint8_t diverged = 0;
+        take(p, diverged);
+        k.diverged = diverged != 0;
+        take(p, k.stopped_at);
+        take_wait(p, k.wait);
+        for (auto& w : k.wait_by_risk) take_wait(p, w);
+        return true;
+    }
+
+    std::filesystem::path path_of(const std::string& description) const {
+        detail::Hash128 h;
+        h.update(description);
+        return dir_ / (h.hex() + ".res");
+    }
+
+    bool read_entry(std::istream& in, const std::string& description, KpiSummary& k, ExitLog* exits) const {
+        std::string line;
+        if (!std::getline(in, line) || line != kMagic) return false;
+        if (!std::getline(in, line) || line != version_) return false;
+        std::string stored(description.size(), '\0');
+        if (!in.read(&stored[0], static_cast<std::streamsize>(stored.size())) || stored != description) return false;
+        if (in.get() != '\n') return false;
+
+        KpiSummary summary;
+        if (!read_summary(in, summary)) return false;
+        if (exits) {
+            ExitLog log;
+            if (!read_patients(in, log.ra) || !read_patients(in, log.rc) || !read_patients(in, log.ab)) return false;
+            *exits = std::move(log);
+        }
+        k = summary;
+        return true;
+    }
+
+    static void write_patients(std::ostream& out, const std::vector<Patient>& v) {
+        const std::uint64_t n = v.size();
+        out.write(reinterpret_cast<const char*>(&n), sizeof n);
+        std::vector<char> buf(v.size() * kPatientBytes);
+        char* p = buf.data();
+        for (const Patient& x : v) {
+            put(p, x.hora_llegada);
+            put(p, x.hora_atencion);
+            put(p, x.hora_salida);
+            put(p, x.id_paciente);
+            put(p, x.medico_asignado);
+            put(p, x.edad);
+            put(p, x.followups_done);
+            put(p, x.nivel_riesgo);
+            put(p, x.estado);
+            put(p, x.resultado);
+        }
+        if (n > 0) out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    static bool read_patients(std::istream& in, std::vector<Patient>& v) {
+        std::uint64_t n = 0;
+        if (!in.read(reinterpret_cast<char*>(&n), sizeof n)) return false;
+        std::vector<char> buf(static_cast<std::size_t>(n) * kPatientBytes);
+        if (n > 0 && !in.read(buf.data(), static_cast<std::streamsize>(buf.size()))) return false;
+        v.assign(static_cast<std::size_t>(n), Patient{});
+        const char* p = buf.data();
+        for (Patient& x : v) {
+            take(p, x.hora_llegada);
+            take(p, x.hora_atencion);
+            take(p, x.hora_salida);
+            take(p, x.id_paciente);
+            take(p, x.medico_asignado);
+            take(p, x.edad);
+            take(p, x.followups_done);
+            take(p, x.nivel_riesgo);
+            take(p, x.estado);
+            take(p, x.resultado);
+        }
+        return true;
+    }
+
+    std::filesystem::path dir_;
+    std::string version_;
+    std::error_code error_;
+    mutable std::atomic<std::size_t> hits_{0};
+    mutable std::atomic<std::size_t> misses_{0};
+};
+
+/// One ResultCache per directory and process, so every configuration read
+/// from params.ini shares the same instance (and hit counters). A directory
+/// that can't be created gives no cache (nullptr), with a single [WARN].
+inline std::shared_ptr<ResultCache> open_result_cache(const std::string& dir) {
+    static std::mutex mtx;
+    static std::map<std::string, std::shared_ptr<ResultCache>> open;
+    std::lock_guard<std::mutex> lock(mtx);
+    const auto it = open.find(dir);
+    if (it != open.end()) return it->second;
+    auto c = std::make_shared<ResultCache>(dir);
+    if (c->error()) {
+        std::cerr << "[WARN] Result cache disabled, cannot create " << c->directory().string() << ": "
+                  << c->error().message() << "\n";
+        c = nullptr;
+    }
+    open.emplace(dir, c);
+    return c;
+}
+
+} // namespace cesfam
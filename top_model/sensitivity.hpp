@@ -0,0 +1,454 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/kpi.hpp"
+#include "utils/worker_pool.hpp"
+#include "top_model/params.hpp"
+#include "top_model/replication.hpp"
+
+namespace cesfam {
+
+// ---------------------------------------------------------------------------
+// Global sensitivity analysis.
+//
+// Factors are params.ini keys varied over [lo, hi]. Designs are built in the
+// unit cube and mapped to the ranges; every design row is one configuration
+// (load_cesfam_config over the base keys plus the factor values) simulated
+// `reps` times. Morris screening gives elementary effects (mu*, mu, sigma);
+// the Saltelli design gives first-order and total Sobol indices. Both report
+// bootstrap percentile intervals.
+// ---------------------------------------------------------------------------
+
+enum class SensitivityMethod : std::uint8_t { Morris=0, Sobol };
+
+/// sensitivity.method values; throws std::invalid_argument on any other word.
+inline SensitivityMethod parse_sensitivity_method(const std::string& s) {
+    if (s == "morris") return SensitivityMethod::Morris;
+    if (s == "sobol" || s == "saltelli") return SensitivityMethod::Sobol;
+    throw std::invalid_argument("sensitivity.method = '" + s + "': expected morris or sobol (saltelli)");
+}
+
+/// Scalar response analysed (one per run, averaged over replications).
+enum class SensitivityOutput : std::uint8_t { WaitMean=0, WaitP90, Ra, Derivados };
+
+/// sensitivity.output values; throws std::invalid_argument on any other word.
+inline SensitivityOutput parse_sensitivity_output(const std::string& s) {
+    if (s == "wait_mean") return SensitivityOutput::WaitMean;
+    if (s == "wait_p90") return SensitivityOutput::WaitP90;
+    if (s == "ra") return SensitivityOutput::Ra;
+    if (s == "derivados") return SensitivityOutput::Derivados;
+    throw std::invalid_argument("sensitivity.output = '" + s + "': expected wait_mean, wait_p90, ra or derivados");
+}
+
+inline const char* to_string(SensitivityOutput o) {
+    switch (o) {
+        case SensitivityOutput::WaitP90: return "wait_p90";
+        case SensitivityOutput::Ra: return "ra";
+        case SensitivityOutput::Derivados: return "derivados";
+        default: return "wait_mean";
+    }
+}
+
+inline double sensitivity_response(const KpiSummary& k, SensitivityOutput o) {
+    switch (o) {
+        case SensitivityOutput::WaitP90: return k.wait.p90;
+        case SensitivityOutput::Ra: return static_cast<double>(k.ra);
+        case SensitivityOutput::Derivados: return static_cast<double>(k.derivados);
+        default: return k.wait.mean;
+    }
+}
+
+struct SensitivityFactor {
+    std::string key;       // params.ini key, e.g. "service.mean"
+    double lo = 0.0;
+    double hi = 1.0;
+    bool integer = false;  // values are rounded (e.g. adherence.max_followups)
+
+    double value(double u) const {
+        const double x = lo + u * (hi - lo);
+        return integer ? std::round(x) : x;
+    }
+};
+
+/// Parses "lo, hi". The factor is integer when both bounds are written as
+/// integers.
+inline SensitivityFactor parse_sensitivity_factor(const std::string& key, const std::string& range) {
+    std::stringstream ss(range);
+    std::string lo, hi;
+    std::getline(ss, lo, ',');
+    std::getline(ss, hi, ',');
+    lo = trim_copy(lo);
+    hi = trim_copy(hi);
+    if (lo.empty() || hi.empty()) throw std::invalid_argument("sensitivity factor " + key + ": expected 'lo, hi'");
+
+    auto is_int = [](const std::string& s) { return s.find_first_of(".eE") == std::string::npos; };
+    SensitivityFactor f;
+    f.key = key;
+    f.lo = std::stod(lo);
+    f.hi = std::stod(hi);
+    f.integer = is_int(lo) && is_int(hi);
+    return f;
+}
+
+struct SensitivityConfig {
+    SensitivityMethod method = SensitivityMethod::Morris;
+    SensitivityOutput output = SensitivityOutput::WaitMean;
+
+    int trajectories = 20;              // Morris: r trajectories of k+1 runs
+    int levels = 4;                     // Morris: p-level grid (even)
+    int samples = 128;                  // Sobol: N base rows, N*(k+2) runs
+
+    int reps = 1;                       // replications per design row
+    double until = 3600.0;
+    int bootstrap = 500;
+    double confidence = 0.95;
+
+    std::uint64_t seed = 12345;         // design and bootstrap RNG
+    unsigned seed_stride = 7919;
+    bool common_random_numbers = true;  // same model seeds within a trajectory / base row
+    unsigned threads = 0;
+};
+
+/// Percentile bootstrap interval.
+struct Interval {
+    double lower = 0.0;
+    double upper = 0.0;
+};
+
+struct FactorSensitivity {
+    SensitivityFactor factor;
+
+    // Morris (elementary effects per unit of the normalized range)
+    double mu_star = 0.0;
+    double mu = 0.0;
+    double sigma = 0.0;
+    Interval mu_star_ci;
+
+    // Sobol
+    double s1 = 0.0;
+    double st = 0.0;
+    Interval s1_ci;
+    Interval st_ci;
+};
+
+struct SensitivityResult {
+    SensitivityMethod method = SensitivityMethod::Morris;
+    std::vector<FactorSensitivity> factors;
+    std::size_t runs = 0;               // design rows x reps
+    std::size_t builds = 0;             // models constructed (the other runs reused one)
+    double mean = 0.0;                  // response mean over the design
+    double variance = 0.0;              // response variance over the design
+};
+
+/// Replication runners shared by the pool threads: each call takes a free
+/// runner (building one only when none is free) so models are reused across
+/// design rows.
+class RunnerPool {
+  public:
+    KpiSummary run(const CesfamConfig& cfg, double until) {
+        std::unique_ptr<ReplicationRunner> r;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!free_.empty()) {
+                r = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+        if (!r) r = std::make_unique<ReplicationRunner>();
+        const std::size_t before = r->builds();
+        KpiSummary k = r->run(cfg, until);
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        builds_ += r->builds() - before;
+        free_.push_back(std::move(r));
+        return k;
+    }
+
+    std::size_t builds() const { return builds_; }
+
+  private:
+    std::mutex mtx_;
+    std::vector<std::unique_ptr<ReplicationRunner>> free_;
+    std::size_t builds_ = 0;
+};
+
+namespace detail {
+
+using KV = std::unordered_map<std::string, std::string>;
+
+inline std::string format_value(double v, bool integer) {
+    if (integer) return std::to_string(static_cast<long long>(v));
+    std::ostringstream os;
+    os.precision(17);
+    os << v;
+    return os.str();
+}
+
+/// Simulates every unit-cube row (`reps` replications each) and returns the
+/// mean response per row. Rows with the same `block` share model seeds when
+/// common random numbers are on.
+inline std::vector<double> evaluate_design(const KV& base, const std::vector<SensitivityFactor>& factors,
+                                           const std::vector<std::vector<double>>& rows,
+                                           const std::vector<std::size_t>& block, const SensitivityConfig& cfg,
+                                           SensitivityResult& res) {
+    const std::size_t reps = static_cast<std::size_t>(std::max(1, cfg.reps));
+
+    std::vector<CesfamConfig> configs(rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        KV kv = base;
+        for (std::size_t f = 0; f < factors.size(); ++f) {
+            kv[factors[f].key] = format_value(factors[f].value(rows[i][f]), factors[f].integer);
+        }
+        configs[i] = load_cesfam_config(kv);
+        for (const auto& f : factors) check_staff_override(f.key, configs[i], "sensitivity factor " + f.key);
+        check_no_live_feed(configs[i], "sensitivity");
+    }
+
+    std::vector<double> y(rows.size() * reps);
+    RunnerPool runners;
+    WorkerPool pool(cfg.threads);
+    pool.parallel_for(y.size(), [&](std::size_t j) {
+        const std::size_t row = j / reps;
+        const std::size_t r = j % reps;
+        const std::size_t stream = (cfg.common_random_numbers ? block[row] : row) * reps + r;
+        const CesfamConfig c = with_seed_offset(configs[row], cfg.seed_stride * static_cast<unsigned>(stream));
+        y[j] = sensitivity_response(runners.run(c, cfg.until), cfg.output);
+    });
+
+    std::vector<double> out(rows.size(), 0.0);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        for (std::size_t r = 0; r < reps; ++r) out[i] += y[i * reps + r];
+        out[i] /= static_cast<double>(reps);
+    }
+
+    res.runs += y.size();
+    res.builds += runners.builds();
+    const double m = std::accumulate(out.begin(), out.end(), 0.0) / static_cast<double>(out.size());
+    double ss = 0.0;
+    for (double v : out) ss += (v - m) * (v - m);
+    res.mean = m;
+    res.variance = out.size() > 1 ? ss / static_cast<double>(out.size() - 1) : 0.0;
+    return out;
+}
+
+inline Interval percentile_interval(std::vector<double> v, double confidence) {
+    Interval ci;
+    if (v.empty()) return ci;
+    const double alpha = (1.0 - confidence) / 2.0;
+    ci.lower = quantile(v, alpha);
+    ci.upper = quantile(std::move(v), 1.0 - alpha);
+    return ci;
+}
+
+} // namespace detail
+
+/// Morris elementary effects.
+///
+/// Each trajectory starts at a random point of the p-level grid and moves one
+/// factor at a time (random order and direction) by delta = p / (2(p-1)), so k
+/// factors cost r(k+1) rows. mu* (mean |EE|) ranks the factors, sigma flags
+/// interactions/non-linearity; the mu* interval resamples trajectories.
+inline SensitivityResult run_morris(const std::unordered_map<std::string, std::string>& base,
+                                    const std::vector<SensitivityFactor>& factors, SensitivityConfig cfg) {
+    const std::size_t k = factors.size();
+    const std::size_t r = static_cast<std::size_t>(std::max(2, cfg.trajectories));
+    const int p = std::max(2, cfg.levels);
+    const int steps = std::max(1, p / 2);                               // grid steps per move
+    const double delta = static_cast<double>(steps) / (p - 1);          // p / (2(p-1)) for even p
+
+    SensitivityResult res;
+    res.method = SensitivityMethod::Morris;
+    if (k == 0) return res;
+
+    std::mt19937_64 rng(cfg.seed);
+    std::vector<std::vector<double>> rows;
+    std::vector<std::size_t> block;
+    std::vector<std::vector<std::size_t>> order(r);     // factor moved at each step
+    std::vector<std::vector<int>> dir(r);               // +1 up, -1 down, per factor
+    rows.reserve(r * (k + 1));
+
+    for (std::size_t t = 0; t < r; ++t) {
+        std::vector<double> x(k);
+        dir[t].resize(k);
+        for (std::size_t f = 0; f < k; ++f) {
+            dir[t][f] = std::uniform_int_distribution<int>(0, 1)(rng) ? 1 : -1;
+            // start level such that the move stays on the grid
+            const int lvl = std::uniform_int_distribution<int>(0, p - 1 - steps)(rng);
+            x[f] = static_cast<double>(dir[t][f] > 0 ? lvl : lvl + steps) / (p - 1);
+        }
+        order[t].resize(k);
+        std::iota(order[t].begin(), order[t].end(), 0);
+        std::shuffle(order[t].begin(), order[t].end(), rng);
+
+        rows.push_back(x);
+        block.push_back(t);
+        for (std::size_t f : order[t]) {
+            x[f] += dir[t][f] * delta;
+            rows.push_back(x);
+            block.push_back(t);
+        }
+    }
+
+    const std::vector<double> y = detail::evaluate_design(base, factors, rows, block, cfg, res);
+
+    // ee[f][t]
+    std::vector<std::vector<double>> ee(k, std::vector<double>(r));
+    for (std::size_t t = 0; t < r; ++t) {
+        for (std::size_t s = 0; s < k; ++s) {
+            const std::size_t f = order[t][s];
+            const double dy = y[t * (k + 1) + s + 1] - y[t * (k + 1) + s];
+            ee[f][t] = dir[t][f] * dy / delta;
+        }
+    }
+
+    auto mu_star = [&](std::size_t f, const std::vector<std::size_t>& idx) {
+        double s = 0.0;
+        for (std::size_t t : idx) s += std::abs(ee[f][t]);
+        return s / static_cast<double>(idx.size());
+    };
+
+    std::vector<std::size_t> all(r);
+    std::iota(all.begin(), all.end(), 0);
+    std::vector<std::vector<double>> boot(k);
+    std::vector<std::size_t> idx(r);
+    for (int b = 0; b < cfg.bootstrap; ++b) {
+        for (auto& i : idx) i = std::uniform_int_distribution<std::size_t>(0, r - 1)(rng);
+        for (std::size_t f = 0; f < k; ++f) boot[f].push_back(mu_star(f, idx));
+    }
+
+    for (std::size_t f = 0; f < k; ++f) {
+        FactorSensitivity fs;
+        fs.factor = factors[f];
+        fs.mu_star = mu_star(f, all);
+        fs.mu = std::accumulate(ee[f].begin(), ee[f].end(), 0.0) / static_cast<double>(r);
+        double ss = 0.0;
+        for (double v : ee[f]) ss += (v - fs.mu) * (v - fs.mu);
+        fs.sigma = std::sqrt(ss / static_cast<double>(r - 1));
+        fs.mu_star_ci = detail::percentile_interval(std::move(boot[f]), cfg.confidence);
+        res.factors.push_back(std::move(fs));
+    }
+    return res;
+}
+
+/// First-order and total Sobol indices (Saltelli design).
+///
+/// Two independent N x k sample matrices A and B (the two halves of a
+/// randomly shifted 2k-dimensional Kronecker low-discrepancy sequence) plus,
+/// per factor, A with that column taken from B: N(k+2) rows. S1 uses the
+/// Saltelli (2010) estimator and ST Jansen's; intervals resample the N base
+/// rows.
+inline SensitivityResult run_sobol(const std::unordered_map<std::string, std::string>& base,
+                                   const std::vector<SensitivityFactor>& factors, SensitivityConfig cfg) {
+    const std::size_t k = factors.size();
+    const std::size_t n = static_cast<std::size_t>(std::max(2, cfg.samples));
+
+    SensitivityResult res;
+    res.method = SensitivityMethod::Sobol;
+    if (k == 0) return res;
+
+    // R_d sequence: alpha_d = phi_d^-(d+1), phi_d the root of x^(d+1) = x + 1.
+    const std::size_t dims = 2 * k;
+    double phi = 2.0;
+    for (int it = 0; it < 64; ++it) phi = std::pow(1.0 + phi, 1.0 / static_cast<double>(dims + 1));
+    std::mt19937_64 rng(cfg.seed);
+    std::vector<double> alpha(dims), shift(dims);
+    for (std::size_t d = 0; d < dims; ++d) {
+        alpha[d] = std::fmod(std::pow(1.0 / phi, static_cast<double>(d + 1)), 1.0);
+        shift[d] = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    }
+
+    // Row layout per base sample j: A_j, B_j, AB_j^(0..k-1).
+    std::vector<std::vector<double>> rows;
+    std::vector<std::size_t> block;
+    rows.reserve(n * (k + 2));
+    for (std::size_t j = 0; j < n; ++j) {
+        std::vector<double> a(k), b(k);
+        for (std::size_t d = 0; d < k; ++d) {
+            a[d] = std::fmod(shift[d] + static_cast<double>(j + 1) * alpha[d], 1.0);
+            b[d] = std::fmod(shift[k + d] + static_cast<double>(j + 1) * alpha[k + d], 1.0);
+        }
+        rows.push_back(a);
+        rows.push_back(b);
+        for (std::size_t f = 0; f < k; ++f) {
+            std::vector<double> ab = a;
+            ab[f] = b[f];
+            rows.push_back(std::move(ab));
+        }
+        block.insert(block.end(), k + 2, j);
+    }
+
+    const std::vector<double> y = detail::evaluate_design(base, factors, rows, block, cfg, res);
+    const std::size_t stride = k + 2;
+    auto fa = [&](std::size_t j) { return y[j * stride]; };
+    auto fb = [&](std::size_t j) { return y[j * stride + 1]; };
+    auto fab = [&](std::size_t j, std::size_t f) { return y[j * stride + 2 + f]; };
+
+    // indices[f] = {S1, ST} over the base rows in `idx`
+    auto indices = [&](const std::vector<std::size_t>& idx) {
+        double m = 0.0;
+        for (std::size_t j : idx) m += fa(j) + fb(j);
+        m /= static_cast<double>(2 * idx.size());
+        double v = 0.0;
+        for (std::size_t j : idx) v += (fa(j) - m) * (fa(j) - m) + (fb(j) - m) * (fb(j) - m);
+        v /= static_cast<double>(2 * idx.size() - 1);
+
+        std::vector<std::pair<double, double>> out(k, {0.0, 0.0});
+        if (v <= 0.0) return out;
+        for (std::size_t f = 0; f < k; ++f) {
+            double s1 = 0.0, st = 0.0;
+            for (std::size_t j : idx) {
+                s1 += fb(j) * (fab(j, f) - fa(j));
+                st += (fa(j) - fab(j, f)) * (fa(j) - fab(j, f));
+            }
+            out[f] = {s1 / static_cast<double>(idx.size()) / v, st / (2.0 * static_cast<double>(idx.size())) / v};
+        }
+        return out;
+    };
+
+    std::vector<std::size_t> all(n);
+    std::iota(all.begin(), all.end(), 0);
+    const auto point = indices(all);
+
+    std::vector<std::vector<double>> boot_s1(k), boot_st(k);
+    std::vector<std::size_t> idx(n);
+    for (int b = 0; b < cfg.bootstrap; ++b) {
+        for (auto& i : idx) i = std::uniform_int_distribution<std::size_t>(0, n - 1)(rng);
+        const auto s = indices(idx);
+        for (std::size_t f = 0; f < k; ++f) {
+            boot_s1[f].push_back(s[f].first);
+            boot_st[f].push_back(s[f].second);
+        }
+    }
+
+    for (std::size_t f = 0; f < k; ++f) {
+        FactorSensitivity fs;
+        fs.factor = factors[f];
+        fs.s1 = point[f].first;
+        fs.st = point[f].second;
+        fs.s1_ci = detail::percentile_interval(std::move(boot_s1[f]), cfg.confidence);
+        fs.st_ci = detail::percentile_interval(std::move(boot_st[f]), cfg.confidence);
+        res.factors.push_back(std::move(fs));
+    }
+    return res;
+}
+
+inline SensitivityResult run_sensitivity(const std::unordered_map<std::string, std::string>& base,
+                                         const std::vector<SensitivityFactor>& factors, const SensitivityConfig& cfg) {
+    return cfg.method == SensitivityMethod::Sobol ? run_sobol(base, factors, cfg) : run_morris(base, factors, cfg);
+}
+
+} // namespace cesfam
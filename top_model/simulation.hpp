@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "utils/arena.hpp"
+#include "utils/kpi.hpp"
+#include "utils/stepper.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/replication.hpp"
+
+namespace cesfam {
+
+/// The CESFAM as a library, for callers that run it many times in process
+/// (e.g. a scheduling service): build once, then reset(seed) and run(until),
+/// and read the KPIs in memory.
+///
+/// The model and its coordinator are built by the constructor and never
+/// again: reset() only puts every atomic back in its initial state with new
+/// seeds (CESFAM::reset), so ports and couplings are kept. No file is read or
+/// written beyond what the configuration asks for (arrivals.csv, a journey
+/// table); there is no params.ini and no Cadmium log. A journey table has no
+/// replication column, so a Simulation that writes one runs once: reset()
+/// throws. Instances share no state, so independent Simulations can run
+/// concurrently, one thread each.
+class Simulation {
+  public:
+    explicit Simulation(CesfamConfig cfg)
+    : base_(std::move(cfg))
+    {
+        if (!base_.exits) base_.exits = std::make_shared<ExitLog>();
+        if (!base_.arena) base_.arena = std::make_shared<RunArena>();
+        model_ = std::make_shared<CESFAM>("CESFAM", base_);
+        stepper_ = std::make_unique<Stepper>(model_);
+        stepper_->set_live(base_.live.get());
+    }
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /// Back to t = 0 with every RNG seed of the configuration shifted by
+    /// `seed` (as with_seed_offset: 0 gives the configured seeds, replication
+    /// r of a study uses reset(r)). The exit record is cleared. Throws
+    /// std::logic_error if the configuration writes a journey table.
+    void reset(unsigned seed = 0) {
+        reject_journey();
+        load(with_seed_offset(base_, seed));
+    }
+
+    /// Back to t = 0 with a new configuration of the same structure (see
+    /// CESFAM::reusable_for); it becomes the base of later reset(seed) calls.
+    /// Throws std::invalid_argument if it would change the model structure,
+    /// std::logic_error if the configuration writes a journey table.
+    void reset(CesfamConfig cfg) {
+        reject_journey();
+        cfg.exits = base_.exits;
+        cfg.arena = base_.arena;
+        cfg.live = base_.live;
+        if (!model_->reusable_for(cfg)) {
+            throw std::invalid_argument("Simulation::reset: the configuration changes the model structure");
+        }
+        base_ = cfg;
+        load(std::move(cfg));
+    }
+
+    /// Simulates up to absolute time `until`, continuing from now(), and
+    /// returns the indicators of every exit so far. Events at exactly `until`
+    /// are left for the next call.
+    KpiSummary run(double until) {
+        if (!started_) {
+            stepper_->start();
+            started_ = true;
+        }
+        stepper_->advance_until(until);
+        return kpis();
+    }
+
+    /// Indicators of the exits recorded since the last reset.
+    KpiSummary kpis() const { return summarize(*base_.exits); }
+
+    double now() const { return stepper_->now(); }
+    const ExitLog& exits() const { return *base_.exits; }
+    const CesfamConfig& config() const { return model_->config(); }
+    const CESFAM& model() const { return *model_; }
+
+  private:
+    // Another replication would append to the same table with ids and times
+    // starting over, mixing up the runs for CESFAM_JOURNEY.
+    void reject_journey() const {
+        if (base_.journey) {
+            throw std::logic_error("Simulation::reset: a journey table records a single run; build a new Simulation");
+        }
+    }
+
+    void load(CesfamConfig cfg) {
+        if (started_) {
+            stepper_->stop();
+            started_ = false;
+        }
+        base_.exits->ra.clear();
+        base_.exits->rc.clear();
+        base_.exits->ab.clear();
+        model_->reset(std::move(cfg));
+        stepper_->reset();
+        if (base_.live) base_.live->reset();
+    }
+
+    CesfamConfig base_;
+    std::shared_ptr<CESFAM> model_;
+    std::unique_ptr<Stepper> stepper_;
+    bool started_ = false;
+};
+
+} // namespace cesfam
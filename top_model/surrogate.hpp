@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/ini_reader.hpp"
+#include "utils/kriging.hpp"
+#include "utils/stats.hpp"
+
+namespace cesfam {
+
+// ---------------------------------------------------------------------------
+// Metamodel of sweep results.
+//
+// The training data are sweep_results.csv files (CESFAM_SWEEP): the swept
+// params.ini keys are the columns before `rho`, the response is the
+// replication mean of the wait and its variance comes back from the
+// confidence interval (half width / t)^2. Keys that take a single value are
+// fixed and dropped; the others are scaled to [0, 1] over the observed range
+// and fed to a StochasticKriging model.
+// ---------------------------------------------------------------------------
+
+struct SurrogateAxis {
+    std::string key;
+    double lo = 0.0;
+    double hi = 1.0;
+    bool integer = true;       // every observed value was an integer (e.g. router.doctors)
+
+    double unit(double v) const { return hi > lo ? (v - lo) / (hi - lo) : 0.0; }
+    double value(double u) const {
+        const double v = lo + u * (hi - lo);
+        return integer ? std::round(v) : v;
+    }
+};
+
+struct SurrogateData {
+    std::vector<SurrogateAxis> axes;
+    std::vector<std::vector<double>> x;   // raw values, one row per design point
+    std::vector<double> y;                // mean wait
+    std::vector<double> noise;            // variance of the mean
+    std::size_t skipped = 0;              // rows without a usable interval (screened, divergent, < 2 replications)
+};
+
+namespace detail {
+
+inline std::vector<std::string> split_fields(const std::string& line, const std::string& sep) {
+    std::vector<std::string> out;
+    std::size_t pos = 0;
+    while (true) {
+        const std::size_t next = line.find(sep, pos);
+        out.push_back(trim_copy(line.substr(pos, next == std::string::npos ? std::string::npos : next - pos)));
+        if (next == std::string::npos) break;
+        pos = next + sep.size();
+    }
+    return out;
+}
+
+inline bool parse_number(const std::string& s, double& v) {
+    try {
+        std::size_t used = 0;
+        v = std::stod(s, &used);
+        return used == s.size() && std::isfinite(v);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace detail
+
+/// Reads the design points of one or more sweep results files (same swept
+/// keys, in any column order). `confidence` is the sweep.confidence the files
+/// were written with. Rows with divergent replications are skipped: older
+/// sweeps still wrote the survivors' (low-biased) mean for them. Throws
+/// std::runtime_error on unreadable files, files with other keys, or keys
+/// with non-numeric values that vary.
+inline SurrogateData read_sweep_results(const std::vector<std::string>& paths, const std::string& sep,
+                                        double confidence) {
+    std::vector<std::string> keys;
+    std::vector<std::vector<std::string>> raw;   // key values of each usable row
+    SurrogateData data;
+
+    for (const auto& path : paths) {
+        std::ifstream in(path);
+        if (!in.is_open()) throw std::runtime_error("Cannot open sweep results: " + path);
+        std::string line;
+        if (!std::getline(in, line)) throw std::runtime_error("Empty sweep results: " + path);
+        const std::vector<std::string> header = detail::split_fields(line, sep);
+
+        std::unordered_map<std::string, std::size_t> col;
+        for (std::size_t i = 0; i < header.size(); ++i) col[header[i]] = i;
+        const auto rho = std::find(header.begin(), header.end(), "rho");
+        const bool has_diverged = col.count("diverged") > 0;
+        for (const char* c : {"reps", "wait_mean_s", "wait_mean_upper_s"}) {
+            if (!col.count(c)) throw std::runtime_error("Not a sweep results file (no " + std::string(c) + "): " + path);
+        }
+        std::vector<std::string> file_keys(header.begin(), rho);
+        std::vector<std::string> sorted = file_keys;
+        std::sort(sorted.begin(), sorted.end());
+        if (keys.empty()) {
+            keys = sorted;
+        } else if (keys != sorted) {
+            throw std::runtime_error("Sweep results with other swept keys: " + path);
+        }
+
+        while (std::getline(in, line)) {
+            if (trim_copy(line).empty()) continue;
+            const std::vector<std::string> f = detail::split_fields(line, sep);
+            if (f.size() != header.size()) continue;
+            double reps = 0.0, mean = 0.0, upper = 0.0, diverged = 0.0;
+            if (has_diverged && (!detail::parse_number(f[col["diverged"]], diverged) || diverged > 0.0)) {
+                ++data.skipped;
+                continue;
+            }
+            if (!detail::parse_number(f[col["reps"]], reps) || !detail::parse_number(f[col["wait_mean_s"]], mean) ||
+                !detail::parse_number(f[col["wait_mean_upper_s"]], upper) || reps < 2.0) {
+                ++data.skipped;
+                continue;
+            }
+            const double t = student_t_quantile(0.5 + confidence / 2.0, reps - 1.0);
+            const double se = (upper - mean) / t;
+            std::vector<std::string> row;
+            for (const auto& k : keys) row.push_back(f[col[k]]);
+            raw.push_back(std::move(row));
+            data.y.push_back(mean);
+            data.noise.push_back(se * se);
+        }
+    }
+
+    // Keep the keys that vary; they must be numeric.
+    std::vector<std::size_t> used;
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+        bool varies = false, numeric = true, integer = true;
+        double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+        for (const auto& row : raw) {
+            varies = varies || row[k] != raw.front()[k];
+            double v = 0.0;
+            if (!detail::parse_number(row[k], v)) {
+                numeric = false;
+                continue;
+            }
+            integer = integer && v == std::round(v);
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        if (!varies) continue;
+        if (!numeric || !(hi > lo)) {
+            throw std::runtime_error("Swept key with non-numeric values: " + keys[k] +
+                                     " (fit one metamodel per value of it)");
+        }
+        SurrogateAxis a;
+        a.key = keys[k];
+        a.lo = lo;
+        a.hi = hi;
+        a.integer = integer;
+        data.axes.push_back(a);
+        used.push_back(k);
+    }
+    for (const auto& row : raw) {
+        std::vector<double> x;
+        for (std::size_t k : used) {
+            double v = 0.0;
+            detail::parse_number(row[k], v);
+            x.push_back(v);
+        }
+        data.x.push_back(std::move(x));
+    }
+    return data;
+}
+
+/// Predicted mean wait with its uncertainty and a confidence interval.
+struct SurrogatePrediction {
+    double mean = 0.0;
+    double sd = 0.0;
+    double lower = 0.0;
+    double upper = 0.0;
+};
+
+/// A fitted metamodel with the axes of its training data: predictions take
+/// raw parameter values in axis order.
+///
+/// With `log_scale` (the default) the model is fitted to log(wait), with the
+/// variance of each mean carried over by the delta method (s^2 / y^2): waits
+/// grow multiplicatively towards saturation, and on the log scale one length
+/// scale fits the whole range. Predictions are then exp of the kriging mean
+/// (a median), with the interval mapped back.
+class SweepSurrogate {
+  public:
+    explicit SweepSurrogate(SurrogateData data, bool log_scale = true, double confidence = 0.95)
+    : data_(std::move(data))
+    , log_(log_scale)
+    , z_(normal_quantile(0.5 + confidence / 2.0))
+    {
+        if (data_.axes.empty()) throw std::runtime_error("Surrogate: no swept key takes more than one value");
+        if (data_.x.size() < 2) throw std::runtime_error("Surrogate: needs at least two simulated points");
+        std::vector<double> y = data_.y, noise = data_.noise;
+        if (log_) {
+            for (std::size_t i = 0; i < y.size(); ++i) {
+                if (!(y[i] > 0.0)) throw std::runtime_error("Surrogate: log scale needs positive waits (set surrogate.log = false)");
+                noise[i] /= y[i] * y[i];
+                y[i] = std::log(y[i]);
+            }
+        }
+        std::vector<std::vector<double>> u;
+        for (const auto& row : data_.x) u.push_back(to_unit(row));
+        model_.fit(std::move(u), std::move(y), std::move(noise));
+    }
+
+    SurrogatePrediction predict(const std::vector<double>& values) const {
+        const KrigingPrediction k = model_.predict(to_unit(values));
+        SurrogatePrediction p;
+        if (log_) {
+            p.mean = std::exp(k.mean);
+            p.sd = p.mean * k.sd;
+            p.lower = std::exp(k.mean - z_ * k.sd);
+            p.upper = std::exp(k.mean + z_ * k.sd);
+        } else {
+            p.mean = k.mean;
+            p.sd = k.sd;
+            p.lower = k.mean - z_ * k.sd;
+            p.upper = k.mean + z_ * k.sd;
+        }
+        return p;
+    }
+
+    /// The `count` candidates (of `candidates` uniform draws over the axis
+    /// ranges) that reduce the uncertainty most, picked greedily: each chosen
+    /// point joins the design with its predicted mean and the median
+    /// variance of the observed means before the next one is picked. The
+    /// uncertainty compared is the model's own (relative, on the log scale).
+    std::vector<std::vector<double>> propose(std::size_t count, std::size_t candidates, std::uint64_t seed) const {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> unif(0.0, 1.0);
+        std::vector<std::vector<double>> pool(candidates);
+        for (auto& c : pool) {
+            for (const auto& a : data_.axes) c.push_back(a.value(unif(rng)));
+        }
+
+        std::vector<double> noise = data_.noise;
+        if (log_) {
+            for (std::size_t i = 0; i < noise.size(); ++i) noise[i] /= data_.y[i] * data_.y[i];
+        }
+        std::nth_element(noise.begin(), noise.begin() + noise.size() / 2, noise.end());
+        const double new_noise = noise[noise.size() / 2];
+
+        StochasticKriging m = model_;
+        std::vector<std::vector<double>> out;
+        while (out.size() < count && !pool.empty()) {
+            std::size_t best = 0;
+            double best_sd = -1.0;
+            for (std::size_t i = 0; i < pool.size(); ++i) {
+                const double sd = m.predict(to_unit(pool[i])).sd;
+                if (sd > best_sd) {
+                    best_sd = sd;
+                    best = i;
+                }
+            }
+            const std::vector<double> u = to_unit(pool[best]);
+            m.add(u, m.predict(u).mean, new_noise);
+            out.push_back(pool[best]);
+            // integer axes repeat candidates: drop every copy of the chosen one
+            const std::vector<double> chosen = pool[best];
+            pool.erase(std::remove(pool.begin(), pool.end(), chosen), pool.end());
+        }
+        return out;
+    }
+
+    /// Leave-one-out root mean square error, in seconds of wait.
+    double loo_rmse() const {
+        if (!log_) return model_.loo_rmse();
+        double ss = 0.0;
+        const std::vector<double> loo = model_.loo_predictions();
+        for (std::size_t i = 0; i < loo.size(); ++i) {
+            const double e = std::exp(loo[i]) - data_.y[i];
+            ss += e * e;
+        }
+        return std::sqrt(ss / static_cast<double>(loo.size()));
+    }
+
+    bool log_scale() const { return log_; }
+    const std::vector<SurrogateAxis>& axes() const { return data_.axes; }
+    const SurrogateData& data() const { return data_; }
+    const StochasticKriging& model() const { return model_; }
+
+  private:
+    std::vector<double> to_unit(const std::vector<double>& values) const {
+        std::vector<double> u(values.size());
+        for (std::size_t k = 0; k < values.size(); ++k) u[k] = data_.axes[k].unit(values[k]);
+        return u;
+    }
+
+    SurrogateData data_;
+    bool log_ = true;
+    double z_ = 1.96;
+    StochasticKriging model_;
+};
+
+} // namespace cesfam
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/divergence.hpp"
+#include "utils/kpi.hpp"
+#include "utils/stats.hpp"
+#include "utils/worker_pool.hpp"
+#include "top_model/cesfam.hpp"
+#include "top_model/replication.hpp"
+#include "top_model/analytic.hpp"
+
+namespace cesfam {
+
+/// One point of a parameter sweep: the overrides that produced it (for the
+/// report) and the resulting configuration.
+struct SweepPoint {
+    std::vector<std::pair<std::string, std::string>> overrides;
+    CesfamConfig config;
+};
+
+struct SweepConfig {
+    int reps = 5;
+    double until = 3600.0;
+    double confidence = 0.95;
+    unsigned seed_stride = 7919;
+    unsigned threads = 0;
+    // Don't simulate points the analytical model finds unstable (rho >= 1).
+    // Same steady-state verdict as OptimizerConfig::screen: over a finite
+    // horizon (until, max_patients) an overloaded point can still have
+    // reasonable waits, so only enable it when `until` is long against the
+    // transient.
+    bool screen = false;
+    DivergenceConfig divergence;        // stop replications whose queues grow without bound (off by default)
+};
+
+struct SweepResult {
+    AnalyticEstimate estimate;
+    bool screened = false;              // unstable point, not simulated
+    std::size_t reps = 0;               // replications simulated
+    std::size_t diverged = 0;           // replications stopped early as divergent
+    MeanCI wait_mean;                   // empty (n = 0) when screened or any replication diverged
+    MeanCI wait_p90;
+    MeanCI ra;                          // RA exits per replication
+
+    /// Unstable according to the analytical model or to the simulation.
+    bool unstable() const { return !estimate.stable || diverged > 0; }
+};
+
+/// Runs every point x replication on one worker pool (replications of all
+/// points are flattened, so a small sweep with many replications and a large
+/// sweep with few both keep every thread busy). Each point also gets the
+/// analytical estimate; with `screen` on, points whose doctors would saturate
+/// are reported from the estimate alone. With `divergence` active, the
+/// replications whose queues keep growing are stopped early and counted in
+/// `diverged`; a point with any divergent replication is unstable and gets no
+/// KPI intervals (the survivors are the low-wait runs, so their mean would be
+/// biased low, and the divergent ones only cover a prefix).
+inline std::vector<SweepResult> run_sweep(const std::vector<SweepPoint>& points, SweepConfig cfg) {
+    if (cfg.reps < 1) cfg.reps = 1;
+    const std::size_t reps = static_cast<std::size_t>(cfg.reps);
+
+    std::vector<SweepResult> results(points.size());
+    std::vector<std::size_t> jobs;      // point index of each simulated point
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        results[i].estimate = estimate_queueing_network(points[i].config);
+        results[i].screened = cfg.screen && !results[i].estimate.stable;
+        if (!results[i].screened) jobs.push_back(i);
+    }
+
+    std::vector<KpiSummary> kpis(jobs.size() * reps);
+    WorkerPool pool(cfg.threads);
+    pool.parallel_for(kpis.size(), [&](std::size_t j) {
+        const std::size_t r = j % reps;
+        const CesfamConfig& base = points[jobs[j / reps]].config;
+        kpis[j] = run_replication(with_seed_offset(base, cfg.seed_stride * static_cast<unsigned>(r)), cfg.until,
+                                  cfg.divergence);
+    });
+
+    for (std::size_t p = 0; p < jobs.size(); ++p) {
+        SweepResult& res = results[jobs[p]];
+        res.reps = reps;
+        for (std::size_t r = 0; r < reps; ++r) res.diverged += kpis[p * reps + r].diverged ? 1 : 0;
+        if (res.diverged > 0) continue;
+
+        std::vector<double> mean, p90, ra;
+        for (std::size_t r = 0; r < reps; ++r) {
+            const KpiSummary& k = kpis[p * reps + r];
+            mean.push_back(k.wait.mean);
+            p90.push_back(k.wait.p90);
+            ra.push_back(static_cast<double>(k.ra));
+        }
+        res.wait_mean = mean_ci(mean, cfg.confidence);
+        res.wait_p90 = mean_ci(p90, cfg.confidence);
+        res.ra = mean_ci(ra, cfg.confidence);
+    }
+    return results;
+}
+
+} // namespace cesfam
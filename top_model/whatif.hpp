@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils/stepper.hpp"
+#include "utils/worker_pool.hpp"
+#include "atomics/recorder.hpp"
+#include "top_model/cesfam.hpp"
+
+namespace cesfam {
+
+struct WhatIfBranch {
+    std::string name;
+    CesfamConfig config;     // policy for this branch (doctors, consent, routing, ...)
+};
+
+struct BranchResult {
+    std::string name;
+    std::shared_ptr<const ExitLog> before;   // pre-fork history, shared by every branch
+    std::shared_ptr<ExitLog> after;          // exits of this branch after the fork
+    std::size_t steps = 0;                   // steps simulated after the fork
+};
+
+/// What-if branching from a single simulated prefix.
+///
+/// The base configuration is simulated once up to the fork time; the model
+/// state is then copied in memory and every branch continues from that copy
+/// under its own configuration, concurrently. The exits before the fork are
+/// kept once and shared (read-only) by all branches. Branches keep the RNG
+/// states of the prefix, so they see common random numbers where their
+/// policies do not change the event sequence.
+class WhatIfFork {
+  public:
+    explicit WhatIfFork(CesfamConfig base, unsigned threads = 0)
+    : base_(std::move(base))
+    , pool_(threads)
+    {
+        // A branch would open its own reader instead of continuing the prefix's feed.
+        if (!base_.generator.arrivals_stream_path.empty()) {
+            throw std::invalid_argument("WhatIfFork: a live arrival feed (arrivals.stream) can't be forked");
+        }
+    }
+
+    /// Simulates the base configuration on [0, t_fork) and snapshots it.
+    std::shared_ptr<const CesfamSnapshot> run_prefix(double t_fork) {
+        CesfamConfig c = base_;
+        c.exits = std::make_shared<ExitLog>();
+
+        auto model = std::make_shared<CESFAM>("CESFAM", c);
+        Stepper stepper(model);
+        stepper.start();
+        stepper.advance_until(t_fork);
+        prefix_steps_ = stepper.steps();
+        return std::make_shared<const CesfamSnapshot>(model->snapshot(t_fork));
+    }
+
+    /// Continues every branch from `snap` until `until`.
+    std::vector<BranchResult> run_branches(const std::shared_ptr<const CesfamSnapshot>& snap,
+                                           const std::vector<WhatIfBranch>& branches,
+                                           double until) {
+        for (const auto& b : branches) {
+            if (!b.config.generator.arrivals_stream_path.empty()) {
+                throw std::invalid_argument("WhatIfFork: branch " + b.name + " reads a live arrival feed (arrivals.stream)");
+            }
+        }
+        std::vector<BranchResult> results(branches.size());
+
+        pool_.parallel_for(branches.size(), [&](std::size_t i) {
+            BranchResult& res = results[i];
+            res.name = branches[i].name;
+            res.before = snap->exits;
+            res.after = std::make_shared<ExitLog>();
+
+            CesfamConfig c = branches[i].config;
+            c.exits = res.after;
+
+            auto model = std::make_shared<CESFAM>("CESFAM", c);
+            model->restore(*snap);
+
+            Stepper stepper(model, snap->time);
+            stepper.start();
+            stepper.advance_until(until);
+            stepper.stop();
+            res.steps = stepper.steps();
+        });
+
+        return results;
+    }
+
+    std::size_t prefix_steps() const { return prefix_steps_; }
+    const CesfamConfig& base() const { return base_; }
+
+  private:
+    CesfamConfig base_;
+    WorkerPool pool_;
+    std::size_t prefix_steps_ = 0;
+};
+
+} // namespace cesfam
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace cesfam {
+
+/// Allocator of the atomic state containers (queues, pending outputs): a
+/// std::pmr::memory_resource pointer (nullptr = the default heap resource).
+///
+/// Unlike std::pmr::polymorphic_allocator it moves with the container:
+/// Cadmium copies the initial state into the model and every reset replaces
+/// the state by assignment, so a resource that stayed with the assigned-to
+/// container would never be the arena. Copies (snapshots) go to the default
+/// resource, so they don't depend on the model's arena.
+///
+/// Two orderings follow for the atomics. Their constructors assign a state
+/// built on cfg_.memory after the base class is constructed, since the base
+/// copies its initial state, and a copy lands on the heap. reset() assigns the
+/// new state before replacing cfg_, whose `memory` keeps the old resource
+/// alive while the old containers are freed.
+template <typename T>
+class StateAllocator {
+  public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    StateAllocator() noexcept = default;
+    StateAllocator(std::pmr::memory_resource* r) noexcept   // NOLINT: implicit, like polymorphic_allocator
+    : r_(r ? r : std::pmr::get_default_resource())
+    {}
+    template <typename U>
+    StateAllocator(const StateAllocator<U>& o) noexcept : r_(o.resource()) {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(r_->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, std::size_t n) { r_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    StateAllocator select_on_container_copy_construction() const { return StateAllocator(); }
+
+    std::pmr::memory_resource* resource() const { return r_; }
+
+  private:
+    std::pmr::memory_resource* r_ = std::pmr::get_default_resource();
+};
+
+template <typename T, typename U>
+bool operator==(const StateAllocator<T>& a, const StateAllocator<U>& b) {
+    return a.resource() == b.resource() || a.resource()->is_equal(*b.resource());
+}
+
+template <typename T, typename U>
+bool operator!=(const StateAllocator<T>& a, const StateAllocator<U>& b) { return !(a == b); }
+
+template <typename T> using state_vector = std::vector<T, StateAllocator<T>>;
+template <typename T> using state_deque = std::deque<T, StateAllocator<T>>;
+
+/// Memory of one simulation model's state containers: a pool of size classes
+/// carved out of a monotonic buffer. Blocks freed during a run go back to the
+/// pool, and release() drops everything at once, so a model is torn down
+/// without returning each of its containers to the global heap. The buffer
+/// grows to the largest run seen, so a steady many-replication workload makes
+/// no heap calls for state at all after the first run.
+///
+/// Every container allocated from the arena must be gone before release()
+/// (destroyed, or moved to another resource). One arena per thread; in
+/// PARALLEL builds, where Cadmium runs the transitions of a model concurrently,
+/// it is a synchronized pool straight on the heap instead.
+class RunArena : public std::pmr::memory_resource {
+  public:
+    explicit RunArena(std::size_t initial_bytes = 64 * 1024) { rebuild(initial_bytes); }
+
+    RunArena(const RunArena&) = delete;
+    RunArena& operator=(const RunArena&) = delete;
+
+    void release() {
+#if defined(CESFAM_PARALLEL)
+        pool_.release();
+#else
+        const std::size_t need = buffer_bytes_ + overflow_.bytes;
+        if (overflow_.bytes == 0) {
+            pool_->release();
+            chunks_->release();
+        } else {
+            rebuild(need);
+        }
+#endif
+    }
+
+    /// Bytes currently reserved from the heap (buffer and overflow blocks).
+    std::size_t reserved() const {
+#if defined(CESFAM_PARALLEL)
+        return 0;
+#else
+        return buffer_bytes_ + overflow_.bytes;
+#endif
+    }
+
+  private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override { return pool().allocate(bytes, align); }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override { pool().deallocate(p, bytes, align); }
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+#if defined(CESFAM_PARALLEL)
+    void rebuild(std::size_t) {}
+    std::pmr::memory_resource& pool() { return pool_; }
+
+    std::pmr::synchronized_pool_resource pool_{std::pmr::pool_options{0, kLargestPooled}};
+#else
+    // Heap blocks the monotonic buffer took beyond its initial buffer.
+    struct Overflow : std::pmr::memory_resource {
+        std::size_t bytes = 0;
+
+        void* do_allocate(std::size_t n, std::size_t a) override {
+            void* p = std::pmr::new_delete_resource()->allocate(n, a);
+            bytes += n;
+            return p;
+        }
+        void do_deallocate(void* p, std::size_t n, std::size_t a) override {
+            bytes -= n;
+            std::pmr::new_delete_resource()->deallocate(p, n, a);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+    };
+
+    void rebuild(std::size_t bytes) {
+        pool_.reset();
+        chunks_.reset();   // frees the overflow blocks
+        buffer_ = std::make_unique<std::byte[]>(bytes);
+        buffer_bytes_ = bytes;
+        chunks_.emplace(buffer_.get(), bytes, &overflow_);
+        pool_.emplace(std::pmr::pool_options{0, kLargestPooled}, &*chunks_);
+    }
+    std::pmr::memory_resource& pool() { return *pool_; }
+
+    Overflow overflow_;
+    std::unique_ptr<std::byte[]> buffer_;
+    std::size_t buffer_bytes_ = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> chunks_;
+    std::optional<std::pmr::unsynchronized_pool_resource> pool_;
+#endif
+
+    static constexpr std::size_t kLargestPooled = 64 * 1024;   // larger blocks bypass the size classes
+};
+
+} // namespace cesfam
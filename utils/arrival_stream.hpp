@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils/csv_arrivals.hpp"
+
+namespace cesfam {
+
+/// Incremental reader for an unbounded arrivals feed (same `time,edad,riesgo`
+/// lines as arrivals.csv) coming from a FIFO, a file being appended to, or
+/// stdin ("-").
+///
+/// Only `lookahead` events are held at a time, in a min-heap that reorders
+/// slightly out-of-order input: the next event is released once the heap is
+/// full or the producer closed the feed. Lines are read only when an event is
+/// released, so a blocking pipe backpressures the producer and memory stays
+/// constant however long the feed runs. An event older than one already
+/// released (out of order by more than the window) is moved to the last
+/// released time and counted in late(). A line that doesn't parse (a bad or
+/// half-written record from the producer) is skipped and counted in
+/// malformed(), so it can't stop the run.
+class ArrivalStream {
+  public:
+    ArrivalStream(const std::string& path, std::size_t lookahead = 64)
+    : lookahead_(lookahead == 0 ? 1 : lookahead)
+    {
+        if (path == "-") {
+            in_ = &std::cin;
+        } else {
+            file_ = std::make_unique<std::ifstream>(path);
+            if (!file_->is_open()) {
+                throw std::runtime_error("Cannot open arrivals stream: " + path);
+            }
+            in_ = file_.get();
+        }
+        std::vector<ArrivalEvent> storage;
+        storage.reserve(lookahead_);
+        heap_ = Heap(Later{}, std::move(storage));
+    }
+
+    /// Next event in time order; false once the feed is closed and drained.
+    bool next(ArrivalEvent& ev) {
+        fill();
+        if (heap_.empty()) return false;
+
+        ev = heap_.top();
+        heap_.pop();
+        if (released_ && ev.time < last_time_) {
+            ev.time = last_time_;
+            ++late_;
+        }
+        released_ = true;
+        last_time_ = ev.time;
+        ++count_;
+        return true;
+    }
+
+    std::size_t count() const { return count_; }
+    std::size_t late() const { return late_; }
+    std::size_t malformed() const { return malformed_; }
+    std::size_t lookahead() const { return lookahead_; }
+
+  private:
+    struct Later {
+        bool operator()(const ArrivalEvent& a, const ArrivalEvent& b) const { return a.time > b.time; }
+    };
+    using Heap = std::priority_queue<ArrivalEvent, std::vector<ArrivalEvent>, Later>;
+
+    void fill() {
+        std::string line;
+        while (!eof_ && heap_.size() < lookahead_) {
+            if (!std::getline(*in_, line)) {
+                eof_ = true;
+                break;
+            }
+            line = trim_copy(line);
+            if (line.empty() || line[0] == '#') continue;
+            if (first_) {
+                first_ = false;
+                if (is_arrivals_header(line)) continue;
+            }
+            ArrivalEvent ev;
+            try {
+                ev = parse_arrival_line(line);
+            } catch (const std::logic_error&) {   // std::stod / std::stoi
+                ++malformed_;
+                continue;
+            }
+            if (!std::isfinite(ev.time)) {
+                ++malformed_;
+                continue;
+            }
+            heap_.push(ev);
+        }
+    }
+
+    std::size_t lookahead_;
+    std::unique_ptr<std::ifstream> file_;
+    std::istream* in_ = nullptr;
+    Heap heap_;
+
+    bool first_ = true;
+    bool eof_ = false;
+    bool released_ = false;
+    double last_time_ = 0.0;
+    std::size_t count_ = 0;
+    std::size_t late_ = 0;
+    std::size_t malformed_ = 0;
+};
+
+} // namespace cesfam
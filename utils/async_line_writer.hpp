@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace cesfam {
+
+/// Writes lines to a file, FIFO or stdout ("-") from a background thread.
+///
+/// push() never waits for the consumer: lines go to a ring of at most
+/// `capacity` entries and, when the reader falls behind and the ring is full,
+/// the oldest pending line is dropped (a dashboard wants the latest state, not
+/// a backlog). The output is opened by the writer thread too, so a FIFO with
+/// no reader yet doesn't stall the caller; if no reader shows up before
+/// close(), the pending lines are discarded.
+class AsyncLineWriter {
+  public:
+    AsyncLineWriter(std::string path, std::size_t capacity = 256)
+    : path_(std::move(path))
+    , capacity_(capacity == 0 ? 1 : capacity)
+    , thread_([this]() { loop(); })
+    {}
+
+    ~AsyncLineWriter() { close(); }
+
+    AsyncLineWriter(const AsyncLineWriter&) = delete;
+    AsyncLineWriter& operator=(const AsyncLineWriter&) = delete;
+
+    void push(std::string line) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.size() == capacity_) {
+                pending_.pop_front();
+                ++dropped_;
+            }
+            pending_.push_back(std::move(line));
+        }
+        cv_.notify_one();
+    }
+
+    /// Lines discarded so far because the consumer was too slow.
+    std::size_t dropped() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+    /// Flushes what is pending (waiting for the consumer) and stops the thread.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closing_) return;
+            closing_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) thread_.join();
+    }
+
+  private:
+    // Opens the output without blocking on a FIFO that has no reader yet
+    // (ENXIO), retrying until one connects or close() is called.
+    int open_output() {
+        if (path_ == "-") return STDOUT_FILENO;
+        while (true) {
+            const int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, 0644);
+            if (fd >= 0) {
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+                return fd;
+            }
+            if (errno != ENXIO) {
+                std::cerr << "[WARN] Cannot open KPI stream output: " << path_ << "\n";
+                return -1;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (cv_.wait_for(lock, std::chrono::milliseconds(50), [this]() { return closing_; })) return -1;
+        }
+    }
+
+    static bool write_all(int fd, const std::string& s) {
+        std::size_t off = 0;
+        while (off < s.size()) {
+            const ssize_t n = ::write(fd, s.data() + off, s.size() - off);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            off += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    void loop() {
+        int fd = open_output();
+
+        std::string chunk;
+        std::deque<std::string> batch;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return closing_ || !pending_.empty(); });
+            if (pending_.empty() && closing_) break;
+            batch.swap(pending_);
+            lock.unlock();
+
+            chunk.clear();
+            for (const auto& line : batch) {
+                chunk += line;
+                chunk += '\n';
+            }
+            if (fd >= 0 && !write_all(fd, chunk)) {
+                // Reader went away (EPIPE): keep consuming so push() stays cheap.
+                if (fd != STDOUT_FILENO) ::close(fd);
+                fd = -1;
+            }
+            batch.clear();
+            lock.lock();
+        }
+        lock.unlock();
+        if (fd >= 0 && fd != STDOUT_FILENO) ::close(fd);
+    }
+
+    std::string path_;
+    std::size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> pending_;
+    std::size_t dropped_ = 0;
+    bool closing_ = false;
+
+    std::thread thread_;
+};
+
+} // namespace cesfam
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace cesfam {
+
+/// Calendar queue (R. Brown, 1988): a priority queue of timestamped items
+/// with O(1) amortized push and pop when the timestamps are spread out, as
+/// with appointments booked days or weeks ahead.
+///
+/// Items are hashed by day = floor(time / width) into a ring of buckets, one
+/// "year" being buckets * width. Each bucket is a small vector kept sorted in
+/// descending (time, seq) order, so its minimum is at the back. Popping scans
+/// forward from the current day and only falls back to a direct search over
+/// every bucket when a whole year is empty. The ring doubles or halves when the
+/// size leaves [buckets / 2, 2 * buckets] and the width is re-estimated as
+/// three mean separations of the earliest pending times (as in Brown), so the
+/// days being popped hold a handful of items each.
+///
+/// Equal times come out in insertion order. A push earlier than the last
+/// popped time moves the scan back to its day, so items can be put back.
+/// The queue is a regular value, so a model state that holds one can be copied.
+template <typename T>
+class CalendarQueue {
+  public:
+    struct Entry {
+        double time;
+        std::uint64_t seq;
+        T value;
+    };
+
+    explicit CalendarQueue(double width = 1.0)
+    : width_(width > 0.0 ? width : 1.0)
+    {}
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::size_t buckets() const { return buckets_.size(); }
+    double width() const { return width_; }
+
+    void push(double time, T value) {
+        if (buckets_.empty()) buckets_.resize(kMinBuckets);
+        if (time < last_) {
+            last_ = time;
+            day_ = std::min(day_, day_of(time));
+        }
+        insert(Entry{time, seq_++, std::move(value)});
+        ++size_;
+        if (size_ > 2 * buckets_.size()) resize(buckets_.size() * 2);
+    }
+
+    /// Earliest entry. Requires !empty().
+    const Entry& top() const {
+        const std::size_t b = find_min(nullptr);
+        return buckets_[b].back();
+    }
+
+    double top_time() const {
+        return empty() ? std::numeric_limits<double>::infinity() : top().time;
+    }
+
+    /// Removes and returns the earliest entry. Requires !empty().
+    Entry pop() {
+        std::uint64_t day = 0;
+        const std::size_t b = find_min(&day);
+        Entry e = std::move(buckets_[b].back());
+        buckets_[b].pop_back();
+        --size_;
+        day_ = day;
+        last_ = e.time;
+        if (buckets_.size() > kMinBuckets && 2 * size_ < buckets_.size()) resize(buckets_.size() / 2);
+        return e;
+    }
+
+    /// Every entry, in no particular order.
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const auto& b : buckets_) {
+            for (const auto& e : b) f(e);
+        }
+    }
+
+  private:
+    static constexpr std::size_t kMinBuckets = 16;
+    static constexpr std::size_t kSample = 256;   // entries used to estimate the width
+
+    static bool later(const Entry& a, const Entry& b) {
+        return a.time > b.time || (a.time == b.time && a.seq > b.seq);
+    }
+
+    std::uint64_t day_of(double time) const {
+        const double d = std::floor(time / width_);
+        return d > 0.0 ? static_cast<std::uint64_t>(d) : 0;
+    }
+
+    void insert(Entry e) {
+        auto& b = buckets_[day_of(e.time) & (buckets_.size() - 1)];
+        auto it = std::upper_bound(b.begin(), b.end(), e, later);
+        b.insert(it, std::move(e));
+    }
+
+    // Bucket holding the minimum; scans one year from the current day, then
+    // searches the bucket minimums directly. Writes the minimum's day to `day`.
+    std::size_t find_min(std::uint64_t* day) const {
+        const std::size_t mask = buckets_.size() - 1;
+        std::uint64_t d = day_;
+        for (std::size_t i = 0; i < buckets_.size(); ++i, ++d) {
+            const auto& b = buckets_[d & mask];
+            if (!b.empty() && day_of(b.back().time) == d) {
+                if (day) *day = d;
+                return d & mask;
+            }
+        }
+        std::size_t best = 0;
+        const Entry* min = nullptr;
+        for (std::size_t i = 0; i < buckets_.size(); ++i) {
+            const auto& b = buckets_[i];
+            if (!b.empty() && (!min || later(*min, b.back()))) {
+                min = &b.back();
+                best = i;
+            }
+        }
+        if (day) *day = day_of(min->time);
+        return best;
+    }
+
+    void resize(std::size_t n) {
+        std::vector<Entry> all;
+        all.reserve(size_);
+        for (auto& b : buckets_) {
+            for (auto& e : b) all.push_back(std::move(e));
+        }
+        std::sort(all.begin(), all.end(), later);
+
+        // three times the mean separation of the earliest entries, where pops
+        // happen (a far tail would otherwise inflate the days)
+        const std::size_t k = std::min<std::size_t>(all.size() > 0 ? all.size() - 1 : 0, kSample);
+        if (k > 0) {
+            const double sep = (all[all.size() - 1 - k].time - all.back().time) / static_cast<double>(k);
+            if (sep > 0.0) width_ = 3.0 * sep;
+        }
+
+        buckets_.assign(n, {});
+        for (auto& e : all) buckets_[day_of(e.time) & (n - 1)].push_back(std::move(e));
+        day_ = day_of(last_);
+    }
+
+    double width_;
+    std::vector<std::vector<Entry>> buckets_;   // power-of-two ring (allocated on first push)
+    std::uint64_t day_ = 0;                     // scan start: no entry is on an earlier day
+    double last_ = 0.0;                         // no entry is earlier than this
+    std::size_t size_ = 0;
+    std::uint64_t seq_ = 0;
+};
+
+} // namespace cesfam
@@ -26,6 +26,25 @@ inline RiskLevel parse_risk(std::string s) {
     return RiskLevel::Unknown;
 }
 
+inline bool is_arrivals_header(const std::string& line) {
+    return line.find("time") != std::string::npos || line.find("hora") != std::string::npos;
+}
+
+/// Parses one `time,edad,riesgo` line (already trimmed, not a comment/header).
+inline ArrivalEvent parse_arrival_line(const std::string& line) {
+    std::stringstream ss(line);
+    std::string t, edad, riesgo;
+    std::getline(ss, t, ',');
+    std::getline(ss, edad, ',');
+    std::getline(ss, riesgo, ',');
+
+    ArrivalEvent ev;
+    ev.time = std::stod(trim_copy(t));
+    ev.edad = edad.empty() ? 0 : std::stoi(trim_copy(edad));
+    ev.riesgo = riesgo.empty() ? RiskLevel::Unknown : parse_risk(riesgo);
+    return ev;
+}
+
 inline std::vector<ArrivalEvent> read_arrivals_csv(const std::string& path) {
     std::ifstream in(path);
     if (!in.is_open()) {
@@ -43,23 +62,10 @@ inline std::vector<ArrivalEvent> read_arrivals_csv(const std::string& path) {
         // Skip header if present
         if (first) {
             first = false;
-            if (line.find("time") != std::string::npos || line.find("hora") != std::string::npos) {
-                continue;
-            }
+            if (is_arrivals_header(line)) continue;
         }
 
-        std::stringstream ss(line);
-        std::string t, edad, riesgo;
-        std::getline(ss, t, ',');
-        std::getline(ss, edad, ',');
-        std::getline(ss, riesgo, ',');
-
-        ArrivalEvent ev;
-        ev.time = std::stod(trim_copy(t));
-        ev.edad = edad.empty() ? 0 : std::stoi(trim_copy(edad));
-        ev.riesgo = riesgo.empty() ? RiskLevel::Unknown : parse_risk(riesgo);
-
-        out.push_back(ev);
+        out.push_back(parse_arrival_line(line));
     }
 
     std::sort(out.begin(), out.end(), [](const ArrivalEvent& a, const ArrivalEvent& b){ return a.time < b.time; });
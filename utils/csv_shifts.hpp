@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/ini_reader.hpp"
+
+namespace cesfam {
+
+/// From `time` on, doctors 0 .. doctors-1 are on duty.
+struct ShiftEntry {
+    double time = 0.0;
+    int doctors = 0;
+};
+
+/// Staffing over the day (or week): the number of doctors on duty as a step
+/// function of time. With period > 0 the entries repeat every `period`
+/// seconds (e.g. 86400 for the same calendar every day) and must lie in
+/// [0, period).
+///
+/// Before the first entry, the staff is that of the last entry when the
+/// calendar repeats (the previous cycle), and that of the first entry
+/// otherwise.
+struct ShiftCalendar {
+    std::vector<ShiftEntry> entries;   // sorted by time, one per time
+    double period = 0.0;
+
+    /// Doctors on duty at time t.
+    int at(double t) const {
+        if (entries.empty()) return 0;
+        if (period > 0.0) t -= std::floor(t / period) * period;
+        auto it = std::upper_bound(entries.begin(), entries.end(), t,
+                                   [](double v, const ShiftEntry& e) { return v < e.time; });
+        if (it == entries.begin()) return period > 0.0 ? entries.back().doctors : entries.front().doctors;
+        return std::prev(it)->doctors;
+    }
+
+    /// First change strictly after t: its time and the doctors on duty from
+    /// then on ({infinity, 0} when nothing changes any more).
+    std::pair<double, int> next_change(double t) const {
+        if (entries.empty()) return {std::numeric_limits<double>::infinity(), 0};
+        const double cycle = period > 0.0 ? std::floor(t / period) * period : 0.0;
+        auto it = std::upper_bound(entries.begin(), entries.end(), t - cycle,
+                                   [](double v, const ShiftEntry& e) { return v < e.time; });
+        if (it != entries.end()) return {cycle + it->time, it->doctors};
+        if (period > 0.0) return {cycle + period + entries.front().time, entries.front().doctors};
+        return {std::numeric_limits<double>::infinity(), 0};
+    }
+
+    /// Long-run staff on duty: the time average over one period when the
+    /// calendar repeats, otherwise the staff of the last entry.
+    double mean_doctors() const {
+        if (entries.empty()) return 0.0;
+        if (period <= 0.0) return entries.back().doctors;
+        double sum = entries.front().time * entries.back().doctors;   // tail of the previous cycle
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const double end = i + 1 < entries.size() ? entries[i + 1].time : period;
+            sum += (end - entries[i].time) * entries[i].doctors;
+        }
+        return sum / period;
+    }
+
+    /// Largest number of doctors ever on duty: the staff to build.
+    int max_doctors() const {
+        int n = 0;
+        for (const auto& e : entries) n = std::max(n, e.doctors);
+        return n;
+    }
+};
+
+/// Reads `time,doctors` lines (seconds; optional header, `#` comments). A
+/// later line with the same time replaces an earlier one. Throws
+/// std::runtime_error on unreadable files, bad lines, negative values or, with
+/// a period, times outside [0, period).
+inline ShiftCalendar read_shifts_csv(const std::string& path, double period = 0.0) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("Cannot open shifts CSV: " + path);
+    }
+    ShiftCalendar cal;
+    cal.period = period > 0.0 ? period : 0.0;
+    std::string line;
+    bool first = true;
+
+    while (std::getline(in, line)) {
+        line = trim_copy(line);
+        if (line.empty()) continue;
+        if (line[0] == '#') continue;
+
+        // Skip header if present
+        if (first) {
+            first = false;
+            if (line.find("time") != std::string::npos || line.find("hora") != std::string::npos) continue;
+        }
+
+        std::stringstream ss(line);
+        std::string t, n;
+        std::getline(ss, t, ',');
+        std::getline(ss, n, ',');
+        ShiftEntry e;
+        try {
+            e.time = std::stod(trim_copy(t));
+            e.doctors = std::stoi(trim_copy(n));
+        } catch (const std::exception&) {
+            throw std::runtime_error("Bad shifts line in " + path + ": " + line);
+        }
+        if (e.time < 0.0 || e.doctors < 0 || (cal.period > 0.0 && e.time >= cal.period)) {
+            throw std::runtime_error("Shifts line out of range in " + path + ": " + line);
+        }
+        cal.entries.push_back(e);
+    }
+
+    std::stable_sort(cal.entries.begin(), cal.entries.end(),
+                     [](const ShiftEntry& a, const ShiftEntry& b) { return a.time < b.time; });
+    // keep the last line of each time
+    std::vector<ShiftEntry> unique;
+    for (const auto& e : cal.entries) {
+        if (!unique.empty() && unique.back().time == e.time) {
+            unique.back() = e;
+        } else {
+            unique.push_back(e);
+        }
+    }
+    cal.entries = std::move(unique);
+    if (cal.entries.empty()) throw std::runtime_error("Empty shifts CSV: " + path);
+    return cal;
+}
+
+} // namespace cesfam
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "utils/stats.hpp"
+
+namespace cesfam {
+
+struct DivergenceConfig {
+    double interval = 0.0;   // simulated seconds between samples, 0 = no check
+    int window = 20;         // samples per trend test
+    int confirm = 3;         // consecutive rising windows (half a window apart) that stop the run
+    double alpha = 0.001;    // one-sided level of each trend test
+
+    bool active() const { return interval > 0.0; }
+};
+
+/// Online test for runs whose queues grow without bound (offered load above
+/// capacity). It is fed, at a fixed simulated interval, the patients waiting
+/// at the doctors and the patients in the system, and keeps the last `window`
+/// samples of each. Every half window it runs a Mann-Kendall trend test on
+/// both; the run is declared divergent once both series rose significantly in
+/// `confirm` consecutive tests.
+///
+/// A stable run has no trend once warmed up, so a false alarm needs a
+/// transient longer than (window + (confirm - 1) * window / 2) samples; the
+/// defaults ask for 40 rising samples. The test assumes roughly independent
+/// samples: the interval should span a few service times, or the slow
+/// excursions of a stable queue read as trends.
+class DivergenceMonitor {
+  public:
+    explicit DivergenceMonitor(DivergenceConfig cfg)
+    : cfg_(cfg)
+    , z_(normal_quantile(1.0 - cfg.alpha))
+    {
+        cfg_.window = std::max(cfg_.window, 4);
+        cfg_.confirm = std::max(cfg_.confirm, 1);
+        hop_ = static_cast<std::size_t>(cfg_.window / 2);
+        since_test_ = hop_ - 1;   // first test as soon as the window is full
+        queued_.reserve(static_cast<std::size_t>(cfg_.window));
+        in_system_.reserve(static_cast<std::size_t>(cfg_.window));
+    }
+
+    /// Adds one sample; true once the run is divergent (and from then on).
+    bool add(double queued, double in_system) {
+        if (diverged_) return true;
+        push(queued_, queued);
+        push(in_system_, in_system);
+        if (queued_.size() < static_cast<std::size_t>(cfg_.window) || ++since_test_ < hop_) return false;
+
+        since_test_ = 0;
+        const bool rising = mann_kendall_z(queued_) > z_ && mann_kendall_z(in_system_) > z_;
+        rising_ = rising ? rising_ + 1 : 0;
+        diverged_ = rising_ >= cfg_.confirm;
+        return diverged_;
+    }
+
+    bool diverged() const { return diverged_; }
+    const DivergenceConfig& config() const { return cfg_; }
+
+  private:
+    // Sliding window in time order (a few dozen values: shifting is cheaper
+    // than a ring the test would have to unroll).
+    void push(std::vector<double>& w, double v) const {
+        if (w.size() == static_cast<std::size_t>(cfg_.window)) w.erase(w.begin());
+        w.push_back(v);
+    }
+
+    DivergenceConfig cfg_;
+    double z_;
+    std::size_t hop_ = 1;
+    std::size_t since_test_ = 0;
+    int rising_ = 0;
+    bool diverged_ = false;
+    std::vector<double> queued_;
+    std::vector<double> in_system_;
+};
+
+} // namespace cesfam
@@ -0,0 +1,394 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "data_structures/patient.hpp"
+
+namespace cesfam {
+
+// ---------------------------------------------------------------------------
+// Journey table: one row per doctor visit, stored column by column.
+//
+//   "CESFAMJT" | u32 version | u32 columns
+//   block*     : u32 rows | u32 bytes[columns] | column data...
+//   u64 block_offset[n_blocks] | u64 n_blocks | u64 rows | "CESFAMJT"
+//
+// Every block is self-contained (delta/XOR state restarts at 0), so blocks
+// can be decoded independently and in parallel. Integer columns are
+// delta + zigzag + LEB128 varints, enum columns one byte per row, and time
+// columns XOR each double with the previous one and store only the non-zero
+// bytes. Multi-byte values are little-endian (the host order on every
+// platform we run on).
+// ---------------------------------------------------------------------------
+
+enum class JourneyColumn : std::uint8_t {
+    Id=0, Edad, Riesgo, Llegada, Atencion, Salida, Espera, TiempoAtencion, Medico, Resultado, Followups
+};
+
+inline constexpr std::size_t kJourneyColumns = 11;
+inline constexpr char kJourneyMagic[8] = {'C','E','S','F','A','M','J','T'};
+inline constexpr std::uint32_t kJourneyVersion = 1;
+
+struct JourneyRow {
+    std::int64_t id = 0;
+    std::int64_t edad = 0;
+    RiskLevel riesgo = RiskLevel::Unknown;
+    double hora_llegada = 0.0;
+    double hora_atencion = 0.0;
+    double hora_salida = 0.0;
+    double espera = 0.0;
+    double atencion = 0.0;
+    std::int64_t medico = -1;
+    AttentionResult resultado = AttentionResult::Unknown;
+    std::int64_t followups = 0;
+};
+
+inline JourneyRow journey_row(const Patient& p) {
+    JourneyRow r;
+    r.id = p.id_paciente;
+    r.edad = p.edad;
+    r.riesgo = p.nivel_riesgo;
+    r.hora_llegada = p.hora_llegada;
+    r.hora_atencion = p.hora_atencion;
+    r.hora_salida = p.hora_salida;
+    r.espera = p.tiempo_espera();
+    r.atencion = p.tiempo_atencion();
+    r.medico = p.medico_asignado;
+    r.resultado = p.resultado;
+    r.followups = p.followups_done;
+    return r;
+}
+
+// ---- codecs ----------------------------------------------------------------
+
+inline void put_varint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+// Decoders never read at or past `end` (the end of the column): a truncated
+// or corrupt column throws std::runtime_error.
+[[noreturn]] inline void corrupt_column() {
+    throw std::runtime_error("Corrupt journey table column");
+}
+
+inline std::uint64_t get_varint(const std::uint8_t*& p, const std::uint8_t* end) {
+    std::uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) corrupt_column();
+        const std::uint8_t b = *p++;
+        v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    corrupt_column();   // more than 10 bytes
+}
+
+inline std::uint64_t zigzag(std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t v) {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+inline void encode_deltas(const std::vector<std::int64_t>& in, std::vector<std::uint8_t>& out) {
+    std::int64_t prev = 0;
+    for (std::int64_t v : in) {
+        put_varint(out, zigzag(v - prev));
+        prev = v;
+    }
+}
+
+inline void decode_deltas(const std::uint8_t* p, std::size_t bytes, std::size_t rows, std::vector<std::int64_t>& out) {
+    const std::uint8_t* end = p + bytes;
+    out.resize(rows);
+    std::uint64_t prev = 0;   // unsigned: corrupt deltas wrap instead of overflowing
+    for (std::size_t i = 0; i < rows; ++i) {
+        prev += static_cast<std::uint64_t>(unzigzag(get_varint(p, end)));
+        out[i] = static_cast<std::int64_t>(prev);
+    }
+}
+
+// XOR with the previous value; a header byte holds the number of leading and
+// trailing zero bytes of the XOR (0xFF = identical value), then the rest.
+inline void encode_xor(const std::vector<double>& in, std::vector<std::uint8_t>& out) {
+    std::uint64_t prev = 0;
+    for (double d : in) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof bits);
+        const std::uint64_t x = bits ^ prev;
+        prev = bits;
+        if (x == 0) {
+            out.push_back(0xFF);
+            continue;
+        }
+        const int lead = __builtin_clzll(x) / 8;
+        const int trail = __builtin_ctzll(x) / 8;
+        out.push_back(static_cast<std::uint8_t>((lead << 4) | trail));
+        for (int b = 7 - lead; b >= trail; --b) out.push_back(static_cast<std::uint8_t>(x >> (8 * b)));
+    }
+}
+
+inline void decode_xor(const std::uint8_t* p, std::size_t bytes, std::size_t rows, std::vector<double>& out) {
+    const std::uint8_t* end = p + bytes;
+    out.resize(rows);
+    std::uint64_t prev = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        if (p == end) corrupt_column();
+        const std::uint8_t h = *p++;
+        if (h != 0xFF) {
+            const int lead = h >> 4;
+            const int trail = h & 0x0F;
+            if (lead > 7 || trail > 7 - lead || end - p < 8 - lead - trail) corrupt_column();
+            std::uint64_t x = 0;
+            for (int b = 7 - lead; b >= trail; --b) x |= static_cast<std::uint64_t>(*p++) << (8 * b);
+            prev ^= x;
+        }
+        std::memcpy(&out[i], &prev, sizeof prev);
+    }
+}
+
+// ---- writer ------------------------------------------------------------------
+
+/// Appends rows and writes them as compressed column blocks of `block_rows`.
+/// close() (or the destructor) flushes the last block and writes the footer;
+/// close() throws std::runtime_error if any write failed.
+class JourneyWriter {
+  public:
+    explicit JourneyWriter(const std::string& path, std::size_t block_rows = 65536)
+    : out_(path, std::ios::binary | std::ios::trunc)
+    , path_(path)
+    , block_rows_(block_rows == 0 ? 1 : block_rows)
+    {
+        if (!out_.is_open()) throw std::runtime_error("Cannot open journey table: " + path);
+        out_.write(kJourneyMagic, sizeof kJourneyMagic);
+        write_pod(kJourneyVersion);
+        write_pod(static_cast<std::uint32_t>(kJourneyColumns));
+    }
+
+    ~JourneyWriter() {
+        try { close(); } catch (...) {}
+    }
+
+    JourneyWriter(const JourneyWriter&) = delete;
+    JourneyWriter& operator=(const JourneyWriter&) = delete;
+
+    void append(const JourneyRow& r) {
+        ints_[0].push_back(r.id);
+        ints_[1].push_back(r.edad);
+        ints_[2].push_back(r.medico);
+        ints_[3].push_back(r.followups);
+        riesgo_.push_back(static_cast<std::uint8_t>(r.riesgo));
+        resultado_.push_back(static_cast<std::uint8_t>(r.resultado));
+        times_[0].push_back(r.hora_llegada);
+        times_[1].push_back(r.hora_atencion);
+        times_[2].push_back(r.hora_salida);
+        times_[3].push_back(r.espera);
+        times_[4].push_back(r.atencion);
+        ++rows_;
+        if (riesgo_.size() >= block_rows_) flush_block();
+    }
+
+    void append(const Patient& p) { append(journey_row(p)); }
+
+    std::uint64_t rows() const { return rows_; }
+
+    void close() {
+        if (closed_) return;
+        flush_block();
+        for (std::uint64_t off : offsets_) write_pod(off);
+        write_pod(static_cast<std::uint64_t>(offsets_.size()));
+        write_pod(rows_);
+        out_.write(kJourneyMagic, sizeof kJourneyMagic);
+        out_.close();   // flushes: a failing final write (disk full) shows up here
+        closed_ = true;
+        if (!out_) throw std::runtime_error("Error writing journey table (truncated): " + path_);
+    }
+
+  private:
+    template <typename T>
+    void write_pod(const T& v) { out_.write(reinterpret_cast<const char*>(&v), sizeof v); }
+
+    void flush_block() {
+        const std::size_t n = riesgo_.size();
+        if (n == 0) return;
+
+        std::array<std::vector<std::uint8_t>, kJourneyColumns> cols;
+        auto col = [&](JourneyColumn c) -> std::vector<std::uint8_t>& { return cols[static_cast<std::size_t>(c)]; };
+        encode_deltas(ints_[0], col(JourneyColumn::Id));
+        encode_deltas(ints_[1], col(JourneyColumn::Edad));
+        col(JourneyColumn::Riesgo) = riesgo_;
+        encode_xor(times_[0], col(JourneyColumn::Llegada));
+        encode_xor(times_[1], col(JourneyColumn::Atencion));
+        encode_xor(times_[2], col(JourneyColumn::Salida));
+        encode_xor(times_[3], col(JourneyColumn::Espera));
+        encode_xor(times_[4], col(JourneyColumn::TiempoAtencion));
+        encode_deltas(ints_[2], col(JourneyColumn::Medico));
+        col(JourneyColumn::Resultado) = resultado_;
+        encode_deltas(ints_[3], col(JourneyColumn::Followups));
+
+        offsets_.push_back(static_cast<std::uint64_t>(out_.tellp()));
+        write_pod(static_cast<std::uint32_t>(n));
+        for (const auto& c : cols) write_pod(static_cast<std::uint32_t>(c.size()));
+        for (const auto& c : cols) out_.write(reinterpret_cast<const char*>(c.data()), static_cast<std::streamsize>(c.size()));
+
+        for (auto& v : ints_) v.clear();
+        for (auto& v : times_) v.clear();
+        riesgo_.clear();
+        resultado_.clear();
+    }
+
+    std::ofstream out_;
+    std::string path_;
+    std::size_t block_rows_;
+
+    std::array<std::vector<std::int64_t>, 4> ints_;   // id, edad, medico, followups
+    std::array<std::vector<double>, 5> times_;        // llegada, atencion, salida, espera, atencion_s
+    std::vector<std::uint8_t> riesgo_;
+    std::vector<std::uint8_t> resultado_;
+
+    std::vector<std::uint64_t> offsets_;
+    std::uint64_t rows_ = 0;
+    bool closed_ = false;
+};
+
+// ---- reader ------------------------------------------------------------------
+
+/// Read-only, memory-mapped journey table. Columns are decoded on demand, one
+/// block at a time, so a query only touches the columns it uses.
+class JourneyFile {
+  public:
+    struct Block {
+        std::size_t rows = 0;
+        std::array<const std::uint8_t*, kJourneyColumns> data{};
+        std::array<std::uint32_t, kJourneyColumns> bytes{};
+
+        const std::uint8_t* column(JourneyColumn c) const { return data[static_cast<std::size_t>(c)]; }
+    };
+
+    explicit JourneyFile(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) throw std::runtime_error("Cannot open journey table: " + path);
+        struct stat st {};
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Cannot stat journey table: " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+
+        const std::size_t header = sizeof kJourneyMagic + 2 * sizeof(std::uint32_t);
+        const std::size_t trailer = 2 * sizeof(std::uint64_t) + sizeof kJourneyMagic;
+        if (size_ < header + trailer) fail(path, "file too small");
+
+        void* m = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (m == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("Cannot mmap journey table: " + path);
+        }
+        base_ = static_cast<const std::uint8_t*>(m);
+        ::madvise(m, size_, MADV_SEQUENTIAL);
+
+        if (std::memcmp(base_, kJourneyMagic, sizeof kJourneyMagic) != 0 ||
+            std::memcmp(base_ + size_ - sizeof kJourneyMagic, kJourneyMagic, sizeof kJourneyMagic) != 0) {
+            fail(path, "bad magic");
+        }
+        if (read_pod<std::uint32_t>(sizeof kJourneyMagic) != kJourneyVersion ||
+            read_pod<std::uint32_t>(sizeof kJourneyMagic + 4) != kJourneyColumns) {
+            fail(path, "unsupported version");
+        }
+
+        const std::size_t tail = size_ - trailer;
+        const std::uint64_t n_blocks = read_pod<std::uint64_t>(tail);
+        rows_ = read_pod<std::uint64_t>(tail + 8);
+        if (n_blocks > (tail - header) / 8) fail(path, "corrupt footer");
+
+        // Every offset and length is checked against the block index before
+        // it is used; the column decoders are bounded by the column length.
+        const std::size_t index = tail - static_cast<std::size_t>(n_blocks) * 8;
+        const std::size_t block_header = 4 + 4 * kJourneyColumns;
+        std::uint64_t total = 0;
+        blocks_.reserve(static_cast<std::size_t>(n_blocks));
+        for (std::uint64_t b = 0; b < n_blocks; ++b) {
+            const std::uint64_t start = read_pod<std::uint64_t>(index + b * 8);
+            if (start < header || start > index || index - start < block_header) fail(path, "corrupt block offset");
+            std::size_t off = static_cast<std::size_t>(start);
+            Block blk;
+            blk.rows = read_pod<std::uint32_t>(off);
+            off += 4;
+            for (std::size_t c = 0; c < kJourneyColumns; ++c, off += 4) blk.bytes[c] = read_pod<std::uint32_t>(off);
+            for (std::size_t c = 0; c < kJourneyColumns; ++c) {
+                if (blk.bytes[c] > index - off) fail(path, "corrupt block");
+                blk.data[c] = base_ + off;
+                off += blk.bytes[c];
+            }
+            // one byte per row
+            if (blk.bytes[static_cast<std::size_t>(JourneyColumn::Riesgo)] != blk.rows ||
+                blk.bytes[static_cast<std::size_t>(JourneyColumn::Resultado)] != blk.rows) {
+                fail(path, "corrupt block");
+            }
+            total += blk.rows;
+            blocks_.push_back(blk);
+        }
+        if (total != rows_) fail(path, "row count mismatch");
+    }
+
+    ~JourneyFile() {
+        if (base_) ::munmap(const_cast<std::uint8_t*>(base_), size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    JourneyFile(const JourneyFile&) = delete;
+    JourneyFile& operator=(const JourneyFile&) = delete;
+
+    std::uint64_t rows() const { return rows_; }
+    std::size_t bytes() const { return size_; }
+    const std::vector<Block>& blocks() const { return blocks_; }
+
+    /// Decoders: throw std::runtime_error on a corrupt column.
+    static void ints(const Block& b, JourneyColumn c, std::vector<std::int64_t>& out) {
+        decode_deltas(b.column(c), b.bytes[static_cast<std::size_t>(c)], b.rows, out);
+    }
+    static void doubles(const Block& b, JourneyColumn c, std::vector<double>& out) {
+        decode_xor(b.column(c), b.bytes[static_cast<std::size_t>(c)], b.rows, out);
+    }
+    static const std::uint8_t* bytes(const Block& b, JourneyColumn c) { return b.column(c); }
+
+  private:
+    template <typename T>
+    T read_pod(std::size_t off) const {
+        T v;
+        std::memcpy(&v, base_ + off, sizeof v);
+        return v;
+    }
+
+    [[noreturn]] void fail(const std::string& path, const char* why) {
+        if (base_) ::munmap(const_cast<std::uint8_t*>(base_), size_);
+        ::close(fd_);
+        base_ = nullptr;
+        fd_ = -1;
+        throw std::runtime_error("Invalid journey table " + path + ": " + why);
+    }
+
+    int fd_ = -1;
+    std::size_t size_ = 0;
+    const std::uint8_t* base_ = nullptr;
+    std::uint64_t rows_ = 0;
+    std::vector<Block> blocks_;
+};
+
+} // namespace cesfam
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "data_structures/patient.hpp"
+#include "atomics/recorder.hpp"
+
+namespace cesfam {
+
+/// Linear-interpolated quantile (q in [0,1]) of an unsorted sample.
+inline double quantile(std::vector<double> v, double q) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const double pos = std::clamp(q, 0.0, 1.0) * static_cast<double>(v.size() - 1);
+    const std::size_t lo = static_cast<std::size_t>(std::floor(pos));
+    const std::size_t hi = std::min(lo + 1, v.size() - 1);
+    return v[lo] + (pos - static_cast<double>(lo)) * (v[hi] - v[lo]);
+}
+
+struct WaitStats {
+    std::size_t n = 0;
+    double mean = 0.0;
+    double p90 = 0.0;
+    double max = 0.0;
+};
+
+inline WaitStats wait_stats(const std::vector<double>& waits) {
+    WaitStats w;
+    w.n = waits.size();
+    if (waits.empty()) return w;
+    double sum = 0.0;
+    for (double x : waits) {
+        sum += x;
+        w.max = std::max(w.max, x);
+    }
+    w.mean = sum / static_cast<double>(waits.size());
+    w.p90 = quantile(waits, 0.90);
+    return w;
+}
+
+/// Run-level indicators computed from the exit record (waits are the
+/// tiempo_espera of the last attention of each RA patient).
+struct KpiSummary {
+    std::size_t ra = 0;
+    std::size_t rc = 0;
+    std::size_t altas = 0;
+    std::size_t derivados = 0;
+    std::size_t abandonos = 0;    // reneged in a doctor queue
+    bool diverged = false;        // stopped early, queues growing without bound (exits up to stopped_at)
+    double stopped_at = 0.0;
+    WaitStats wait;
+    std::array<WaitStats, 4> wait_by_risk{};   // indexed by RiskLevel
+};
+
+inline const WaitStats& wait_for(const KpiSummary& k, RiskLevel r) {
+    return k.wait_by_risk[static_cast<std::size_t>(r)];
+}
+
+/// Summarizes one or more exit logs (e.g. the shared pre-fork history plus
+/// the exits of one branch).
+inline KpiSummary summarize(const std::vector<const ExitLog*>& logs) {
+    KpiSummary k;
+    std::vector<double> all;
+    std::array<std::vector<double>, 4> by_risk;
+
+    for (const ExitLog* log : logs) {
+        if (!log) continue;
+        k.rc += log->rc.size();
+        k.ra += log->ra.size();
+        k.abandonos += log->ab.size();
+        for (const auto& p : log->ra) {
+            if (p.resultado == AttentionResult::Derivacion) ++k.derivados;
+            else ++k.altas;
+            all.push_back(p.tiempo_espera());
+            by_risk[static_cast<std::size_t>(p.nivel_riesgo)].push_back(p.tiempo_espera());
+        }
+    }
+
+    k.wait = wait_stats(all);
+    for (std::size_t r = 0; r < by_risk.size(); ++r) k.wait_by_risk[r] = wait_stats(by_risk[r]);
+    return k;
+}
+
+inline KpiSummary summarize(const ExitLog& log) {
+    return summarize(std::vector<const ExitLog*>{&log});
+}
+
+} // namespace cesfam
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace cesfam {
+
+/// Prediction of the mean response at one point: the kriging mean and its
+/// standard deviation (uncertainty about the mean, without the sampling noise
+/// of a new replication).
+struct KrigingPrediction {
+    double mean = 0.0;
+    double sd = 0.0;
+};
+
+/// Stochastic kriging: a Gaussian process metamodel of a simulated mean
+/// response over the unit cube, fitted to the replication means of a set of
+/// design points, each with the variance of its mean (s^2 / reps) as known
+/// noise. Constant trend (estimated by GLS) plus a Matérn 5/2 kernel with one
+/// length scale per input; the length scales and the process variance
+/// maximise the likelihood (compass search in log space).
+///
+/// fit() is O(n^3) per likelihood evaluation, which is fine for the few
+/// hundred points of a sweep; predict() is O(n d) for the mean and O(n^2) for
+/// the standard deviation.
+class StochasticKriging {
+  public:
+    /// x: n points of dimension d, scaled to [0, 1]; y: their mean responses;
+    /// noise: the variance of each mean. Throws std::invalid_argument on
+    /// inconsistent sizes or fewer than two points.
+    void fit(std::vector<std::vector<double>> x, std::vector<double> y, std::vector<double> noise) {
+        if (x.size() < 2 || y.size() != x.size() || noise.size() != x.size()) {
+            throw std::invalid_argument("StochasticKriging::fit: needs at least two points with y and noise each");
+        }
+        d_ = x.front().size();
+        for (const auto& p : x) {
+            if (p.size() != d_) throw std::invalid_argument("StochasticKriging::fit: points of different dimension");
+        }
+        x_ = std::move(x);
+
+        // Standardised responses: the hyperparameter bounds are then scale-free.
+        double m = 0.0;
+        for (double v : y) m += v;
+        m /= static_cast<double>(y.size());
+        double ss = 0.0;
+        for (double v : y) ss += (v - m) * (v - m);
+        y_shift_ = m;
+        y_scale_ = ss > 0.0 ? std::sqrt(ss / static_cast<double>(y.size() - 1)) : 1.0;
+        y_.resize(y.size());
+        noise_.resize(noise.size());
+        for (std::size_t i = 0; i < y.size(); ++i) {
+            y_[i] = (y[i] - y_shift_) / y_scale_;
+            noise_[i] = std::max(0.0, noise[i]) / (y_scale_ * y_scale_);
+        }
+
+        // theta = (log length scales..., log process variance)
+        std::vector<double> theta(d_ + 1, std::log(0.5));
+        theta[d_] = 0.0;
+        std::vector<double> lo(d_ + 1, std::log(0.02)), hi(d_ + 1, std::log(20.0));
+        lo[d_] = std::log(1e-3);
+        hi[d_] = std::log(1e3);
+
+        set_theta(theta);
+        double best = log_likelihood();
+        for (double step = 1.0; step > 0.02; step /= 2.0) {
+            bool improved = true;
+            while (improved) {
+                improved = false;
+                for (std::size_t k = 0; k <= d_; ++k) {
+                    for (double dir : {-1.0, 1.0}) {
+                        std::vector<double> t = theta;
+                        t[k] = std::clamp(t[k] + dir * step, lo[k], hi[k]);
+                        if (t[k] == theta[k]) continue;
+                        set_theta(t);
+                        const double ll = log_likelihood();
+                        if (ll > best + 1e-9) {
+                            best = ll;
+                            theta = t;
+                            improved = true;
+                        }
+                    }
+                }
+            }
+        }
+        set_theta(theta);
+        if (!factor()) throw std::runtime_error("StochasticKriging::fit: covariance matrix is not positive definite");
+        log_likelihood_ = best;
+    }
+
+    /// Adds one point with the current hyperparameters (no refit), e.g. a
+    /// pending design point with its predicted mean: the standard deviations
+    /// only depend on where the points are.
+    void add(std::vector<double> x, double y, double noise) {
+        if (x.size() != d_) throw std::invalid_argument("StochasticKriging::add: wrong dimension");
+        x_.push_back(std::move(x));
+        y_.push_back((y - y_shift_) / y_scale_);
+        noise_.push_back(std::max(0.0, noise) / (y_scale_ * y_scale_));
+        if (!factor()) throw std::runtime_error("StochasticKriging::add: covariance matrix is not positive definite");
+    }
+
+    KrigingPrediction predict(const std::vector<double>& x) const {
+        const std::size_t n = x_.size();
+        std::vector<double> v(n);
+        double mean = beta_;
+        for (std::size_t i = 0; i < n; ++i) {
+            v[i] = kernel(x, x_[i]);
+            mean += v[i] * alpha_[i];
+        }
+        // v = L^-1 k; var = s2 - |v|^2 + (1 - u.v)^2 / (1' K^-1 1), u = L^-1 1
+        double vv = 0.0, uv = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            double s = v[i];
+            const double* row = &chol_[i * n];
+            for (std::size_t k = 0; k < i; ++k) s -= row[k] * v[k];
+            v[i] = s / row[i];
+            vv += v[i] * v[i];
+            uv += u_[i] * v[i];
+        }
+        const double var = sigma2_ - vv + (1.0 - uv) * (1.0 - uv) / one_kinv_one_;
+        KrigingPrediction p;
+        p.mean = y_shift_ + y_scale_ * mean;
+        p.sd = y_scale_ * std::sqrt(std::max(0.0, var));
+        return p;
+    }
+
+    /// Leave-one-out predictions of the fitted points: the mean at each one
+    /// from all the others (hyperparameters and trend kept fixed).
+    std::vector<double> loo_predictions() const {
+        const std::size_t n = x_.size();
+        // y_i - alpha_i / (K^-1)_ii, with diag(K^-1) from L^-1 column by column
+        std::vector<double> out(n);
+        std::vector<double> e(n);
+        for (std::size_t j = 0; j < n; ++j) {
+            std::fill(e.begin(), e.end(), 0.0);
+            e[j] = 1.0;
+            double diag = 0.0;
+            for (std::size_t i = j; i < n; ++i) {
+                double s = e[i];
+                const double* row = &chol_[i * n];
+                for (std::size_t k = j; k < i; ++k) s -= row[k] * e[k];
+                e[i] = s / row[i];
+                diag += e[i] * e[i];
+            }
+            out[j] = y_shift_ + y_scale_ * (y_[j] - alpha_[j] / diag);
+        }
+        return out;
+    }
+
+    /// Root mean square of the leave-one-out errors, in response units.
+    double loo_rmse() const {
+        const std::vector<double> loo = loo_predictions();
+        double ss = 0.0;
+        for (std::size_t i = 0; i < loo.size(); ++i) {
+            const double e = loo[i] - (y_shift_ + y_scale_ * y_[i]);
+            ss += e * e;
+        }
+        return std::sqrt(ss / static_cast<double>(loo.size()));
+    }
+
+    std::size_t size() const { return x_.size(); }
+    std::size_t dims() const { return d_; }
+    double length_scale(std::size_t k) const { return length_[k]; }
+    double process_sd() const { return y_scale_ * std::sqrt(sigma2_); }
+    double log_likelihood_value() const { return log_likelihood_; }
+
+  private:
+    void set_theta(const std::vector<double>& t) {
+        length_.resize(d_);
+        for (std::size_t k = 0; k < d_; ++k) length_[k] = std::exp(t[k]);
+        sigma2_ = std::exp(t[d_]);
+    }
+
+    double kernel(const std::vector<double>& a, const std::vector<double>& b) const {
+        double r2 = 0.0;
+        for (std::size_t k = 0; k < d_; ++k) {
+            const double z = (a[k] - b[k]) / length_[k];
+            r2 += z * z;
+        }
+        const double r = std::sqrt(5.0 * r2);
+        return sigma2_ * (1.0 + r + r * r / 3.0) * std::exp(-r);
+    }
+
+    // Cholesky factor of K + diag(noise), then alpha = K^-1 (y - beta),
+    // u = L^-1 1 and the GLS trend. False if K is numerically singular.
+    bool factor() {
+        const std::size_t n = x_.size();
+        chol_.assign(n * n, 0.0);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = 0; j <= i; ++j) {
+                double s = kernel(x_[i], x_[j]);
+                if (i == j) s += noise_[i] + kJitter * sigma2_;
+                for (std::size_t k = 0; k < j; ++k) s -= chol_[i * n + k] * chol_[j * n + k];
+                if (i == j) {
+                    if (s <= 0.0) return false;
+                    chol_[i * n + i] = std::sqrt(s);
+                } else {
+                    chol_[i * n + j] = s / chol_[j * n + j];
+                }
+            }
+        }
+        std::vector<double> ones(n, 1.0);
+        u_ = solve_lower(ones);
+        const std::vector<double> w = solve_lower(y_);
+        one_kinv_one_ = 0.0;
+        double one_kinv_y = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            one_kinv_one_ += u_[i] * u_[i];
+            one_kinv_y += u_[i] * w[i];
+        }
+        beta_ = one_kinv_y / one_kinv_one_;
+        std::vector<double> r(n);
+        for (std::size_t i = 0; i < n; ++i) r[i] = w[i] - beta_ * u_[i];   // L^-1 (y - beta)
+        quad_ = 0.0;
+        for (double v : r) quad_ += v * v;
+        alpha_ = solve_upper(r);
+        return true;
+    }
+
+    // Concentrated log likelihood (up to a constant) at the current theta.
+    double log_likelihood() {
+        if (!factor()) return -std::numeric_limits<double>::infinity();
+        const std::size_t n = x_.size();
+        double logdet = 0.0;
+        for (std::size_t i = 0; i < n; ++i) logdet += std::log(chol_[i * n + i]);
+        return -0.5 * quad_ - logdet;
+    }
+
+    std::vector<double> solve_lower(const std::vector<double>& b) const {
+        const std::size_t n = b.size();
+        std::vector<double> x(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            double s = b[i];
+            for (std::size_t k = 0; k < i; ++k) s -= chol_[i * n + k] * x[k];
+            x[i] = s / chol_[i * n + i];
+        }
+        return x;
+    }
+
+    std::vector<double> solve_upper(const std::vector<double>& b) const {   // L' x = b
+        const std::size_t n = b.size();
+        std::vector<double> x(n);
+        for (std::size_t i = n; i-- > 0;) {
+            double s = b[i];
+            for (std::size_t k = i + 1; k < n; ++k) s -= chol_[k * n + i] * x[k];
+            x[i] = s / chol_[i * n + i];
+        }
+        return x;
+    }
+
+    static constexpr double kJitter = 1e-8;
+
+    std::size_t d_ = 0;
+    std::vector<std::vector<double>> x_;
+    std::vector<double> y_;              // standardised
+    std::vector<double> noise_;          // variance of each mean, standardised units
+    double y_shift_ = 0.0;
+    double y_scale_ = 1.0;
+
+    std::vector<double> length_;
+    double sigma2_ = 1.0;
+    double log_likelihood_ = 0.0;
+
+    std::vector<double> chol_;           // row-major lower triangle
+    std::vector<double> alpha_;          // K^-1 (y - beta)
+    std::vector<double> u_;              // L^-1 1
+    double one_kinv_one_ = 1.0;
+    double beta_ = 0.0;
+    double quad_ = 0.0;
+};
+
+} // namespace cesfam
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cesfam {
+
+/// Fixed layout of the live metrics segment (POSIX shared memory), read by
+/// tools/live_monitor.cpp. The header is followed by `doctors` queue lengths
+/// (uint32) and then `doctors` busy flags (uint8).
+///
+/// Every field is a lock-free atomic, written with relaxed stores by the
+/// simulation thread only; `seq` is the seqlock sequence: odd while an event
+/// instant is being executed, even between them. A reader that sees the same
+/// even `seq` before and after copying the fields has a consistent sample.
+struct LiveMetricsHeader {
+    static constexpr std::uint64_t kMagic = 0x4556494c4d465345ULL;   // "ESFMLIVE"
+    static constexpr std::uint32_t kVersion = 1;
+
+    std::uint64_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint32_t doctors = 0;
+    std::atomic<std::uint64_t> seq{0};
+    std::atomic<std::uint32_t> running{0};     // 0 once the writer has stopped
+    std::atomic<std::uint32_t> writer_pid{0};
+    std::atomic<double> time{0.0};             // simulated time of the last event instant
+    std::atomic<std::uint64_t> events{0};      // event instants executed
+    std::atomic<double> events_per_sec{0.0};   // over the last LiveMetrics::kRateWindow instants
+    std::atomic<std::uint64_t> ra{0};          // RA exits so far
+    std::atomic<std::uint64_t> rc{0};          // RC exits so far
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared-memory counters need lock-free 64-bit atomics");
+static_assert(std::atomic<double>::is_always_lock_free, "shared-memory times need lock-free double atomics");
+
+inline std::size_t live_metrics_size(std::uint32_t doctors) {
+    return sizeof(LiveMetricsHeader) + std::size_t(doctors) * (sizeof(std::uint32_t) + sizeof(std::uint8_t));
+}
+
+/// Writer side: creates (or truncates) the segment `name` (e.g. "/cesfam_live")
+/// and removes it when destroyed.
+///
+/// Stepper brackets every event instant with begin()/end(); the atomics that
+/// hold a LiveMetrics (see CesfamConfig::live) store into it inside that
+/// bracket, so each event costs the two sequence stores, the time and event
+/// count, and one or two stores per transition that changes a figure.
+class LiveMetrics {
+  public:
+    static constexpr std::uint64_t kRateWindow = 4096;   // instants between events/s updates
+
+    LiveMetrics(std::string name, int doctors)
+    : name_(std::move(name))
+    , doctors_(static_cast<std::uint32_t>(doctors > 0 ? doctors : 1))
+    , size_(live_metrics_size(doctors_))
+    {
+        const int fd = ::shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot create shared memory segment " + name_);
+        if (::ftruncate(fd, 0) != 0 || ::ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+            ::close(fd);
+            ::shm_unlink(name_.c_str());
+            throw std::runtime_error("Cannot size shared memory segment " + name_);
+        }
+        void* p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            ::shm_unlink(name_.c_str());
+            throw std::runtime_error("Cannot map shared memory segment " + name_);
+        }
+        base_ = static_cast<unsigned char*>(p);
+
+        // Fresh zero pages: construct the header, then publish the magic last.
+        header_ = new (base_) LiveMetricsHeader();
+        queue_ = reinterpret_cast<std::atomic<std::uint32_t>*>(base_ + sizeof(LiveMetricsHeader));
+        busy_ = reinterpret_cast<std::atomic<std::uint8_t>*>(queue_ + doctors_);
+        for (std::uint32_t i = 0; i < doctors_; ++i) {
+            new (&queue_[i]) std::atomic<std::uint32_t>(0);
+            new (&busy_[i]) std::atomic<std::uint8_t>(0);
+        }
+        header_->version = LiveMetricsHeader::kVersion;
+        header_->doctors = doctors_;
+        header_->writer_pid.store(static_cast<std::uint32_t>(::getpid()), std::memory_order_relaxed);
+        header_->running.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = LiveMetricsHeader::kMagic;
+        window_start_ = std::chrono::steady_clock::now();
+    }
+
+    LiveMetrics(const LiveMetrics&) = delete;
+    LiveMetrics& operator=(const LiveMetrics&) = delete;
+
+    ~LiveMetrics() {
+        finish();
+        ::munmap(base_, size_);
+        ::shm_unlink(name_.c_str());
+    }
+
+    const std::string& name() const { return name_; }
+    int doctors() const { return static_cast<int>(doctors_); }
+
+    /// Opens the bracket of an event instant (seq becomes odd).
+    void begin() {
+        header_->seq.store(seq_ + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /// Closes it: records the instant `t` (seq becomes even again).
+    void end(double t) {
+        ++events_;
+        header_->time.store(t, std::memory_order_relaxed);
+        header_->events.store(events_, std::memory_order_relaxed);
+        if (events_ % kRateWindow == 0) update_rate();
+        seq_ += 2;
+        header_->seq.store(seq_, std::memory_order_release);
+    }
+
+    void doctor(int i, std::size_t queue, bool busy) {
+        const auto idx = static_cast<std::uint32_t>(i);
+        if (idx >= doctors_) return;
+        queue_[idx].store(static_cast<std::uint32_t>(queue), std::memory_order_relaxed);
+        busy_[idx].store(busy ? 1 : 0, std::memory_order_relaxed);
+    }
+
+    void add_ra(std::size_t n) { header_->ra.store(ra_ += n, std::memory_order_relaxed); }
+    void add_rc(std::size_t n) { header_->rc.store(rc_ += n, std::memory_order_relaxed); }
+
+    /// Back to zero for another run in the same segment (model reuse).
+    void reset() {
+        begin();
+        events_ = ra_ = rc_ = 0;
+        header_->time.store(0.0, std::memory_order_relaxed);
+        header_->events.store(0, std::memory_order_relaxed);
+        header_->events_per_sec.store(0.0, std::memory_order_relaxed);
+        header_->ra.store(0, std::memory_order_relaxed);
+        header_->rc.store(0, std::memory_order_relaxed);
+        for (std::uint32_t i = 0; i < doctors_; ++i) doctor(static_cast<int>(i), 0, false);
+        header_->running.store(1, std::memory_order_relaxed);
+        window_start_ = std::chrono::steady_clock::now();
+        window_events_ = 0;
+        seq_ += 2;
+        header_->seq.store(seq_, std::memory_order_release);
+    }
+
+    /// Marks the run as over (monitors stop polling); the segment stays
+    /// readable until destruction.
+    void finish() {
+        begin();
+        update_rate();
+        header_->running.store(0, std::memory_order_relaxed);
+        seq_ += 2;
+        header_->seq.store(seq_, std::memory_order_release);
+    }
+
+  private:
+    void update_rate() {
+        const auto now = std::chrono::steady_clock::now();
+        const double s = std::chrono::duration<double>(now - window_start_).count();
+        if (s > 0.0 && events_ > window_events_) {
+            header_->events_per_sec.store(static_cast<double>(events_ - window_events_) / s, std::memory_order_relaxed);
+        }
+        window_start_ = now;
+        window_events_ = events_;
+    }
+
+    std::string name_;
+    std::uint32_t doctors_;
+    std::size_t size_;
+    unsigned char* base_ = nullptr;
+    LiveMetricsHeader* header_ = nullptr;
+    std::atomic<std::uint32_t>* queue_ = nullptr;
+    std::atomic<std::uint8_t>* busy_ = nullptr;
+
+    // writer-side copies: the segment is only ever stored to
+    std::uint64_t seq_ = 0;
+    std::uint64_t events_ = 0;
+    std::uint64_t ra_ = 0;
+    std::uint64_t rc_ = 0;
+    std::chrono::steady_clock::time_point window_start_;
+    std::uint64_t window_events_ = 0;
+};
+
+/// One consistent copy of the segment.
+struct LiveSample {
+    bool running = false;
+    std::uint32_t writer_pid = 0;
+    double time = 0.0;
+    std::uint64_t events = 0;
+    double events_per_sec = 0.0;
+    std::uint64_t ra = 0;
+    std::uint64_t rc = 0;
+    std::vector<std::uint32_t> queue;
+    std::vector<std::uint8_t> busy;
+};
+
+/// Reader side: maps an existing segment read-only. Never blocks the writer.
+class LiveMetricsReader {
+  public:
+    explicit LiveMetricsReader(const std::string& name) {
+        const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) throw std::runtime_error("No live metrics segment " + name);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(LiveMetricsHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Live metrics segment " + name + " is not initialized");
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("Cannot map live metrics segment " + name);
+        base_ = static_cast<const unsigned char*>(p);
+        header_ = reinterpret_cast<const LiveMetricsHeader*>(base_);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header_->magic != LiveMetricsHeader::kMagic || header_->version != LiveMetricsHeader::kVersion
+            || size_ < live_metrics_size(header_->doctors)) {
+            ::munmap(const_cast<unsigned char*>(base_), size_);
+            throw std::runtime_error("Live metrics segment " + name + " has an unknown layout");
+        }
+        doctors_ = header_->doctors;
+        queue_ = reinterpret_cast<const std::atomic<std::uint32_t>*>(base_ + sizeof(LiveMetricsHeader));
+        busy_ = reinterpret_cast<const std::atomic<std::uint8_t>*>(queue_ + doctors_);
+    }
+
+    LiveMetricsReader(const LiveMetricsReader&) = delete;
+    LiveMetricsReader& operator=(const LiveMetricsReader&) = delete;
+
+    ~LiveMetricsReader() { ::munmap(const_cast<unsigned char*>(base_), size_); }
+
+    int doctors() const { return static_cast<int>(doctors_); }
+
+    /// Copies a consistent sample, retrying while the writer is inside an
+    /// event instant. Returns false if none was obtained in `attempts` tries.
+    bool read(LiveSample& s, int attempts = 1000) const {
+        s.queue.resize(doctors_);
+        s.busy.resize(doctors_);
+        for (int a = 0; a < attempts; ++a) {
+            const std::uint64_t s0 = header_->seq.load(std::memory_order_acquire);
+            if (s0 & 1) continue;
+            s.running = header_->running.load(std::memory_order_relaxed) != 0;
+            s.writer_pid = header_->writer_pid.load(std::memory_order_relaxed);
+            s.time = header_->time.load(std::memory_order_relaxed);
+            s.events = header_->events.load(std::memory_order_relaxed);
+            s.events_per_sec = header_->events_per_sec.load(std::memory_order_relaxed);
+            s.ra = header_->ra.load(std::memory_order_relaxed);
+            s.rc = header_->rc.load(std::memory_order_relaxed);
+            for (std::uint32_t i = 0; i < doctors_; ++i) {
+                s.queue[i] = queue_[i].load(std::memory_order_relaxed);
+                s.busy[i] = busy_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header_->seq.load(std::memory_order_relaxed) == s0) return true;
+        }
+        return false;
+    }
+
+  private:
+    const unsigned char* base_ = nullptr;
+    std::size_t size_ = 0;
+    const LiveMetricsHeader* header_ = nullptr;
+    std::uint32_t doctors_ = 0;
+    const std::atomic<std::uint32_t>* queue_ = nullptr;
+    const std::atomic<std::uint8_t>* busy_ = nullptr;
+};
+
+} // namespace cesfam
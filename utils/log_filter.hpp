@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/cadmium_includes.hpp"
+#include "utils/ini_reader.hpp"
+#include "data_structures/patient.hpp"
+
+#if __has_include(<cadmium/core/logger/logger.hpp>)
+  #include <cadmium/core/logger/logger.hpp>
+#elif __has_include(<cadmium/simulation/logger/logger.hpp>)
+  #include <cadmium/simulation/logger/logger.hpp>
+#else
+  #error "Cadmium v2 logger header not found. Check CADMIUM_V2_INCLUDE points to .../cadmium_v2/include"
+#endif
+
+namespace cesfam {
+
+// ---------------------------------------------------------------------------
+// Log filtering.
+//
+// Cadmium asks every atomic for logState() and every output port for
+// logMessage(i) and hands the strings to the logger, so a filter in the
+// logger alone would still pay for operator<< on every record. Instead the
+// decision is taken by the model itself: AtomicModel returns an empty state
+// and LoggedPort an empty message when filtered out (before formatting), and
+// FilteredCSVLogger drops empty records.
+// ---------------------------------------------------------------------------
+
+/// `log.*` keys of params.ini.
+struct LogSpec {
+    std::vector<std::string> models;   // glob patterns on the atomic id; empty = every model
+    std::vector<std::string> ports;    // glob patterns on the output port id; empty = every port
+    bool states = true;                // log state records of the selected models
+    double sample = 1.0;               // fraction of patients whose messages are logged
+
+    bool active() const { return !models.empty() || !ports.empty() || !states || sample < 1.0; }
+};
+
+inline std::vector<std::string> split_patterns(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim_copy(item);
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+inline LogSpec load_log_spec(const std::unordered_map<std::string, std::string>& kv) {
+    LogSpec spec;
+    spec.models = split_patterns(get_string(kv, "log.models", ""));
+    spec.ports = split_patterns(get_string(kv, "log.ports", ""));
+    spec.states = get_bool(kv, "log.states", true);
+    spec.sample = get_double(kv, "log.sample", 1.0);
+    return spec;
+}
+
+/// Shell-style match supporting '*' and '?'.
+inline bool glob_match(const std::string& pattern, const std::string& s) {
+    std::size_t p = 0, i = 0, star = std::string::npos, mark = 0;
+    while (i < s.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == s[i])) {
+            ++p;
+            ++i;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            mark = i;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            i = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+inline bool matches_any(const std::vector<std::string>& patterns, const std::string& s) {
+    if (patterns.empty()) return true;
+    for (const auto& p : patterns) {
+        if (glob_match(p, s)) return true;
+    }
+    return false;
+}
+
+/// Implemented by AtomicModel: whether logState() formats the state.
+class StateLogControl {
+  public:
+    virtual ~StateLogControl() = default;
+    void set_state_logged(bool on) { state_logged_ = on; }
+    bool state_logged() const { return state_logged_; }
+
+  protected:
+    bool state_logged_ = true;
+};
+
+/// Implemented by LoggedPort: whether (and for which patients) logMessage()
+/// formats the message.
+class PortLogControl {
+  public:
+    virtual ~PortLogControl() = default;
+    void set_logged(bool on) { logged_ = on; }
+    void set_sample(double rate) { sample_ = rate; }
+
+  protected:
+    // Deterministic keep/drop per key, so a sampled patient is traced on
+    // every port of every model.
+    bool keep(std::uint64_t key) const {
+        if (sample_ >= 1.0) return true;
+        if (sample_ <= 0.0) return false;
+        std::uint64_t z = key + 0x9E3779B97F4A7C15ULL;   // splitmix64 finalizer
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return static_cast<double>(z >> 11) * 0x1.0p-53 < sample_;
+    }
+
+    bool logged_ = true;
+    double sample_ = 1.0;
+};
+
+template <typename T>
+class LoggedPort : public cadmium::_Port<T>, public PortLogControl {
+  public:
+    using cadmium::_Port<T>::_Port;
+
+    std::string logMessage(std::size_t i) const override {
+        if (!logged_) return {};
+        if (sample_ < 1.0) {
+            if constexpr (std::is_same_v<T, Patient>) {
+                if (!keep(static_cast<std::uint64_t>(this->getBag()[i].id_paciente))) return {};
+            } else {
+                if (!keep(seen_++)) return {};
+            }
+        }
+        return cadmium::_Port<T>::logMessage(i);
+    }
+
+  private:
+    mutable std::uint64_t seen_ = 0;
+};
+
+// Coupled::getComponents() is a vector in some Cadmium v2 versions and a map
+// (id -> component) in others.
+inline const std::shared_ptr<cadmium::Component>& component_of(const std::shared_ptr<cadmium::Component>& c) { return c; }
+template <class K>
+inline const std::shared_ptr<cadmium::Component>& component_of(const std::pair<const K, std::shared_ptr<cadmium::Component>>& e) { return e.second; }
+
+/// Applies `spec` to every atomic (and its output ports) below `model`.
+inline void apply_log_filter(cadmium::Component& model, const LogSpec& spec) {
+    if (auto* coupled = dynamic_cast<cadmium::Coupled*>(&model)) {
+        for (const auto& entry : coupled->getComponents()) apply_log_filter(*component_of(entry), spec);
+        return;
+    }
+
+    const bool selected = matches_any(spec.models, model.getId());
+    if (auto* atomic = dynamic_cast<StateLogControl*>(&model)) {
+        atomic->set_state_logged(selected && spec.states);
+    }
+    for (const auto& port : model.getOutPorts()) {
+        if (auto* ctl = dynamic_cast<PortLogControl*>(port.get())) {
+            ctl->set_logged(selected && matches_any(spec.ports, port->getId()));
+            ctl->set_sample(spec.sample);
+        }
+    }
+}
+
+/// Same format as cadmium::CSVLogger, but skips the records the models left
+/// empty and doesn't flush on every line.
+class FilteredCSVLogger : public cadmium::Logger {
+  public:
+    FilteredCSVLogger(std::string filepath, std::string sep)
+    : cadmium::Logger()
+    , path_(std::move(filepath))
+    , sep_(std::move(sep))
+    {}
+
+    void start() override {
+        file_.open(path_);
+        file_ << "time" << sep_ << "model_id" << sep_ << "model_name" << sep_ << "port_name" << sep_ << "data\n";
+    }
+
+    void stop() override { file_.close(); }
+
+    void logOutput(double time, long modelId, const std::string& modelName, const std::string& portName,
+                   const std::string& output) override {
+        if (output.empty()) return;
+        file_ << time << sep_ << modelId << sep_ << modelName << sep_ << portName << sep_ << output << '\n';
+    }
+
+    void logState(double time, long modelId, const std::string& modelName, const std::string& state) override {
+        if (state.empty()) return;
+        file_ << time << sep_ << modelId << sep_ << modelName << sep_ << sep_ << state << '\n';
+    }
+
+  private:
+    std::string path_;
+    std::string sep_;
+    std::ofstream file_;
+};
+
+} // namespace cesfam
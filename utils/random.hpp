@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+namespace cesfam {
+
+#ifndef CESFAM_RNG_BLOCK
+#define CESFAM_RNG_BLOCK 256
+#endif
+
+namespace detail {
+
+inline std::uint64_t splitmix64(std::uint64_t& x) {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+inline std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+inline double bits_to_double(std::uint64_t b) {
+    double d;
+    std::memcpy(&d, &b, sizeof d);
+    return d;
+}
+
+inline std::uint64_t double_to_bits(double d) {
+    std::uint64_t b;
+    std::memcpy(&b, &d, sizeof b);
+    return b;
+}
+
+/// Natural log of x in (0, 1], branch-free so the block loops vectorize
+/// (fdlibm's reduction to [sqrt(2)/2, sqrt(2)) and its degree-14 minimax
+/// polynomial, < 1 ulp).
+inline double log_unit(double x) {
+    constexpr double Lg1 = 6.666666666666735130e-01;
+    constexpr double Lg2 = 3.999999999940941908e-01;
+    constexpr double Lg3 = 2.857142874366239149e-01;
+    constexpr double Lg4 = 2.222219843214978396e-01;
+    constexpr double Lg5 = 1.818357216161805012e-01;
+    constexpr double Lg6 = 1.531383769920937332e-01;
+    constexpr double Lg7 = 1.479819860511658591e-01;
+    constexpr double ln2_hi = 6.93147180369123816490e-01;
+    constexpr double ln2_lo = 1.90821492927058770002e-10;
+
+    // Reduction with 64-bit adds and shifts only (SSE2 has no 64-bit compare
+    // or int -> double conversion): x = m 2^k with m in [sqrt(2)/2, sqrt(2)).
+    // `hi` is the carry of mantissa + (2^52 - mantissa of sqrt(2)).
+    const std::uint64_t bits = double_to_bits(x);
+    const std::uint64_t mant = bits & 0x000fffffffffffffULL;
+    const std::uint64_t hi = (mant + (0x0010000000000000ULL - 0x6a09e667f3bcdULL)) >> 52;
+    const double m = bits_to_double(mant | ((0x3ffULL - hi) << 52));
+    const double k = bits_to_double(((bits >> 52) + hi) | 0x4330000000000000ULL) - (4503599627370496.0 + 1023.0);
+
+    const double f = m - 1.0;
+    const double hfsq = 0.5 * f * f;
+    const double s = f / (2.0 + f);
+    const double z = s * s;
+    const double w = z * z;
+    const double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    const double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    const double r = t1 + t2;
+    return k * ln2_hi - ((hfsq - (s * (hfsq + r) + k * ln2_lo)) - f);
+}
+
+} // namespace detail
+
+/// Block random number generator: four interleaved xoshiro256++ streams
+/// refill a buffer of uniforms and a buffer of standard exponentials
+/// `Block` values at a time, with straight-line loops the compiler
+/// can vectorize (the exponential transform uses detail::log_unit, not a libm
+/// call). Consumers then take one value per draw from the buffer.
+///
+/// The sequence depends only on the seed (the four streams are seeded with
+/// splitmix64, as the xoshiro authors recommend). Uniforms have 52 random
+/// bits, in [0, 1).
+template <std::size_t Block>
+class BasicBlockRng {
+  public:
+    static constexpr std::size_t kBlock = Block;
+    static constexpr std::size_t kLanes = 4;
+    static_assert(kBlock % kLanes == 0, "the block size must be a multiple of 4");
+
+    BasicBlockRng() { seed(5489u); }
+    explicit BasicBlockRng(std::uint64_t s) { seed(s); }
+
+    void seed(std::uint64_t s) {
+        std::uint64_t x = s;
+        for (std::size_t l = 0; l < kLanes; ++l) {
+            s0_[l] = detail::splitmix64(x);
+            s1_[l] = detail::splitmix64(x);
+            s2_[l] = detail::splitmix64(x);
+            s3_[l] = detail::splitmix64(x);
+        }
+        uniform_pos_ = kBlock;
+        exp_pos_ = kBlock;
+    }
+
+    /// Uniform in [0, 1).
+    double uniform() {
+        if (uniform_pos_ == kBlock) {
+            fill_uniform(uniform_.data());
+            uniform_pos_ = 0;
+        }
+        return uniform_[uniform_pos_++];
+    }
+
+    /// Exponential with mean 1.
+    double exponential() {
+        if (exp_pos_ == kBlock) {
+            fill_uniform(exp_.data());
+            for (std::size_t i = 0; i < kBlock; ++i) exp_[i] = -detail::log_unit(1.0 - exp_[i]);   // 1 - u in (0, 1]
+            exp_pos_ = 0;
+        }
+        return exp_[exp_pos_++];
+    }
+
+  private:
+    void fill_uniform(double* out) {
+        // lanes in locals so each statement becomes one vector operation
+        std::uint64_t a[kLanes], b[kLanes], c[kLanes], d[kLanes];
+        for (std::size_t l = 0; l < kLanes; ++l) {
+            a[l] = s0_[l];
+            b[l] = s1_[l];
+            c[l] = s2_[l];
+            d[l] = s3_[l];
+        }
+        for (std::size_t i = 0; i < kBlock; i += kLanes) {
+            for (std::size_t l = 0; l < kLanes; ++l) {
+                const std::uint64_t r = detail::rotl(a[l] + d[l], 23) + a[l];
+                const std::uint64_t t = b[l] << 17;
+                c[l] ^= a[l];
+                d[l] ^= b[l];
+                b[l] ^= c[l];
+                a[l] ^= d[l];
+                c[l] ^= t;
+                d[l] = detail::rotl(d[l], 45);
+                // 52 high bits as the mantissa of a double in [1, 2)
+                out[i + l] = detail::bits_to_double((r >> 12) | 0x3ff0000000000000ULL) - 1.0;
+            }
+        }
+        for (std::size_t l = 0; l < kLanes; ++l) {
+            s0_[l] = a[l];
+            s1_[l] = b[l];
+            s2_[l] = c[l];
+            s3_[l] = d[l];
+        }
+    }
+
+    // lane state, word-major (s0_[l] .. s3_[l] is lane l)
+    alignas(32) std::array<std::uint64_t, kLanes> s0_{}, s1_{}, s2_{}, s3_{};
+    alignas(32) std::array<double, kBlock> uniform_{};
+    alignas(32) std::array<double, kBlock> exp_{};
+    std::size_t uniform_pos_ = kBlock;
+    std::size_t exp_pos_ = kBlock;
+};
+
+/// Buffers of CESFAM_RNG_BLOCK values (256 by default: the two buffers take
+/// about as much memory as a std::mt19937, which matters for the snapshots).
+using BlockRng = BasicBlockRng<CESFAM_RNG_BLOCK>;
+
+/// Generator held by every atomic state. The default is std::mt19937 (the
+/// streams behind all published results); building with CESFAM_BLOCK_RNG
+/// (make BLOCK_RNG=1) switches every model to BlockRng. Each choice is
+/// reproducible for a given seed, but they give different streams.
+#if defined(CESFAM_BLOCK_RNG)
+using Rng = BlockRng;
+
+inline double draw_uniform(Rng& rng) { return rng.uniform(); }
+inline double draw_uniform(Rng& rng, double a, double b) { return a + (b - a) * rng.uniform(); }
+inline double draw_exponential(Rng& rng, double rate) { return rng.exponential() / rate; }
+#else
+using Rng = std::mt19937;
+
+inline double draw_uniform(Rng& rng) { return std::uniform_real_distribution<double>(0.0, 1.0)(rng); }
+inline double draw_uniform(Rng& rng, double a, double b) { return std::uniform_real_distribution<double>(a, b)(rng); }
+inline double draw_exponential(Rng& rng, double rate) { return std::exponential_distribution<double>(rate)(rng); }
+#endif
+
+} // namespace cesfam
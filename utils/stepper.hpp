@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "utils/cadmium_includes.hpp"
+#include "utils/live_metrics.hpp"
+
+// Cadmium v2 coordinator: same two include layouts as the root coordinator.
+#if __has_include(<cadmium/core/simulation/coordinator.hpp>)
+  #include <cadmium/core/simulation/coordinator.hpp>
+#elif __has_include(<cadmium/simulation/core/coordinator.hpp>)
+  #include <cadmium/simulation/core/coordinator.hpp>
+#else
+  #error "Cadmium v2 coordinator header not found. Check CADMIUM_V2_INCLUDE points to .../cadmium_v2/include"
+#endif
+
+namespace cesfam {
+
+/// Drives a top-level coupled model step by step.
+///
+/// RootCoordinator only knows how to run "for an interval"; partitioned and
+/// interactive runs need to stop at an exact absolute time and to feed messages
+/// into the top model's input ports from outside. Stepper does both by driving
+/// the top cadmium::Coordinator directly (same collection/transition/clear
+/// sequence RootCoordinator uses).
+class Stepper {
+  public:
+    explicit Stepper(std::shared_ptr<cadmium::Coupled> model, double t0 = 0.0)
+    : model_(std::move(model))
+    , coordinator_(std::make_shared<cadmium::Coordinator>(model_, t0))
+    , now_(t0)
+    {
+        coordinator_->setModelId(0);
+    }
+
+    void start() {
+        if (logger_) logger_->start();
+        coordinator_->start(now_);
+    }
+
+    /// Rewinds to `t0` (dropping pending injections) so that start() can run
+    /// the model again after its atomics were reset.
+    void reset(double t0 = 0.0) {
+        injections_.clear();
+        now_ = t0;
+        steps_ = 0;
+    }
+    void stop() {
+        coordinator_->stop(now_);
+        if (logger_) logger_->stop();
+    }
+
+    /// Same as RootCoordinator::setLogger: every atomic logs its outputs and
+    /// states to `logger`, started and stopped with the run.
+    void setLogger(const std::shared_ptr<cadmium::Logger>& logger) {
+        logger_ = logger;
+        coordinator_->setLogger(logger);
+    }
+
+    /// Absolute time up to which the model has been simulated.
+    double now() const { return now_; }
+
+    /// Brackets every step with live->begin()/end(t), so the figures the
+    /// atomics store during it are published together (nullptr = none).
+    void set_live(LiveMetrics* live) { live_ = live; }
+
+    /// Number of simulation steps (distinct event instants) executed so far.
+    std::size_t steps() const { return steps_; }
+
+    /// Time of the next event, including scheduled injections.
+    double time_next() const {
+        double t = coordinator_->getTimeNext();
+        if (!injections_.empty()) t = std::min(t, injections_.begin()->first);
+        return t;
+    }
+
+    /// Schedules `msg` to appear on the top model input port `port` at absolute
+    /// time `t`. `t` must not be earlier than now().
+    template <typename T>
+    void inject(const cadmium::Port<T>& port, T msg, double t) {
+        if (t < now_) throw std::logic_error("Stepper::inject: message scheduled in the past");
+        injections_.emplace(t, [port, m = std::move(msg)]() { port->addMessage(m); });
+    }
+
+    /// Executes every event with time strictly lower than `t_end` (the same
+    /// convention as RootCoordinator::simulate) and leaves now() at t_end.
+    std::size_t advance_until(double t_end) {
+        const std::size_t before = steps_;
+        for (double t = time_next(); t < t_end; t = time_next()) {
+            step(t);
+        }
+        if (t_end > now_) now_ = t_end;
+        return steps_ - before;
+    }
+
+    /// Executes exactly one event instant (if any). Returns false when idle.
+    bool advance_one() {
+        const double t = time_next();
+        if (t == std::numeric_limits<double>::infinity()) return false;
+        step(t);
+        return true;
+    }
+
+    const std::shared_ptr<cadmium::Coupled>& model() const { return model_; }
+
+  private:
+    void step(double t) {
+        auto last = injections_.upper_bound(t);
+        for (auto it = injections_.begin(); it != last; ++it) it->second();
+        injections_.erase(injections_.begin(), last);
+
+        if (live_) live_->begin();
+        if (logger_) {
+            logger_->lock();
+            logger_->logTime(t);
+            logger_->unlock();
+        }
+        coordinator_->collection(t);
+        coordinator_->transition(t);
+        coordinator_->clear();
+        if (live_) live_->end(t);
+
+        now_ = t;
+        ++steps_;
+    }
+
+    std::shared_ptr<cadmium::Coupled> model_;
+    std::shared_ptr<cadmium::Coordinator> coordinator_;
+    std::multimap<double, std::function<void()>> injections_;
+    std::shared_ptr<cadmium::Logger> logger_;
+    double now_ = 0.0;
+    std::size_t steps_ = 0;
+    LiveMetrics* live_ = nullptr;
+};
+
+} // namespace cesfam
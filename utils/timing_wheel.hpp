@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace cesfam {
+
+/// Hierarchical timing wheel (Varghese & Lauck) for many deadlines with O(1)
+/// insertion and cancellation.
+///
+/// Time is quantized in ticks of `tick` seconds and a deadline fires at the
+/// first tick boundary at or after it. Four levels of 256 slots cover 2^32
+/// ticks; a timer sits in the level of the highest 8-bit block in which its
+/// tick differs from the current one, and is moved down (cascaded) when the
+/// wheel reaches the start of its slot. next_wakeup() tells the owning model
+/// when to call advance(): either an exact expiry (level 0) or a cascade.
+///
+/// Timers are nodes of a pool linked by index, so the wheel is a regular
+/// value: copying a model state copies its pending timers.
+class TimingWheel {
+  public:
+    using Handle = std::uint64_t;
+    static constexpr Handle kNone = ~Handle{0};
+
+    explicit TimingWheel(double tick = 1.0)
+    : tick_(tick > 0.0 ? tick : 1.0)
+    {}
+
+    double tick() const { return tick_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /// Schedules `key` to fire at `deadline` (absolute seconds, rounded up to
+    /// a tick; never earlier than the tick after the current one).
+    Handle schedule(double deadline, std::uint64_t key) {
+        if (slots_.empty()) {
+            slots_.assign(kLevels * kSlots, kNil);
+            bitmap_.fill(0);
+        }
+        double d = std::ceil(deadline / tick_);
+        if (!(d < kMaxTick)) d = kMaxTick;
+        const std::uint64_t t = std::max(static_cast<std::uint64_t>(std::max(d, 0.0)), now_ + 1);
+
+        std::uint32_t idx;
+        if (free_ != kNil) {
+            idx = free_;
+            free_ = nodes_[idx].next;
+        } else {
+            idx = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.push_back({});
+        }
+        Node& n = nodes_[idx];
+        n.tick = t;
+        n.key = key;
+        n.live = true;
+        link(idx);
+        ++size_;
+        return static_cast<Handle>(n.gen) << 32 | idx;
+    }
+
+    /// Removes a pending timer. Returns false if it already fired or was
+    /// cancelled.
+    bool cancel(Handle h) {
+        if (h == kNone) return false;
+        const std::uint32_t idx = static_cast<std::uint32_t>(h);
+        if (idx >= nodes_.size()) return false;
+        Node& n = nodes_[idx];
+        if (!n.live || n.gen != static_cast<std::uint32_t>(h >> 32)) return false;
+        unlink(idx);
+        release(idx);
+        return true;
+    }
+
+    /// Absolute time at which advance() has work to do (an expiry or a
+    /// cascade); infinity if there are no timers.
+    double next_wakeup() const {
+        if (size_ == 0) return std::numeric_limits<double>::infinity();
+        return static_cast<double>(next_tick()) * tick_;
+    }
+
+    /// Moves the wheel to time `t` and calls on_expire(key) for every timer
+    /// whose tick is <= floor(t / tick), in tick order.
+    template <typename F>
+    void advance(double t, F&& on_expire) {
+        double target_d = std::floor(t / tick_);
+        // k * tick / tick may round below k: next_wakeup() must be reachable
+        if ((target_d + 1.0) * tick_ <= t) target_d += 1.0;
+        if (!(target_d > static_cast<double>(now_))) return;
+        const std::uint64_t target = target_d < kMaxTick ? static_cast<std::uint64_t>(target_d)
+                                                         : static_cast<std::uint64_t>(kMaxTick);
+        while (now_ < target) {
+            now_ = size_ == 0 ? target : std::min(target, next_tick());
+            if (size_ == 0) break;
+
+            // cascade the slots that start at now_, top level first
+            for (int l = kLevels - 1; l >= 1; --l) {
+                const std::size_t s = slot_index(now_, l);
+                if (!test(l, s)) continue;
+                std::uint32_t i = take_slot(l, s);
+                while (i != kNil) {
+                    const std::uint32_t nx = nodes_[i].next;
+                    link(i);
+                    i = nx;
+                }
+            }
+
+            const std::size_t s0 = slot_index(now_, 0);
+            if (!test(0, s0)) continue;
+            std::uint32_t i = take_slot(0, s0);
+            while (i != kNil) {
+                const std::uint32_t nx = nodes_[i].next;
+                const std::uint64_t key = nodes_[i].key;
+                release(i);
+                on_expire(key);
+                i = nx;
+            }
+        }
+    }
+
+  private:
+    static constexpr int kLevels = 4;
+    static constexpr int kBits = 8;
+    static constexpr std::size_t kSlots = std::size_t{1} << kBits;
+    static constexpr std::uint32_t kNil = ~std::uint32_t{0};
+    static constexpr double kMaxTick = 4294967295.0;   // 2^32 - 1
+
+    struct Node {
+        std::uint64_t tick = 0;
+        std::uint64_t key = 0;
+        std::uint32_t prev = kNil;
+        std::uint32_t next = kNil;
+        std::uint32_t gen = 0;
+        std::uint16_t slot = 0;        // level * kSlots + slot index
+        bool live = false;
+    };
+
+    static std::size_t slot_index(std::uint64_t tick, int level) {
+        return static_cast<std::size_t>(tick >> (kBits * level)) & (kSlots - 1);
+    }
+
+    // Level of a tick relative to now_: the highest block in which they differ.
+    int level_of(std::uint64_t tick) const {
+        for (int l = kLevels - 1; l >= 1; --l) {
+            if ((tick >> (kBits * l)) != (now_ >> (kBits * l))) return l;
+        }
+        return 0;
+    }
+
+    bool test(int level, std::size_t s) const {
+        const std::size_t b = static_cast<std::size_t>(level) * kSlots + s;
+        return (bitmap_[b / 64] >> (b % 64)) & 1u;
+    }
+
+    void set_bit(std::size_t b, bool on) {
+        if (on) bitmap_[b / 64] |= std::uint64_t{1} << (b % 64);
+        else bitmap_[b / 64] &= ~(std::uint64_t{1} << (b % 64));
+    }
+
+    void link(std::uint32_t idx) {
+        Node& n = nodes_[idx];
+        const int l = level_of(n.tick);
+        const std::size_t b = static_cast<std::size_t>(l) * kSlots + slot_index(n.tick, l);
+        n.slot = static_cast<std::uint16_t>(b);
+        n.prev = kNil;
+        n.next = slots_[b];
+        if (n.next != kNil) nodes_[n.next].prev = idx;
+        slots_[b] = idx;
+        set_bit(b, true);
+    }
+
+    void unlink(std::uint32_t idx) {
+        Node& n = nodes_[idx];
+        if (n.prev != kNil) nodes_[n.prev].next = n.next;
+        else slots_[n.slot] = n.next;
+        if (n.next != kNil) nodes_[n.next].prev = n.prev;
+        if (slots_[n.slot] == kNil) set_bit(n.slot, false);
+    }
+
+    // Detaches a whole slot and returns its first node.
+    std::uint32_t take_slot(int level, std::size_t s) {
+        const std::size_t b = static_cast<std::size_t>(level) * kSlots + s;
+        const std::uint32_t head = slots_[b];
+        slots_[b] = kNil;
+        set_bit(b, false);
+        return head;
+    }
+
+    void release(std::uint32_t idx) {
+        Node& n = nodes_[idx];
+        n.live = false;
+        ++n.gen;
+        n.next = free_;
+        free_ = idx;
+        --size_;
+    }
+
+    // First set bit of `level` strictly after slot `from` (kSlots if none).
+    std::size_t next_set(int level, std::size_t from) const {
+        for (std::size_t s = from + 1; s < kSlots;) {
+            const std::size_t b = static_cast<std::size_t>(level) * kSlots + s;
+            const std::uint64_t w = bitmap_[b / 64] >> (b % 64);
+            if (w) return s + static_cast<std::size_t>(__builtin_ctzll(w));
+            s += 64 - (b % 64);
+        }
+        return kSlots;
+    }
+
+    // Earliest tick with work: level 0 holds exact ticks of the current
+    // 256-tick block; higher levels hold later blocks and wake up at the
+    // start of their first non-empty slot.
+    std::uint64_t next_tick() const {
+        std::uint64_t best = std::numeric_limits<std::uint64_t>::max();
+        for (int l = 0; l < kLevels; ++l) {
+            const std::size_t s = next_set(l, slot_index(now_, l));
+            if (s == kSlots) continue;
+            const int shift = kBits * (l + 1);
+            const std::uint64_t base = shift >= 64 ? 0 : (now_ >> shift) << shift;
+            best = std::min(best, base | (static_cast<std::uint64_t>(s) << (kBits * l)));
+        }
+        return best;
+    }
+
+    double tick_;
+    std::uint64_t now_ = 0;                   // last processed tick
+    std::size_t size_ = 0;
+    std::vector<Node> nodes_;
+    std::uint32_t free_ = kNil;
+    std::vector<std::uint32_t> slots_;        // kLevels * kSlots list heads (allocated on first use)
+    std::array<std::uint64_t, kLevels * kSlots / 64> bitmap_{};
+};
+
+} // namespace cesfam
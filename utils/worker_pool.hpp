@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cesfam {
+
+/// Small persistent thread pool with a blocking parallel_for.
+///
+/// Workers are created once and reused for every call, so it is cheap enough to
+/// call parallel_for once per synchronization window. The calling thread also
+/// takes work, hence WorkerPool(1) runs everything inline.
+class WorkerPool {
+  public:
+    explicit WorkerPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        for (unsigned i = 1; i < threads; ++i) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopping_ = true;
+        }
+        cv_start_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    /// Calls fn(i) for every i in [0, n) and returns when all calls finished.
+    /// The first exception thrown by any call is rethrown here.
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn) {
+        if (n == 0) return;
+        if (workers_.empty() || n == 1) {
+            for (std::size_t i = 0; i < n; ++i) fn(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            job_ = &fn;
+            job_size_ = n;
+            next_.store(0);
+            pending_ = workers_.size();
+            error_ = nullptr;
+            ++generation_;
+        }
+        cv_start_.notify_all();
+
+        run_chunk();
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_done_.wait(lock, [this] { return pending_ == 0; });
+        job_ = nullptr;
+        if (error_) std::rethrow_exception(error_);
+    }
+
+  private:
+    void worker_loop() {
+        std::size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cv_start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if (stopping_) return;
+                seen = generation_;
+            }
+            run_chunk();
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (--pending_ == 0) cv_done_.notify_one();
+            }
+        }
+    }
+
+    void run_chunk() {
+        for (;;) {
+            const std::size_t i = next_.fetch_add(1);
+            if (i >= job_size_) return;
+            try {
+                (*job_)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(err_mtx_);
+                if (!error_) error_ = std::current_exception();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mtx_;
+    std::mutex err_mtx_;
+    std::condition_variable cv_start_;
+    std::condition_variable cv_done_;
+
+    const std::function<void(std::size_t)>* job_ = nullptr;
+    std::size_t job_size_ = 0;
+    std::atomic<std::size_t> next_{0};
+    std::size_t pending_ = 0;
+    std::size_t generation_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+} // namespace cesfam